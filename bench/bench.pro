@@ -0,0 +1,78 @@
+QT += core
+
+CONFIG += \
+    c++17 \
+    console
+
+ROOT_DIR = $$PWD/..
+SRC_DIR = $$ROOT_DIR/src
+
+# Record the statistics of the trees with "qmake CONFIG+=stats", which adds overhead to the benchmarks
+stats: DEFINES += JSONCONFIG_STATS
+
+SOURCES += \
+    main.cpp \
+    $$SRC_DIR/configbinding.cpp \
+    $$SRC_DIR/configitem.cpp \
+    $$SRC_DIR/jsonbinary.cpp \
+    $$SRC_DIR/jsonfilewatcher.cpp \
+    $$SRC_DIR/jsonkeypool.cpp \
+    $$SRC_DIR/jsonparallelloader.cpp \
+    $$SRC_DIR/jsonparser.cpp \
+    $$SRC_DIR/jsonpatch.cpp \
+    $$SRC_DIR/jsonpath.cpp \
+    $$SRC_DIR/jsonquery.cpp \
+    $$SRC_DIR/jsonsavequeue.cpp \
+    $$SRC_DIR/jsonsimd.cpp \
+    $$SRC_DIR/jsonsnapshot.cpp \
+    $$SRC_DIR/jsontreearena.cpp \
+    $$SRC_DIR/jsontreeitem.cpp \
+    $$SRC_DIR/jsontreepublisher.cpp \
+    $$SRC_DIR/jsontreestats.cpp \
+    $$SRC_DIR/jsonwriter.cpp
+
+HEADERS += \
+    bench_allocations.h \
+    bench_configbinding.h \
+    bench_generators.h \
+    bench_jsonbinary.h \
+    bench_jsonfilewatcher.h \
+    bench_jsonkeypool.h \
+    bench_jsonparallelloader.h \
+    bench_jsonparser.h \
+    bench_jsonpatch.h \
+    bench_jsonquery.h \
+    bench_jsonsimd.h \
+    bench_jsonsnapshot.h \
+    bench_jsontreearena.h \
+    bench_jsontreeitem.h \
+    bench_jsontreepublisher.h \
+    bench_jsonwriter.h \
+    bench_lazyload.h \
+    bench_loadfromfile.h \
+    bench_shapes.h \
+    $$SRC_DIR/configbinding.h \
+    $$SRC_DIR/configitem.h \
+    $$SRC_DIR/jsonbinary.h \
+    $$SRC_DIR/jsonfilewatcher.h \
+    $$SRC_DIR/jsonkeypool.h \
+    $$SRC_DIR/jsonparallelloader.h \
+    $$SRC_DIR/jsonparser.h \
+    $$SRC_DIR/jsonpatch.h \
+    $$SRC_DIR/jsonpath.h \
+    $$SRC_DIR/jsonquery.h \
+    $$SRC_DIR/jsonsavequeue.h \
+    $$SRC_DIR/jsonsimd.h \
+    $$SRC_DIR/jsonsnapshot.h \
+    $$SRC_DIR/jsontreearena.h \
+    $$SRC_DIR/jsontreeitem.h \
+    $$SRC_DIR/jsontreepublisher.h \
+    $$SRC_DIR/jsontreestats.h \
+    $$SRC_DIR/jsonwriter.h
+
+INCLUDEPATH += \
+    $$SRC_DIR
+
+LIBS += \
+    -lbenchmark \
+    -lpthread
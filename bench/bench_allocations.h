@@ -0,0 +1,34 @@
+#ifndef BENCH_ALLOCATIONS_H
+#define BENCH_ALLOCATIONS_H
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Number of calls of the global operator new and the requested bytes, which are counted by the
+// replacement below
+static std::atomic<qint64> allocationCount(0);
+static std::atomic<qint64> allocationBytes(0);
+
+void *operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(static_cast<qint64>(size), std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#endif // BENCH_ALLOCATIONS_H
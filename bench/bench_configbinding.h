@@ -0,0 +1,75 @@
+#ifndef BENCH_CONFIGBINDING_H
+#define BENCH_CONFIGBINDING_H
+
+#include <QByteArray>
+
+#include <benchmark/benchmark.h>
+#include <configbinding.h>
+
+// Settings of a typical application, which are read many times after loading
+struct BenchSettings
+{
+    bool showHints = true;
+    int recentCount = 10;
+    double zoom = 1.;
+    QString theme;
+    QString language;
+
+    static constexpr auto configFields()
+    {
+        return std::make_tuple(ConfigField("General Settings/Show Hints on Startup", &BenchSettings::showHints),
+                               ConfigField("General Settings/Recent Count", &BenchSettings::recentCount),
+                               ConfigField("View/Zoom", &BenchSettings::zoom),
+                               ConfigField("View/Appearance/Theme", &BenchSettings::theme),
+                               ConfigField("View/Appearance/Language", &BenchSettings::language));
+    }
+};
+
+static const QByteArray benchSettingsJson =
+        "{\"General Settings\": {\"Show Hints on Startup\": false, \"Recent Count\": 5}, "
+        "\"View\": {\"Zoom\": 1.25, \"Appearance\": {\"Theme\": \"dark\", \"Language\": \"de\"}}}";
+
+// Reading the settings through their paths and QVariant conversions on every access
+static void BM_SettingsByPath(benchmark::State &state)
+{
+    ConfigItem config;
+    config.loadFromJson(benchSettingsJson);
+    const ConfigItem &constConfig = config;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(constConfig.value("General Settings", "Show Hints on Startup").toBool());
+        benchmark::DoNotOptimize(constConfig.value("General Settings", "Recent Count").toInt());
+        benchmark::DoNotOptimize(constConfig.value("View", "Zoom").toDouble());
+        benchmark::DoNotOptimize(constConfig.value("View/Appearance", "Theme").toString());
+        benchmark::DoNotOptimize(constConfig.value("View/Appearance", "Language").toString());
+    }
+}
+BENCHMARK(BM_SettingsByPath);
+
+// Loading the bound struct in one pass, after which the settings are plain members
+static void BM_SettingsBindingLoad(benchmark::State &state)
+{
+    ConfigItem config;
+    config.loadFromJson(benchSettingsJson);
+
+    BenchSettings settings;
+    for (auto _ : state) {
+        ConfigBinding<BenchSettings>::load(config, settings);
+        benchmark::DoNotOptimize(settings);
+    }
+}
+BENCHMARK(BM_SettingsBindingLoad);
+
+static void BM_SettingsBindingSave(benchmark::State &state)
+{
+    ConfigItem config;
+    BenchSettings settings;
+
+    for (auto _ : state) {
+        ++settings.recentCount;
+        ConfigBinding<BenchSettings>::save(config, settings);
+    }
+}
+BENCHMARK(BM_SettingsBindingSave);
+
+#endif // BENCH_CONFIGBINDING_H
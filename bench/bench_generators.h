@@ -0,0 +1,188 @@
+#ifndef BENCH_GENERATORS_H
+#define BENCH_GENERATORS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <jsontreeitem.h>
+
+// Generators of synthetic documents for the benchmarks
+// All generators are deterministic, so that the results of different runs and releases can be
+// compared. The documents of a size are approximately that large in bytes.
+
+// Pseudo random numbers with a fixed seed (xorshift), which do not depend on the standard library
+class BenchRandom
+{
+public:
+    explicit BenchRandom(quint64 seed = 0x9e3779b97f4a7c15ull) : m_state(seed) {}
+
+    quint64 next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 7;
+        m_state ^= m_state << 17;
+        return m_state;
+    }
+
+    // Number in the range [0, bound)
+    int bounded(int bound) { return static_cast<int>(next() % static_cast<quint64>(bound)); }
+
+private:
+    quint64 m_state;
+};
+
+// Create a JSON array of records with approximately the specified size in bytes
+static QByteArray recordsJson(qint64 size)
+{
+    QByteArray json = "[\n";
+    for (int i = 0; json.size() < size; ++i) {
+        if (i > 0)
+            json += ",\n";
+        json += "    {\"host\": \"server" + QByteArray::number(i) + ".example.com\", "
+                "\"port\": " + QByteArray::number(1024 + i % 50000) + ", "
+                "\"weight\": " + QByteArray::number(0.25 * (i % 17)) + ", "
+                "\"enabled\": " + (i % 3 ? "true" : "false") + ", "
+                "\"tags\": [\"primary\", \"zone-" + QByteArray::number(i % 8) + "\"]}";
+    }
+    json += "\n]\n";
+    return json;
+}
+
+// Create a JSON object with the specified number of keys
+static QByteArray wideObjectJson(int keyCount)
+{
+    QByteArray json = "{";
+    for (int i = 0; i < keyCount; ++i) {
+        if (i > 0)
+            json += ",";
+        json += "\"key" + QByteArray::number(i) + "\":" + QByteArray::number(i);
+    }
+    json += "}";
+    return json;
+}
+
+// Create an object path with the specified number of levels
+static QString deepObjectPath(int depth)
+{
+    QStringList dirs;
+    for (int i = 0; i < depth; ++i)
+        dirs.push_back("level" + QString::number(i));
+    return dirs.join("/");
+}
+
+// Create an array of objects, which are nested to the specified depth
+static QByteArray deepJson(qint64 size, int depth = 32)
+{
+    QByteArray json = "[";
+    for (int i = 0; json.size() < size; ++i) {
+        if (i > 0)
+            json += ",";
+        for (int level = 0; level < depth; ++level)
+            json += "{\"level" + QByteArray::number(level) + "\": ";
+        json += QByteArray::number(i);
+        json += QByteArray(depth, '}');
+    }
+    json += "]";
+    return json;
+}
+
+// Create an object of string arrays with strings of random length, some of them with escape
+// sequences and non-ASCII characters
+static QByteArray stringsJson(qint64 size)
+{
+    static const char *const words[] = {"alpha", "beta", "gamma", "delta", "Gr\xc3\xbc\xc3\x9f""e",
+                                        "line\\nbreak", "quote\\\"d", "path\\/to", "\\u00e4"};
+    BenchRandom random;
+
+    QByteArray json = "{";
+    for (int i = 0; json.size() < size; ++i) {
+        if (i > 0)
+            json += ",";
+        json += "\"list" + QByteArray::number(i) + "\": [";
+        for (int j = 0; j < 16; ++j) {
+            if (j > 0)
+                json += ", ";
+            json += "\"";
+            const int wordCount = 1 + random.bounded(12);
+            for (int k = 0; k < wordCount; ++k) {
+                if (k > 0)
+                    json += " ";
+                json += words[random.bounded(static_cast<int>(sizeof(words) / sizeof(words[0])))];
+            }
+            json += "\"";
+        }
+        json += "]";
+    }
+    json += "}";
+    return json;
+}
+
+// Create an object of number arrays with random integers and floating point numbers
+static QByteArray numbersJson(qint64 size)
+{
+    BenchRandom random;
+
+    QByteArray json = "{";
+    for (int i = 0; json.size() < size; ++i) {
+        if (i > 0)
+            json += ",";
+        json += "\"table" + QByteArray::number(i) + "\": [";
+        for (int j = 0; j < 64; ++j) {
+            if (j > 0)
+                json += ",";
+            if (j % 2)
+                json += QByteArray::number(random.bounded(2000000) - 1000000);
+            else
+                json += QByteArray::number((random.bounded(2000000) - 1000000) / 997.0, 'g', 17);
+        }
+        json += "]";
+    }
+    json += "}";
+    return json;
+}
+
+// Shapes of the generated documents, which stress different parts of the implementation
+enum BenchShape {
+    // A single object with many keys
+    WideShape,
+    // Objects, which are nested deeply
+    DeepShape,
+    // An array of small objects with the same keys
+    RecordsShape,
+    // Mostly strings
+    StringsShape,
+    // Mostly numbers
+    NumbersShape
+};
+
+static QByteArray shapeJson(BenchShape shape, qint64 size)
+{
+    switch (shape) {
+    case WideShape:
+        // Each key takes about 16 bytes
+        return wideObjectJson(static_cast<int>(size / 16));
+    case DeepShape:
+        return deepJson(size);
+    case RecordsShape:
+        return recordsJson(size);
+    case StringsShape:
+        return stringsJson(size);
+    case NumbersShape:
+        return numbersJson(size);
+    }
+    return QByteArray();
+}
+
+// Fill a tree with a configuration of the specified number of sections of 16 keys each
+// The values are assigned by setValue(), so the nodes stay eligible for incremental saving and
+// for reusing their snapshots.
+static void fillSections(JsonTreeItem *root, int sections)
+{
+    for (int section = 0; section < sections; ++section) {
+        for (int key = 0; key < 16; ++key)
+            root->setValue(QString("Section%1").arg(section), QString("Key%1").arg(key), section * key);
+    }
+}
+
+#endif // BENCH_GENERATORS_H
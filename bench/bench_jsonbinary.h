@@ -0,0 +1,42 @@
+#ifndef BENCH_JSONBINARY_H
+#define BENCH_JSONBINARY_H
+
+#include <QByteArray>
+
+#include <benchmark/benchmark.h>
+#include <jsontreeitem.h>
+
+#include "bench_jsonparser.h"
+
+// Loading a binary snapshot of the same documents as BM_LoadNative
+static void BM_LoadFromBinary(benchmark::State &state)
+{
+    JsonTreeItem source;
+    source.loadFromJson(recordsJson(state.range(0)));
+    const QByteArray binary = source.saveToBinary();
+
+    for (auto _ : state) {
+        JsonTreeItem root;
+        root.loadFromBinary(binary);
+        benchmark::DoNotOptimize(root.type());
+    }
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    state.counters["snapshot_bytes"] = static_cast<double>(binary.size());
+}
+BENCHMARK(BM_LoadFromBinary)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+// Writing the binary snapshot
+static void BM_SaveToBinary(benchmark::State &state)
+{
+    JsonTreeItem root;
+    root.loadFromJson(recordsJson(state.range(0)));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(root.saveToBinary());
+
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SaveToBinary)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_JSONBINARY_H
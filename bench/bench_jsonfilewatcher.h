@@ -0,0 +1,51 @@
+#ifndef BENCH_JSONFILEWATCHER_H
+#define BENCH_JSONFILEWATCHER_H
+
+#include <QByteArray>
+#include <QFile>
+
+#include <benchmark/benchmark.h>
+#include <jsonfilewatcher.h>
+#include <jsontreeitem.h>
+
+#include "bench_jsonparser.h"
+
+// Reloading a file of records, in which a single value alternates, compared with loading it again
+static void BM_ReloadOneChange(benchmark::State &state, bool update)
+{
+    const QString filename = "bench_reload.json";
+    const QByteArray json = recordsJson(state.range(0));
+    QByteArray changed = json;
+    changed.replace("\"port\": 1024,", "\"port\": 1025,");
+
+    auto writeFile = [&filename](const QByteArray &document) {
+        QFile file(filename);
+        if (file.open(QFile::WriteOnly))
+            file.write(document);
+    };
+
+    JsonTreeItem root;
+    JsonFileWatcher watcher(&root, filename);
+    writeFile(json);
+    watcher.reload();
+
+    bool toggle = false;
+    for (auto _ : state) {
+        state.PauseTiming();
+        toggle = !toggle;
+        writeFile(toggle ? changed : json);
+        state.ResumeTiming();
+
+        if (update)
+            watcher.reload();
+        else
+            root.loadFromFile(filename);
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+    QFile::remove(filename);
+}
+BENCHMARK_CAPTURE(BM_ReloadOneChange, load, false)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ReloadOneChange, update, true)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_JSONFILEWATCHER_H
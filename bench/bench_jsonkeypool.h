@@ -0,0 +1,35 @@
+#ifndef BENCH_JSONKEYPOOL_H
+#define BENCH_JSONKEYPOOL_H
+
+#include <QByteArray>
+
+#include <benchmark/benchmark.h>
+#include <jsontreeitem.h>
+
+#include "bench_allocations.h"
+#include "bench_jsonparser.h"
+
+// Load an array of records with or without interned keys, the bytes are those still allocated by
+// the loaded tree
+static void BM_LoadRecordsKeys(benchmark::State &state, bool interned)
+{
+    const QByteArray json = recordsJson(state.range(0));
+
+    qint64 bytes = 0;
+    for (auto _ : state) {
+        JsonTreeItem root;
+        root.setKeyInterningEnabled(interned);
+
+        const qint64 start = allocationBytes.load(std::memory_order_relaxed);
+        root.loadFromJson(json);
+        bytes += allocationBytes.load(std::memory_order_relaxed) - start;
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+    state.counters["bytes"] = benchmark::Counter(static_cast<double>(bytes),
+                                                 benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_LoadRecordsKeys, plain, false)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadRecordsKeys, interned, true)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_JSONKEYPOOL_H
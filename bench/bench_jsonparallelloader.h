@@ -0,0 +1,32 @@
+#ifndef BENCH_JSONPARALLELLOADER_H
+#define BENCH_JSONPARALLELLOADER_H
+
+#include <QByteArray>
+#include <QThreadPool>
+
+#include <benchmark/benchmark.h>
+#include <jsontreeitem.h>
+
+#include "bench_jsonparser.h"
+
+// Load an array of records with the specified number of threads, the time is the wall clock time
+static void BM_LoadParallel(benchmark::State &state)
+{
+    const QByteArray json = recordsJson(64 << 20);
+    const int threads = static_cast<int>(state.range(0));
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int maxThreads = pool->maxThreadCount();
+    pool->setMaxThreadCount(threads);
+
+    for (auto _ : state) {
+        JsonTreeItem root;
+        root.loadFromJson(json, nullptr, JsonTreeItem::Parallel);
+    }
+
+    pool->setMaxThreadCount(maxThreads);
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_LoadParallel)->DenseRange(1, 8)->Arg(16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_JSONPARALLELLOADER_H
@@ -0,0 +1,66 @@
+#ifndef BENCH_JSONPARSER_H
+#define BENCH_JSONPARSER_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+
+#include <benchmark/benchmark.h>
+#include <jsontreeitem.h>
+
+#include "bench_generators.h"
+
+// Import of a QJsonValue through the public API, as the tree was loaded before the native parser
+static void importQJsonValue(JsonTreeItem *item, const QJsonValue &val)
+{
+    if (val.isObject()) {
+        const QJsonObject obj = val.toObject();
+        const QStringList objKeys = obj.keys();
+        item->object();
+        for (const QString &key : objKeys)
+            importQJsonValue(item->itemAt(key), obj[key]);
+    } else if (val.isArray()) {
+        const QJsonArray arr = val.toArray();
+        QVector<JsonTreeItem *> &children = item->array();
+        for (const QJsonValue &element : arr) {
+            JsonTreeItem *child = new JsonTreeItem;
+            importQJsonValue(child, element);
+            children.push_back(child);
+        }
+    } else {
+        item->value() = val.toVariant();
+    }
+}
+
+// Loading through QJsonDocument and a second copy into the tree
+static void BM_LoadQJsonDocument(benchmark::State &state)
+{
+    const QByteArray json = recordsJson(state.range(0));
+
+    for (auto _ : state) {
+        JsonTreeItem root;
+        const QJsonDocument doc = QJsonDocument::fromJson(json);
+        importQJsonValue(&root, QJsonValue(doc.array()));
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_LoadQJsonDocument)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+// Loading with the native single pass parser
+static void BM_LoadNative(benchmark::State &state)
+{
+    const QByteArray json = recordsJson(state.range(0));
+
+    for (auto _ : state) {
+        JsonTreeItem root;
+        root.loadFromJson(json);
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_LoadNative)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_JSONPARSER_H
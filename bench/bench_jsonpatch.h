@@ -0,0 +1,93 @@
+#ifndef BENCH_JSONPATCH_H
+#define BENCH_JSONPATCH_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <benchmark/benchmark.h>
+#include <jsonsnapshot.h>
+#include <jsontreeitem.h>
+
+#include "bench_generators.h"
+
+// Change a single value and bring a replica up to date by sending the whole document
+static void BM_SyncByDocument(benchmark::State &state)
+{
+    const int sections = static_cast<int>(state.range(0));
+
+    JsonTreeItem root;
+    fillSections(&root, sections);
+    JsonTreeItem replica;
+    replica.loadFromJson(root.saveToJson(JsonTreeItem::Compact));
+
+    qint64 bytes = 0;
+    int i = 0;
+    for (auto _ : state) {
+        const QString section = QString("Section%1").arg(i % sections);
+        root.setValue(section, "Key0", ++i);
+
+        const QByteArray document = root.saveToJson(JsonTreeItem::Compact);
+        replica.loadFromJson(document);
+        bytes += document.size();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SyncByDocument)->Arg(64)->Arg(4096);
+
+// Send the diff between the last snapshot, which has been sent, and the current one instead
+static void BM_SyncByPatch(benchmark::State &state)
+{
+    const int sections = static_cast<int>(state.range(0));
+
+    JsonTreeItem root;
+    fillSections(&root, sections);
+    JsonTreeItem replica;
+    replica.loadFromJson(root.saveToJson(JsonTreeItem::Compact));
+    replica.snapshot();
+    JsonSnapshot sent = root.snapshot();
+
+    qint64 bytes = 0;
+    int i = 0;
+    for (auto _ : state) {
+        const QString section = QString("Section%1").arg(i % sections);
+        root.setValue(section, "Key0", ++i);
+
+        const JsonSnapshot current = root.snapshot();
+        const QByteArray patch = JsonTreeItem::diff(sent, current);
+        replica.applyPatch(patch);
+        sent = current;
+        bytes += patch.size();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SyncByPatch)->Arg(64)->Arg(4096);
+
+// Diff of two trees, which have been loaded independently and differ in a single value
+// After the first diff, the hashes are kept in the snapshots of both trees, so only the changed path
+// is compared.
+static void BM_DiffLoadedTrees(benchmark::State &state)
+{
+    const int sections = static_cast<int>(state.range(0));
+
+    JsonTreeItem root;
+    fillSections(&root, sections);
+    JsonTreeItem other;
+    other.loadFromJson(root.saveToJson(JsonTreeItem::Compact));
+    JsonTreeItem::diff(root.snapshot(), other.snapshot());
+
+    int i = 0;
+    for (auto _ : state) {
+        const QString section = QString("Section%1").arg(i % sections);
+        other.setValue(section, "Key1", ++i);
+        benchmark::DoNotOptimize(JsonTreeItem::diff(root.snapshot(), other.snapshot()));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DiffLoadedTrees)->Arg(64)->Arg(4096);
+
+#endif // BENCH_JSONPATCH_H
@@ -0,0 +1,94 @@
+#ifndef BENCH_JSONQUERY_H
+#define BENCH_JSONQUERY_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <benchmark/benchmark.h>
+#include <jsonquery.h>
+#include <jsontreeitem.h>
+
+// Create a document with N servers and a section of N components
+static QByteArray queryJson(int count)
+{
+    QByteArray json = "{\"servers\": [";
+    for (int i = 0; i < count; ++i) {
+        if (i > 0)
+            json += ", ";
+        json += "{\"host\": \"host" + QByteArray::number(i) + "\", \"port\": " + QByteArray::number(8000 + i) + "}";
+    }
+    json += "], \"Settings\": {\"Library\": {\"Components\": {";
+    for (int i = 0; i < count; ++i) {
+        if (i > 0)
+            json += ", ";
+        json += "\"key" + QByteArray::number(i) + "\": " + QByteArray::number(i);
+    }
+    json += "}}}}";
+    return json;
+}
+
+// Reading 50 keys of a section with one value() call each, which walks the object path every time
+static void BM_FixedKeysByValue(benchmark::State &state)
+{
+    JsonTreeItem root;
+    root.loadFromJson(queryJson(static_cast<int>(state.range(0))));
+    const JsonTreeItem &constRoot = root;
+
+    QStringList keys;
+    for (int i = 0; i < 50; ++i)
+        keys.push_back("key" + QString::number(i * 7 % state.range(0)));
+
+    for (auto _ : state) {
+        for (const QString &key : keys)
+            benchmark::DoNotOptimize(constRoot.value("Settings/Library/Components", key));
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+BENCHMARK(BM_FixedKeysByValue)->Arg(64)->Arg(4096);
+
+// Reading the same 50 keys with a query, which finds the section once
+static void BM_FixedKeysByQuery(benchmark::State &state)
+{
+    JsonTreeItem root;
+    root.loadFromJson(queryJson(static_cast<int>(state.range(0))));
+
+    JsonQuery query;
+    for (int i = 0; i < 50; ++i)
+        query.addPath("Settings/Library/Components/key" + QString::number(i * 7 % state.range(0)));
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(query.values(root));
+    state.SetItemsProcessed(state.iterations() * query.size());
+}
+BENCHMARK(BM_FixedKeysByQuery)->Arg(64)->Arg(4096);
+
+// Reading the port of every server with a wildcard, compared with a value() call per server
+static void BM_WildcardByValue(benchmark::State &state)
+{
+    JsonTreeItem root;
+    root.loadFromJson(queryJson(static_cast<int>(state.range(0))));
+    const JsonTreeItem &constRoot = root;
+
+    for (auto _ : state) {
+        for (const JsonTreeItem *server : constRoot.itemAt("servers")->array())
+            benchmark::DoNotOptimize(server->value("port"));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WildcardByValue)->Arg(64)->Arg(4096);
+
+static void BM_WildcardByQuery(benchmark::State &state)
+{
+    JsonTreeItem root;
+    root.loadFromJson(queryJson(static_cast<int>(state.range(0))));
+
+    JsonQuery query;
+    query.addPath("servers/*/port");
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(query.match(root));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_WildcardByQuery)->Arg(64)->Arg(4096);
+
+#endif // BENCH_JSONQUERY_H
@@ -0,0 +1,37 @@
+#ifndef BENCH_JSONSIMD_H
+#define BENCH_JSONSIMD_H
+
+#include <QByteArray>
+
+#include <benchmark/benchmark.h>
+#include <jsonsimd.h>
+#include <jsontreeitem.h>
+
+#include "bench_jsonparser.h"
+
+// Loading with each level of the vectorized scanning, levels above the one of the processor are
+// run with the best supported level
+static void BM_LoadRecordsSimd(benchmark::State &state, JsonSimd::Level level, JsonTreeItem::LoadMode mode)
+{
+    const QByteArray json = recordsJson(state.range(0));
+
+    const JsonSimd::Level previous = JsonSimd::level();
+    JsonSimd::setLevel(level);
+    state.counters["level"] = JsonSimd::level();
+
+    for (auto _ : state) {
+        JsonTreeItem root;
+        root.loadFromJson(json, nullptr, mode);
+        benchmark::DoNotOptimize(root.type());
+    }
+
+    JsonSimd::setLevel(previous);
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK_CAPTURE(BM_LoadRecordsSimd, scalar, JsonSimd::Scalar, JsonTreeItem::Eager)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadRecordsSimd, sse2, JsonSimd::Sse2, JsonTreeItem::Eager)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadRecordsSimd, avx2, JsonSimd::Avx2, JsonTreeItem::Eager)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadRecordsSimd, lazy_scalar, JsonSimd::Scalar, JsonTreeItem::Lazy)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadRecordsSimd, lazy_avx2, JsonSimd::Avx2, JsonTreeItem::Lazy)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_JSONSIMD_H
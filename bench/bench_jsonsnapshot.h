@@ -0,0 +1,79 @@
+#ifndef BENCH_JSONSNAPSHOT_H
+#define BENCH_JSONSNAPSHOT_H
+
+#include <QVector>
+
+#include <memory>
+
+#include <benchmark/benchmark.h>
+#include <jsonsnapshot.h>
+#include <jsontreeitem.h>
+
+#include "bench_allocations.h"
+#include "bench_generators.h"
+
+static constexpr int UndoDepth = 100;
+
+// Change a single value and keep the state in an undo stack of 100 entries, either as snapshot
+// or as clone of the whole tree
+static void BM_EditAndKeepUndo(benchmark::State &state, bool snapshot)
+{
+    const int sections = static_cast<int>(state.range(0));
+
+    JsonTreeItem root;
+    fillSections(&root, sections);
+    root.snapshot();
+
+    QVector<JsonSnapshot> snapshots;
+    QVector<std::shared_ptr<JsonTreeItem>> clones;
+
+    qint64 bytes = 0;
+    int i = 0;
+    for (auto _ : state) {
+        const QString section = QString("Section%1").arg(i % sections);
+        root.setValue(section, "Key0", ++i);
+
+        const qint64 start = allocationBytes.load(std::memory_order_relaxed);
+        if (snapshot) {
+            snapshots.append(root.snapshot());
+        } else {
+            clones.append(std::shared_ptr<JsonTreeItem>(root.clone()));
+        }
+        bytes += allocationBytes.load(std::memory_order_relaxed) - start;
+
+        if (snapshots.size() > UndoDepth)
+            snapshots.removeFirst();
+        if (clones.size() > UndoDepth)
+            clones.removeFirst();
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes"] = benchmark::Counter(static_cast<double>(bytes),
+                                                 benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_EditAndKeepUndo, snapshot, true)->RangeMultiplier(8)->Range(8, 4096);
+BENCHMARK_CAPTURE(BM_EditAndKeepUndo, clone, false)->RangeMultiplier(8)->Range(8, 4096);
+
+// Go back through the undo stack, each restore only rebuilds the changed section
+static void BM_Undo(benchmark::State &state)
+{
+    const int sections = static_cast<int>(state.range(0));
+
+    JsonTreeItem root;
+    fillSections(&root, sections);
+
+    QVector<JsonSnapshot> snapshots;
+    for (int i = 0; i < UndoDepth; ++i) {
+        root.setValue(QString("Section%1").arg(i % sections), "Key0", i);
+        snapshots.append(root.snapshot());
+    }
+
+    int i = 0;
+    for (auto _ : state)
+        root.restore(snapshots.at(UndoDepth - 1 - i++ % UndoDepth));
+
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Undo)->RangeMultiplier(8)->Range(8, 4096);
+
+#endif // BENCH_JSONSNAPSHOT_H
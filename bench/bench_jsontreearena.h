@@ -0,0 +1,57 @@
+#ifndef BENCH_JSONTREEARENA_H
+#define BENCH_JSONTREEARENA_H
+
+#include <QByteArray>
+
+#include <benchmark/benchmark.h>
+#include <jsontreeitem.h>
+
+#include "bench_allocations.h"
+#include "bench_jsonparser.h"
+
+// Load a document and destroy the tree again, with heap or arena allocated nodes
+static void BM_LoadAndDestroy(benchmark::State &state, bool arena)
+{
+    const QByteArray json = recordsJson(state.range(0));
+
+    qint64 allocations = 0;
+    for (auto _ : state) {
+        const qint64 start = allocationCount.load(std::memory_order_relaxed);
+        {
+            JsonTreeItem root;
+            root.setArenaEnabled(arena);
+            root.loadFromJson(json);
+        }
+        allocations += allocationCount.load(std::memory_order_relaxed) - start;
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+    state.counters["allocations"] = benchmark::Counter(static_cast<double>(allocations),
+                                                       benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_LoadAndDestroy, heap, false)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadAndDestroy, arena, true)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+
+// Reload into the same root, which reuses the first block of the arena
+static void BM_Reload(benchmark::State &state, bool arena)
+{
+    const QByteArray json = recordsJson(state.range(0));
+
+    JsonTreeItem root;
+    root.setArenaEnabled(arena);
+
+    qint64 allocations = 0;
+    for (auto _ : state) {
+        const qint64 start = allocationCount.load(std::memory_order_relaxed);
+        root.loadFromJson(json);
+        allocations += allocationCount.load(std::memory_order_relaxed) - start;
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+    state.counters["allocations"] = benchmark::Counter(static_cast<double>(allocations),
+                                                       benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_Reload, heap, false)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Reload, arena, true)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_JSONTREEARENA_H
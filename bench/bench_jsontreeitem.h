@@ -0,0 +1,169 @@
+#ifndef BENCH_JSONTREEITEM_H
+#define BENCH_JSONTREEITEM_H
+
+#include <QByteArray>
+#include <QString>
+
+#include <benchmark/benchmark.h>
+#include <jsonpath.h>
+#include <jsontreeitem.h>
+
+#include "bench_generators.h"
+
+// Lookup of a single key in an object with N keys
+static void BM_FindInWideObject(benchmark::State &state)
+{
+    const int keyCount = static_cast<int>(state.range(0));
+
+    JsonTreeItem root;
+    root.loadFromJson(wideObjectJson(keyCount));
+
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(root.itemAt("key" + QString::number(i)));
+        i = (i + 7919) % keyCount;
+    }
+
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_FindInWideObject)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity(benchmark::o1);
+
+// Merging an object with N keys into an object with the same N keys
+static void BM_AppendJsonWideObject(benchmark::State &state)
+{
+    const int keyCount = static_cast<int>(state.range(0));
+    const QByteArray json = wideObjectJson(keyCount);
+
+    JsonTreeItem root;
+    root.loadFromJson(json);
+
+    for (auto _ : state)
+        root.appendJson(json);
+
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_AppendJsonWideObject)->RangeMultiplier(4)->Range(16, 1 << 16)->Complexity(benchmark::oN);
+
+// Repeated read of a value at depth N through the string based API
+static void BM_ValueByStringPath(benchmark::State &state)
+{
+    const QString objPath = deepObjectPath(static_cast<int>(state.range(0)));
+
+    JsonTreeItem root;
+    root.value(objPath, "key") = 1;
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(root.value(objPath, "key").toInt());
+}
+BENCHMARK(BM_ValueByStringPath)->RangeMultiplier(2)->Range(1, 32);
+
+// Repeated read of a value at depth N through a precompiled path
+static void BM_ValueByJsonPath(benchmark::State &state)
+{
+    const JsonPath path(deepObjectPath(static_cast<int>(state.range(0))), "key");
+
+    JsonTreeItem root;
+    root.value(path) = 1;
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(root.value(path).toInt());
+}
+BENCHMARK(BM_ValueByJsonPath)->RangeMultiplier(2)->Range(1, 32);
+
+// Repeated read of a value at depth N through a bound handle
+static void BM_ValueByHandle(benchmark::State &state)
+{
+    const JsonPath path(deepObjectPath(static_cast<int>(state.range(0))), "key");
+
+    JsonTreeItem root;
+    root.value(path) = 1;
+
+    JsonItemHandle handle(&root, path);
+    for (auto _ : state)
+        benchmark::DoNotOptimize(handle.value().toInt());
+}
+BENCHMARK(BM_ValueByHandle)->RangeMultiplier(2)->Range(1, 32);
+
+// Sum of all numeric values in the subtree, visited through the public accessors
+static double sumValues(JsonTreeItem *item)
+{
+    switch (item->type()) {
+    case JsonTreeItem::Value:
+        return item->value().toDouble();
+    case JsonTreeItem::Object:
+    case JsonTreeItem::Array: {
+        double sum = 0.0;
+        const QVector<JsonTreeItem *> &children =
+                item->type() == JsonTreeItem::Object ? item->object() : item->array();
+        for (JsonTreeItem *child : children)
+            sum += sumValues(child);
+        return sum;
+    }
+    default:
+        return 0.0;
+    }
+}
+
+// Full traversal of a loaded document, which reads every value
+static void BM_TraverseTree(benchmark::State &state)
+{
+    const QByteArray json = recordsJson(state.range(0));
+
+    JsonTreeItem root;
+    root.loadFromJson(json);
+
+    for (auto _ : state)
+        benchmark::DoNotOptimize(sumValues(&root));
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_TraverseTree)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+
+// Lookup of a key in each of the small objects of a document, with or without interned keys
+static void BM_LookupInRecords(benchmark::State &state, bool interned)
+{
+    const QByteArray json = recordsJson(state.range(0));
+
+    JsonTreeItem root;
+    root.setKeyInterningEnabled(interned);
+    root.loadFromJson(json);
+    const QVector<JsonTreeItem *> &records = root.array();
+    const QString key = "port";
+
+    for (auto _ : state) {
+        int sum = 0;
+        for (JsonTreeItem *record : records)
+            sum += record->value(key).toInt();
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * records.size());
+}
+BENCHMARK_CAPTURE(BM_LookupInRecords, plain, false)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LookupInRecords, interned, true)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+
+// Moving a section of records between two trees, by splicing the nodes (moved = true) or by
+// serializing the section and merging it into the other tree (moved = false)
+static void BM_MoveSection(benchmark::State &state, bool moved)
+{
+    JsonTreeItem trees[2];
+    trees[0].loadFromJson("{\"section\": " + recordsJson(state.range(0)) + "}");
+    trees[1].reset();
+
+    int from = 0;
+    for (auto _ : state) {
+        JsonTreeItem &source = trees[from];
+        JsonTreeItem &target = trees[1 - from];
+        if (moved) {
+            target.insertItem("section", source.takeItem("section"));
+        } else {
+            target.appendJson("{\"section\": " + source.itemAt("section")->saveToJson(JsonTreeItem::Compact) + "}");
+            source.removeItem("section");
+        }
+        from = 1 - from;
+    }
+}
+BENCHMARK_CAPTURE(BM_MoveSection, spliced, true)->RangeMultiplier(8)->Range(1 << 16, 1 << 22)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_MoveSection, copied, false)->RangeMultiplier(8)->Range(1 << 16, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+#endif // BENCH_JSONTREEITEM_H
@@ -0,0 +1,56 @@
+#ifndef BENCH_JSONTREEPUBLISHER_H
+#define BENCH_JSONTREEPUBLISHER_H
+
+#include <QAtomicInt>
+
+#include <chrono>
+#include <thread>
+
+#include <benchmark/benchmark.h>
+#include <jsontreeitem.h>
+#include <jsontreepublisher.h>
+
+#include "bench_generators.h"
+
+static std::thread *writerThread = nullptr;
+static QAtomicInt stopWriter;
+
+// Lookups in the published snapshots by reader threads, while a writer publishes a change every
+// millisecond
+static void BM_ReadPublishedSnapshot(benchmark::State &state)
+{
+    static JsonTreePublisher publisher;
+
+    if (state.thread_index() == 0) {
+        stopWriter = 0;
+        writerThread = new std::thread([]() {
+            JsonTreeItem tree;
+            fillSections(&tree, 64);
+            for (int i = 0; !stopWriter.loadRelaxed(); ++i) {
+                tree.value("Section0", "Key0") = i;
+                publisher.publish(tree);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+
+    JsonTreeReader reader(&publisher);
+    const QString section = QString("Section%1").arg(state.thread_index() % 64);
+    const QString key = "Key7";
+
+    int sum = 0;
+    for (auto _ : state)
+        sum += reader.snapshot()->value(section, key).toInt();
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations());
+
+    // All threads have left the loop, when the first one gets here
+    if (state.thread_index() == 0) {
+        stopWriter = 1;
+        writerThread->join();
+        delete writerThread;
+    }
+}
+BENCHMARK(BM_ReadPublishedSnapshot)->ThreadRange(1, 16)->UseRealTime();
+
+#endif // BENCH_JSONTREEPUBLISHER_H
@@ -0,0 +1,142 @@
+#ifndef BENCH_JSONWRITER_H
+#define BENCH_JSONWRITER_H
+
+#include <QBuffer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+
+#include <benchmark/benchmark.h>
+#include <jsontreeitem.h>
+#include <jsonwriter.h>
+
+#include "bench_jsonparser.h"
+
+// Export through the public API into a QJsonValue, as the tree was saved before the streaming writer
+static QJsonValue exportQJsonValue(JsonTreeItem *item)
+{
+    switch (item->type()) {
+    case JsonTreeItem::Object: {
+        QJsonObject obj;
+        for (JsonTreeItem *child : qAsConst(item->object()))
+            obj.insert(child->key(), exportQJsonValue(child));
+        return obj;
+    }
+    case JsonTreeItem::Array: {
+        QJsonArray arr;
+        for (JsonTreeItem *child : qAsConst(item->array()))
+            arr.append(exportQJsonValue(child));
+        return arr;
+    }
+    case JsonTreeItem::Value:
+        return QJsonValue::fromVariant(item->value());
+    default:
+        return QJsonValue();
+    }
+}
+
+// Saving through QJsonObject/QJsonArray copies and QJsonDocument
+static void BM_SaveQJsonDocument(benchmark::State &state)
+{
+    JsonTreeItem root;
+    root.loadFromJson(recordsJson(state.range(0)));
+
+    for (auto _ : state) {
+        QJsonDocument doc(exportQJsonValue(&root).toArray());
+        benchmark::DoNotOptimize(doc.toJson());
+    }
+}
+BENCHMARK(BM_SaveQJsonDocument)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+// Saving with the streaming writer into a reused buffer
+static void BM_SaveToJsonBuffer(benchmark::State &state)
+{
+    JsonTreeItem root;
+    root.loadFromJson(recordsJson(state.range(0)));
+
+    QByteArray buffer;
+    for (auto _ : state)
+        root.saveToJson(buffer);
+
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK(BM_SaveToJsonBuffer)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+// Saving with the streaming writer into a device, which only buffers one chunk
+static void BM_SaveToDevice(benchmark::State &state)
+{
+    JsonTreeItem root;
+    root.loadFromJson(recordsJson(state.range(0)));
+
+    QByteArray output;
+    for (auto _ : state) {
+        output.resize(0);
+        QBuffer device(&output);
+        device.open(QBuffer::WriteOnly);
+        root.saveToDevice(&device, JsonTreeItem::Compact);
+    }
+
+    state.SetBytesProcessed(state.iterations() * output.size());
+}
+BENCHMARK(BM_SaveToDevice)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+// Saving after a single value has been changed, either rewriting the whole tree or reusing the
+// fragments of the unchanged nodes from the previous save
+static void BM_SaveAfterEdit(benchmark::State &state, bool incremental)
+{
+    JsonTreeItem root;
+    root.loadFromJson(recordsJson(state.range(0)));
+
+    QByteArray buffer;
+    root.saveToJson(buffer);
+
+    const int count = root.array().size();
+    int i = 0;
+    for (auto _ : state) {
+        root.array().at(i % count)->setValue("port", i);
+        ++i;
+        if (incremental) {
+            root.saveToJson(buffer);
+        } else {
+            buffer.resize(0);
+            JsonWriter writer(&buffer, JsonTreeItem::Indented);
+            writer.write(&root);
+        }
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCHMARK_CAPTURE(BM_SaveAfterEdit, full, false)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SaveAfterEdit, incremental, true)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+// Time the caller spends in saving a file after a single value has been changed, either writing it
+// on the calling thread or handing it to the worker thread of the save queue
+static void BM_SaveToFileAfterEdit(benchmark::State &state, bool async)
+{
+    const QString filename = QString("bench_save_%1.json").arg(state.range(0));
+
+    JsonTreeItem root;
+    root.loadFromJson(recordsJson(state.range(0)));
+    root.saveToFile(filename);
+
+    const int count = root.array().size();
+    int i = 0;
+    for (auto _ : state) {
+        root.array().at(i % count)->setValue("port", i);
+        ++i;
+        if (async)
+            root.saveToFileAsync(filename);
+        else
+            root.saveToFile(filename);
+    }
+
+    // Saves requested while the previous one is still waiting are coalesced
+    root.saveToFileAsync(filename).waitForFinished();
+    QFile::remove(filename);
+}
+BENCHMARK_CAPTURE(BM_SaveToFileAfterEdit, sync, false)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SaveToFileAfterEdit, async, true)->RangeMultiplier(8)->Range(1 << 20, 64 << 20)->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_JSONWRITER_H
@@ -0,0 +1,66 @@
+#ifndef BENCH_LAZYLOAD_H
+#define BENCH_LAZYLOAD_H
+
+#include <QByteArray>
+
+#include <benchmark/benchmark.h>
+#include <jsontreeitem.h>
+
+#include "bench_allocations.h"
+#include "bench_jsonparser.h"
+
+// Create a JSON object with the specified number of sections, which share approximately the size
+static QByteArray sectionsJson(qint64 size, int sectionCount)
+{
+    const QByteArray section = recordsJson(size / sectionCount);
+
+    QByteArray json = "{\n";
+    for (int i = 0; i < sectionCount; ++i) {
+        if (i > 0)
+            json += ",\n";
+        json += "\"section" + QByteArray::number(i) + "\": " + section;
+    }
+    json += "}\n";
+    return json;
+}
+
+// Loading a document with 64 sections and reading a value in one of them
+static void BM_LoadAndReadSection(benchmark::State &state, JsonTreeItem::LoadMode mode)
+{
+    const QByteArray json = sectionsJson(state.range(0), 64);
+
+    qint64 bytes = 0;
+    for (auto _ : state) {
+        const qint64 start = allocationBytes.load(std::memory_order_relaxed);
+        JsonTreeItem root;
+        root.loadFromJson(json, nullptr, mode);
+        benchmark::DoNotOptimize(root.array("section7").at(3)->value("port").toInt());
+        bytes += allocationBytes.load(std::memory_order_relaxed) - start;
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+    state.counters["heap_bytes"] = benchmark::Counter(static_cast<double>(bytes),
+                                                      benchmark::Counter::kAvgIterations,
+                                                      benchmark::Counter::kIs1024);
+}
+BENCHMARK_CAPTURE(BM_LoadAndReadSection, eager, JsonTreeItem::Eager)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_LoadAndReadSection, lazy, JsonTreeItem::Lazy)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+// Saving a lazily loaded document, in which a single value has been changed
+static void BM_SaveLazyDocument(benchmark::State &state)
+{
+    const QByteArray json = sectionsJson(state.range(0), 64);
+
+    JsonTreeItem root;
+    root.loadFromJson(json, nullptr, JsonTreeItem::Lazy);
+    root.array("section7").at(3)->value("port") = 80;
+
+    QByteArray buffer;
+    for (auto _ : state)
+        root.saveToJson(buffer);
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCHMARK(BM_SaveLazyDocument)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_LAZYLOAD_H
@@ -0,0 +1,68 @@
+#ifndef BENCH_LOADFROMFILE_H
+#define BENCH_LOADFROMFILE_H
+
+#include <QByteArray>
+#include <QFile>
+
+#include <benchmark/benchmark.h>
+#include <jsontreeitem.h>
+
+#include "bench_allocations.h"
+#include "bench_jsonparser.h"
+
+// Write a document of records with approximately the specified size and return its file name
+static QString recordsFile(qint64 size)
+{
+    const QString filename = QString("bench_records_%1.json").arg(size);
+    if (QFile::exists(filename))
+        return filename;
+
+    QFile file(filename);
+    if (file.open(QFile::WriteOnly))
+        file.write(recordsJson(size));
+    return filename;
+}
+
+// Loading as before, with the whole file copied into a QByteArray
+static void BM_LoadFromFileReadAll(benchmark::State &state)
+{
+    const QString filename = recordsFile(state.range(0));
+
+    qint64 bytes = 0;
+    for (auto _ : state) {
+        const qint64 start = allocationBytes.load(std::memory_order_relaxed);
+        JsonTreeItem root;
+        QFile file(filename);
+        file.open(QFile::ReadOnly);
+        root.loadFromJson(file.readAll());
+        bytes += allocationBytes.load(std::memory_order_relaxed) - start;
+    }
+
+    state.SetBytesProcessed(state.iterations() * QFile(filename).size());
+    state.counters["heap_bytes"] = benchmark::Counter(static_cast<double>(bytes),
+                                                      benchmark::Counter::kAvgIterations,
+                                                      benchmark::Counter::kIs1024);
+}
+BENCHMARK(BM_LoadFromFileReadAll)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+// Loading from the memory-mapped file
+static void BM_LoadFromFileMapped(benchmark::State &state)
+{
+    const QString filename = recordsFile(state.range(0));
+
+    qint64 bytes = 0;
+    for (auto _ : state) {
+        const qint64 start = allocationBytes.load(std::memory_order_relaxed);
+        JsonTreeItem root;
+        root.loadFromFile(filename);
+        bytes += allocationBytes.load(std::memory_order_relaxed) - start;
+    }
+
+    state.SetBytesProcessed(state.iterations() * QFile(filename).size());
+    state.counters["heap_bytes"] = benchmark::Counter(static_cast<double>(bytes),
+                                                      benchmark::Counter::kAvgIterations,
+                                                      benchmark::Counter::kIs1024);
+}
+BENCHMARK(BM_LoadFromFileMapped)->RangeMultiplier(8)->Range(1 << 20, 512 << 20)->Unit(benchmark::kMillisecond);
+
+#endif // BENCH_LOADFROMFILE_H
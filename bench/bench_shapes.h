@@ -0,0 +1,246 @@
+#ifndef BENCH_SHAPES_H
+#define BENCH_SHAPES_H
+
+#include <QByteArray>
+#include <QStringList>
+
+#include <benchmark/benchmark.h>
+#include <configitem.h>
+#include <jsontreeitem.h>
+#include <jsonwriter.h>
+
+#include "bench_allocations.h"
+#include "bench_generators.h"
+
+// Regression suite of the core operations on each of the generated document shapes
+// The sizes are the same for all shapes, so the throughput of the shapes can be compared.
+
+#define BENCH_SHAPES(function) \
+    BENCHMARK_CAPTURE(function, wide, WideShape)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMillisecond); \
+    BENCHMARK_CAPTURE(function, deep, DeepShape)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMillisecond); \
+    BENCHMARK_CAPTURE(function, records, RecordsShape)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMillisecond); \
+    BENCHMARK_CAPTURE(function, strings, StringsShape)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMillisecond); \
+    BENCHMARK_CAPTURE(function, numbers, NumbersShape)->Arg(1 << 20)->Arg(16 << 20)->Unit(benchmark::kMillisecond)
+
+// Loading with loadFromJson()
+static void BM_LoadShape(benchmark::State &state, BenchShape shape)
+{
+    const QByteArray json = shapeJson(shape, state.range(0));
+
+    JsonTreeItem root;
+    for (auto _ : state)
+        root.loadFromJson(json);
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCH_SHAPES(BM_LoadShape);
+
+// Serialization of the whole tree, without reusing the output of the previous save
+static void BM_SaveShape(benchmark::State &state, BenchShape shape)
+{
+    const QByteArray json = shapeJson(shape, state.range(0));
+
+    JsonTreeItem root;
+    root.loadFromJson(json);
+
+    QByteArray buffer;
+    for (auto _ : state) {
+        buffer.resize(0);
+        JsonWriter writer(&buffer);
+        writer.write(&root);
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size());
+}
+BENCH_SHAPES(BM_SaveShape);
+
+// Merging a document with appendJson() into a tree with the same content
+static void BM_AppendJsonShape(benchmark::State &state, BenchShape shape)
+{
+    const QByteArray json = shapeJson(shape, state.range(0));
+
+    JsonTreeItem root;
+    root.loadFromJson(json);
+
+    for (auto _ : state) {
+        // Arrays are appended to, so they are loaded again before each merge
+        if (shape != WideShape) {
+            state.PauseTiming();
+            root.loadFromJson(json);
+            state.ResumeTiming();
+        }
+        root.appendJson(json);
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCH_SHAPES(BM_AppendJsonShape);
+
+// Destruction of a loaded tree
+static void BM_DestroyShape(benchmark::State &state, BenchShape shape)
+{
+    const QByteArray json = shapeJson(shape, state.range(0));
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        JsonTreeItem *root = new JsonTreeItem;
+        root->loadFromJson(json);
+        state.ResumeTiming();
+
+        delete root;
+    }
+
+    state.SetBytesProcessed(state.iterations() * json.size());
+}
+BENCH_SHAPES(BM_DestroyShape);
+
+// Read of a value through the string based API in an object with N keys
+static void BM_ValueByWidth(benchmark::State &state)
+{
+    const int keyCount = static_cast<int>(state.range(0));
+
+    JsonTreeItem root;
+    root.loadFromJson(wideObjectJson(keyCount));
+
+    QStringList keys;
+    for (int i = 0; i < keyCount; ++i)
+        keys.push_back("key" + QString::number(i));
+
+    int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(root.value(keys.at(i)).toInt());
+        i = (i + 7919) % keyCount;
+    }
+}
+BENCHMARK(BM_ValueByWidth)->RangeMultiplier(8)->Range(8, 1 << 18);
+
+// Removal of a key from an object with N keys, which is added again for the next iteration
+static void BM_RemoveItem(benchmark::State &state)
+{
+    const int keyCount = static_cast<int>(state.range(0));
+
+    JsonTreeItem root;
+    root.loadFromJson(wideObjectJson(keyCount));
+
+    QStringList keys;
+    for (int i = 0; i < keyCount; ++i)
+        keys.push_back("key" + QString::number(i));
+
+    int i = 0;
+    for (auto _ : state) {
+        root.removeItem(keys.at(i));
+        root.value(keys.at(i)) = i;
+        i = (i + 7919) % keyCount;
+    }
+}
+BENCHMARK(BM_RemoveItem)->RangeMultiplier(8)->Range(8, 1 << 18);
+
+// Create a document with a list of N strings
+static QByteArray stringListJson(int count)
+{
+    QByteArray json = "{\"list\": [";
+    for (int i = 0; i < count; ++i) {
+        if (i > 0)
+            json += ", ";
+        json += "\"entry" + QByteArray::number(i) + "\"";
+    }
+    json += "]}";
+    return json;
+}
+
+// First access of a string list with N entries after loading, which converts the child nodes
+static void BM_ConfigStringList(benchmark::State &state)
+{
+    const QByteArray json = stringListJson(static_cast<int>(state.range(0)));
+
+    ConfigItem config;
+    for (auto _ : state) {
+        state.PauseTiming();
+        config.loadFromJson(json);
+        state.ResumeTiming();
+
+        benchmark::DoNotOptimize(config.stringList("list").size());
+    }
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigStringList)->RangeMultiplier(8)->Range(8, 1 << 18);
+
+// Saving a string list with N entries, which is modified through its reference before each save
+// The allocations per entry show, whether the list is written without creating nodes.
+static void BM_ConfigStringListSave(benchmark::State &state)
+{
+    ConfigItem config;
+    config.loadFromJson(stringListJson(static_cast<int>(state.range(0))));
+    QStringList &list = config.stringList("list");
+
+    int i = 0;
+    const qint64 allocations = allocationCount.load();
+    for (auto _ : state) {
+        config.stringList("list");
+        list[i] = "changed";
+        benchmark::DoNotOptimize(config.saveToJson());
+        i = (i + 1) % list.size();
+    }
+
+    state.counters["allocs_per_entry"] = double(allocationCount.load() - allocations) / (state.iterations() * state.range(0));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigStringListSave)->RangeMultiplier(8)->Range(8, 1 << 18);
+
+// Create a document with an array of N doubles
+static QByteArray doubleArrayJson(int count)
+{
+    QByteArray json = "{\"curve\": [";
+    for (int i = 0; i < count; ++i) {
+        if (i > 0)
+            json += ", ";
+        json += QByteArray::number(i * 0.001 + 1e-7, 'g', 17);
+    }
+    json += "]}";
+    return json;
+}
+
+// Loading an array of N doubles as nodes (packed = 0) or into a packed array (packed = 1)
+// The allocated bytes per element include the temporary ones, e.g. of the growing vector.
+static void BM_ConfigDoubleArrayLoad(benchmark::State &state)
+{
+    const QByteArray json = doubleArrayJson(static_cast<int>(state.range(0)));
+    const bool packed = state.range(1) != 0;
+
+    const qint64 bytes = allocationBytes.load();
+    for (auto _ : state) {
+        ConfigItem config;
+        if (packed) {
+            config.loadFromJson(json, nullptr, JsonTreeItem::Lazy);
+            benchmark::DoNotOptimize(config.doubleArray("curve").constData());
+        } else {
+            config.loadFromJson(json);
+        }
+    }
+
+    state.counters["bytes_per_element"] = double(allocationBytes.load() - bytes) / (state.iterations() * state.range(0));
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigDoubleArrayLoad)->ArgsProduct({{1 << 10, 1 << 20}, {0, 1}});
+
+// Saving an array of N doubles from a packed array as JSON (base64 = 0) or base64 string (base64 = 1)
+static void BM_ConfigDoubleArraySave(benchmark::State &state)
+{
+    ConfigItem config;
+    config.loadFromJson(doubleArrayJson(static_cast<int>(state.range(0))), nullptr, JsonTreeItem::Lazy);
+    config.doubleArray("curve");
+    config.itemAt("curve")->setBase64Encoded(state.range(1) != 0);
+
+    qint64 bytes = 0;
+    for (auto _ : state) {
+        config.doubleArray("curve");
+        bytes += config.saveToJson(JsonTreeItem::Compact).size();
+    }
+
+    state.SetBytesProcessed(bytes);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConfigDoubleArraySave)->ArgsProduct({{1 << 10, 1 << 20}, {0, 1}});
+
+#endif // BENCH_SHAPES_H
@@ -0,0 +1,32 @@
+#include <benchmark/benchmark.h>
+#include <jsonsimd.h>
+#include "bench_configbinding.h"
+#include "bench_generators.h"
+#include "bench_jsonbinary.h"
+#include "bench_jsonfilewatcher.h"
+#include "bench_jsonkeypool.h"
+#include "bench_jsonparallelloader.h"
+#include "bench_jsonparser.h"
+#include "bench_jsonpatch.h"
+#include "bench_jsonquery.h"
+#include "bench_jsonsimd.h"
+#include "bench_jsonsnapshot.h"
+#include "bench_jsontreearena.h"
+#include "bench_jsontreeitem.h"
+#include "bench_jsontreepublisher.h"
+#include "bench_jsonwriter.h"
+#include "bench_lazyload.h"
+#include "bench_loadfromfile.h"
+#include "bench_shapes.h"
+
+int main(int argc, char **argv)
+{
+    // Recorded in the context of the results, so runs of different builds and machines can be told apart
+    const char *simdLevels[] = {"scalar", "sse2", "avx2"};
+    ::benchmark::AddCustomContext("qt_version", qVersion());
+    ::benchmark::AddCustomContext("simd_level", simdLevels[JsonSimd::level()]);
+
+    ::benchmark::Initialize(&argc, argv);
+    ::benchmark::RunSpecifiedBenchmarks();
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include "configbinding.h"
+
+ConfigBindingPlan::ConfigBindingPlan(const char *const *paths, int count)
+{
+    for (int field = 0; field < count; ++field) {
+        int step = -1;
+        for (const QString &key : QString::fromUtf8(paths[field]).split('/'))
+            step = addStep(step, key);
+        m_steps[step].field = field;
+    }
+}
+
+int ConfigBindingPlan::addStep(int parent, const QString &key)
+{
+    // The children of a step follow it
+    for (int pos = parent + 1; pos < m_steps.size(); ++pos) {
+        const Step &step = m_steps.at(pos);
+        if (step.parent == parent && step.key == key)
+            return pos;
+    }
+
+    m_steps.push_back({parent, -1, key});
+    return m_steps.size() - 1;
+}
+
+void ConfigBindingPlan::find(JsonTreeItem *root, JsonTreeItem **fieldItems) const
+{
+    // The const lookups never create nodes, a node below a missing one or a value is missing as well
+    QVector<const JsonTreeItem *> items(m_steps.size());
+    for (int pos = 0; pos < m_steps.size(); ++pos) {
+        const Step &step = m_steps.at(pos);
+        const JsonTreeItem *parent = step.parent < 0 ? root : items.at(step.parent);
+        const JsonTreeItem *item = parent ? parent->itemAt(step.key) : nullptr;
+        items[pos] = item;
+        if (step.field >= 0)
+            fieldItems[step.field] = const_cast<JsonTreeItem *>(item);
+    }
+}
+
+void ConfigBindingPlan::findOrCreate(JsonTreeItem *root, JsonTreeItem **fieldItems) const
+{
+    QVector<JsonTreeItem *> items(m_steps.size());
+    for (int pos = 0; pos < m_steps.size(); ++pos) {
+        const Step &step = m_steps.at(pos);
+        JsonTreeItem *parent = step.parent < 0 ? root : items.at(step.parent);
+        JsonTreeItem *item = step.field < 0 ? parent->objectAt(step.key) : parent->itemAt(step.key);
+        items[pos] = item;
+        if (step.field >= 0)
+            fieldItems[step.field] = item;
+    }
+}
@@ -0,0 +1,221 @@
+#ifndef CONFIGBINDING_H
+#define CONFIGBINDING_H
+
+#include <array>
+#include <tuple>
+#include <utility>
+
+#include "configitem.h"
+
+// Field of a struct, which is bound to the node at a path of a ConfigItem
+// The path is split at every "/" like JsonPath, but it must not have empty segments.
+template<typename _S, typename _V>
+struct ConfigField
+{
+    constexpr ConfigField(const char *path, _V _S::*member) : path(path), member(member) {}
+
+    const char *path;
+    _V _S::*member;
+};
+
+namespace ConfigBindingData {
+
+// Conversion between a node and a field, the default covers the types, which a QVariant holds
+template<typename _V>
+struct ValueTraits
+{
+    static void load(ConfigItem *item, _V &field)
+    {
+        const QVariant value = static_cast<const JsonTreeItem *>(item)->value();
+        if (value.isValid())
+            field = value.value<_V>();
+    }
+
+    // Unchanged values are not assigned, so they do not mark the node as changed
+    static void save(ConfigItem *item, const _V &field)
+    {
+        const QVariant value = QVariant::fromValue(field);
+        if (item->type() != JsonTreeItem::Value || static_cast<const JsonTreeItem *>(item)->value() != value)
+            item->setValue(value);
+    }
+};
+
+// The containers are the extended data of ConfigItem, which is copied with implicit sharing
+template<typename _V, _V &(ConfigItem::*_Accessor)()>
+struct ContainerTraits
+{
+    static void load(ConfigItem *item, _V &field) { field = (item->*_Accessor)(); }
+
+    static void save(ConfigItem *item, const _V &field)
+    {
+        _V &container = (item->*_Accessor)();
+        if (container != field)
+            container = field;
+    }
+};
+
+template<> struct ValueTraits<QMap<QString, QString>> : ContainerTraits<QMap<QString, QString>, &ConfigItem::stringMap> {};
+template<> struct ValueTraits<QStringList> : ContainerTraits<QStringList, &ConfigItem::stringList> {};
+template<> struct ValueTraits<QList<int>> : ContainerTraits<QList<int>, &ConfigItem::intList> {};
+template<> struct ValueTraits<QVector<double>> : ContainerTraits<QVector<double>, &ConfigItem::doubleArray> {};
+template<> struct ValueTraits<QVector<qint64>> : ContainerTraits<QVector<qint64>, &ConfigItem::int64Array> {};
+template<> struct ValueTraits<QVector<float>> : ContainerTraits<QVector<float>, &ConfigItem::floatArray> {};
+template<> struct ValueTraits<QVector<quint8>> : ContainerTraits<QVector<quint8>, &ConfigItem::uint8Array> {};
+
+// Whether the path has at least one segment and no empty ones
+constexpr bool isValidPath(const char *path)
+{
+    if (*path == '\0' || *path == '/')
+        return false;
+    for (; *path != '\0'; ++path) {
+        if (*path == '/' && (path[1] == '/' || path[1] == '\0'))
+            return false;
+    }
+    return true;
+}
+
+// Whether both paths lead to the same node or one of them leads to an object on the other one
+constexpr bool pathsOverlap(const char *path1, const char *path2)
+{
+    while (*path1 != '\0' && *path1 == *path2) {
+        ++path1;
+        ++path2;
+    }
+    return (*path1 == '\0' && (*path2 == '\0' || *path2 == '/')) || (*path2 == '\0' && *path1 == '/');
+}
+
+template<std::size_t _N>
+constexpr bool validPaths(const std::array<const char *, _N> &paths)
+{
+    for (std::size_t i = 0; i < _N; ++i) {
+        if (!isValidPath(paths[i]))
+            return false;
+    }
+    return true;
+}
+
+template<std::size_t _N>
+constexpr bool distinctPaths(const std::array<const char *, _N> &paths)
+{
+    for (std::size_t i = 0; i < _N; ++i) {
+        for (std::size_t j = 0; j < i; ++j) {
+            if (pathsOverlap(paths[i], paths[j]))
+                return false;
+        }
+    }
+    return true;
+}
+
+}
+
+// Paths of the fields of a binding, which are merged into a tree of keys
+// Each object along the paths is looked up only once, however many fields it contains. The keys are
+// created once per binding, as the plan is kept for the lifetime of the program.
+class ConfigBindingPlan
+{
+public:
+    ConfigBindingPlan(const char *const *paths, int count);
+
+    // Look up the nodes of the fields without creating any, the nodes of missing paths are nullptr
+    // The nodes are those of the non-const root, so they can be converted by the accessors.
+    void find(JsonTreeItem *root, JsonTreeItem **fieldItems) const;
+
+    // Look up the nodes of the fields, missing nodes and objects along the paths are created
+    void findOrCreate(JsonTreeItem *root, JsonTreeItem **fieldItems) const;
+
+private:
+    // Lookup of a key in the node of the parent step, which is the root for -1
+    // The parents precede their children, so the steps are resolved in one pass.
+    struct Step
+    {
+        int parent;
+        int field;
+        QString key;
+    };
+
+    QVector<Step> m_steps;
+
+    int addStep(int parent, const QString &key);
+};
+
+// Binding of a struct to a ConfigItem
+// The struct declares its bound fields with a static constexpr function, e.g.
+//
+//     struct GeneralSettings
+//     {
+//         bool showHints = true;
+//         QStringList recentFiles;
+//
+//         static constexpr auto configFields()
+//         {
+//             return std::make_tuple(ConfigField("General Settings/Show Hints on Startup", &GeneralSettings::showHints),
+//                                    ConfigField("General Settings/Recent Files", &GeneralSettings::recentFiles));
+//         }
+//     };
+//
+// The paths are checked at compile time. All fields are loaded or saved in one pass, afterwards
+// the settings are plain members without lookups and QVariant conversions.
+template<typename _S>
+class ConfigBinding
+{
+public:
+    // Copy the nodes at the paths into the fields, fields without a node keep their value
+    // Nodes of container fields are converted like by the accessors of ConfigItem.
+    static void load(ConfigItem &config, _S &settings)
+    {
+        std::array<JsonTreeItem *, FieldCount> items;
+        plan().find(&config, items.data());
+        loadFields(settings, items, std::make_index_sequence<FieldCount>());
+    }
+
+    // Store the fields at their paths, which are created if necessary
+    // Only the nodes of changed fields are marked as changed for incremental saving.
+    static void save(ConfigItem &config, const _S &settings)
+    {
+        std::array<JsonTreeItem *, FieldCount> items;
+        plan().findOrCreate(&config, items.data());
+        saveFields(settings, items, std::make_index_sequence<FieldCount>());
+    }
+
+private:
+    static constexpr auto Fields = _S::configFields();
+    static constexpr std::size_t FieldCount = std::tuple_size<decltype(Fields)>::value;
+
+    template<std::size_t... _I>
+    static constexpr std::array<const char *, FieldCount> paths(std::index_sequence<_I...>)
+    { return {{std::get<_I>(Fields).path...}}; }
+
+    static constexpr std::array<const char *, FieldCount> Paths = paths(std::make_index_sequence<FieldCount>());
+
+    static_assert(FieldCount > 0, "The binding has no fields");
+    static_assert(ConfigBindingData::validPaths(Paths), "A path of the binding is empty or has an empty segment");
+    static_assert(ConfigBindingData::distinctPaths(Paths), "A path of the binding is bound twice or leads through another one");
+
+    static const ConfigBindingPlan &plan()
+    {
+        static const ConfigBindingPlan bindingPlan(Paths.data(), static_cast<int>(FieldCount));
+        return bindingPlan;
+    }
+
+    template<std::size_t... _I>
+    static void loadFields(_S &settings, const std::array<JsonTreeItem *, FieldCount> &items, std::index_sequence<_I...>)
+    { (loadField(std::get<_I>(Fields), settings, items[_I]), ...); }
+
+    template<std::size_t... _I>
+    static void saveFields(const _S &settings, const std::array<JsonTreeItem *, FieldCount> &items, std::index_sequence<_I...>)
+    { (saveField(std::get<_I>(Fields), settings, items[_I]), ...); }
+
+    // The nodes of a ConfigItem tree are ConfigItem nodes
+    template<typename _V>
+    static void loadField(const ConfigField<_S, _V> &field, _S &settings, JsonTreeItem *item)
+    {
+        if (item)
+            ConfigBindingData::ValueTraits<_V>::load(static_cast<ConfigItem *>(item), settings.*field.member);
+    }
+
+    template<typename _V>
+    static void saveField(const ConfigField<_S, _V> &field, const _S &settings, JsonTreeItem *item)
+    { ConfigBindingData::ValueTraits<_V>::save(static_cast<ConfigItem *>(item), settings.*field.member); }
+};
+
+#endif // CONFIGBINDING_H
@@ -1,15 +1,265 @@
 #include <QFile>
+#include <QtEndian>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonValue>
 
+#include <algorithm>
+#include <cstring>
+
 #include "configitem.h"
 
+// The size, which is documented in the header, is kept in check for Qt 5 on a 64 bit platform
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0) && QT_POINTER_SIZE == 8
+static_assert(sizeof(ConfigItem) == 96, "The size of a ConfigItem differs from the one in configitem.h");
+#endif
+
+namespace {
+
+// Receivers, which convert the elements of the tree into the extended data types like QVariant
+template<ConfigItem::ExtendedType _T>
+class ElementConverter;
+
+template<>
+class ElementConverter<ConfigItem::StringMap> : public JsonTreeItemData::ElementSink
+{
+public:
+    explicit ElementConverter(QMap<QString, QString> &stringMap) : m_stringMap(stringMap) {}
+    void addValue(const QString &key, const QVariant &value) override { m_stringMap[key] = value.toString(); }
+    void addString(const QString &key, const QString &str) override { m_stringMap[key] = str; }
+
+private:
+    QMap<QString, QString> &m_stringMap;
+};
+
+template<>
+class ElementConverter<ConfigItem::StringList> : public JsonTreeItemData::ElementSink
+{
+public:
+    explicit ElementConverter(QStringList &stringList) : m_stringList(stringList) {}
+    void addValue(const QString &, const QVariant &value) override { m_stringList.push_back(value.toString()); }
+    void addString(const QString &, const QString &str) override { m_stringList.push_back(str); }
+
+private:
+    QStringList &m_stringList;
+};
+
+template<>
+class ElementConverter<ConfigItem::IntList> : public JsonTreeItemData::ElementSink
+{
+public:
+    explicit ElementConverter(QList<int> &intList) : m_intList(intList) {}
+    void addValue(const QString &, const QVariant &value) override { m_intList.push_back(value.toInt()); }
+
+private:
+    QList<int> &m_intList;
+};
+
+// Conversion of the elements of packed arrays
+template<typename _Number>
+_Number fromVariant(const QVariant &value);
+
+template<> double fromVariant<double>(const QVariant &value) { return value.toDouble(); }
+template<> qint64 fromVariant<qint64>(const QVariant &value) { return value.toLongLong(); }
+template<> float fromVariant<float>(const QVariant &value) { return value.toFloat(); }
+template<> quint8 fromVariant<quint8>(const QVariant &value) { return static_cast<quint8>(value.toUInt()); }
+
+void addNumber(JsonTreeItemData::ElementSink &sink, double number) { sink.addDouble(QString(), number); }
+void addNumber(JsonTreeItemData::ElementSink &sink, qint64 number) { sink.addInteger(QString(), number); }
+void addNumber(JsonTreeItemData::ElementSink &sink, float number) { sink.addFloat(QString(), number); }
+void addNumber(JsonTreeItemData::ElementSink &sink, quint8 number) { sink.addInteger(QString(), number); }
+
+template<typename _Number>
+class NumberConverter : public JsonTreeItemData::ElementSink
+{
+public:
+    explicit NumberConverter(QVector<_Number> &array) : m_array(array) {}
+    void addValue(const QString &, const QVariant &value) override { m_array.push_back(fromVariant<_Number>(value)); }
+    void addInteger(const QString &, qint64 number) override { m_array.push_back(static_cast<_Number>(number)); }
+
+    void addDouble(const QString &key, double number) override
+    {
+        // Casting a double out of the range of an integer is undefined, QVariant takes care of it
+        if constexpr (std::is_floating_point<_Number>::value)
+            m_array.push_back(static_cast<_Number>(number));
+        else
+            addValue(key, number);
+    }
+
+private:
+    QVector<_Number> &m_array;
+};
+
+template<>
+class ElementConverter<ConfigItem::DoubleArray> : public NumberConverter<double>
+{
+    using NumberConverter::NumberConverter;
+};
+
+template<>
+class ElementConverter<ConfigItem::Int64Array> : public NumberConverter<qint64>
+{
+    using NumberConverter::NumberConverter;
+};
+
+template<>
+class ElementConverter<ConfigItem::FloatArray> : public NumberConverter<float>
+{
+    using NumberConverter::NumberConverter;
+};
+
+template<>
+class ElementConverter<ConfigItem::UInt8Array> : public NumberConverter<quint8>
+{
+    using NumberConverter::NumberConverter;
+};
+
+// Swap the bytes of each number on big endian platforms, the encoding is always little endian
+template<typename _Number>
+void toLittleEndian(char *bytes, int size)
+{
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    for (int pos = 0; pos < size; pos += int(sizeof(_Number)))
+        std::reverse(bytes + pos, bytes + pos + sizeof(_Number));
+#else
+    Q_UNUSED(bytes)
+    Q_UNUSED(size)
+#endif
+}
+
+template<typename _Number>
+QString encodeBase64(const QVector<_Number> &array)
+{
+    QByteArray bytes(reinterpret_cast<const char *>(array.constData()), array.size() * int(sizeof(_Number)));
+    toLittleEndian<_Number>(bytes.data(), bytes.size());
+    return QString::fromLatin1(bytes.toBase64());
+}
+
+// Whether the string consists of base64 characters in groups of 4 with the padding at its end
+bool isBase64(const QByteArray &encoded)
+{
+    if (encoded.size() % 4 != 0)
+        return false;
+
+    int padding = 0;
+    for (char c : encoded) {
+        if (c == '=') {
+            ++padding;
+            continue;
+        }
+        const bool valid = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '+' || c == '/';
+        if (!valid || padding > 0)
+            return false;
+    }
+    return padding <= 2;
+}
+
+// Returns false and leaves the array empty, if the string is no encoding of whole numbers
+// QByteArray::fromBase64() skips invalid characters, so the string is checked first.
+template<typename _Number>
+bool decodeBase64(const QString &str, QVector<_Number> &array)
+{
+    const QByteArray encoded = str.toLatin1();
+    if (!isBase64(encoded))
+        return false;
+
+    QByteArray bytes = QByteArray::fromBase64(encoded);
+    if (bytes.size() % int(sizeof(_Number)) != 0)
+        return false;
+
+    toLittleEndian<_Number>(bytes.data(), bytes.size());
+    array.resize(bytes.size() / int(sizeof(_Number)));
+    memcpy(array.data(), bytes.constData(), size_t(bytes.size()));
+    return true;
+}
+
+// The array is cleared in place, if the snapshot holds a string, which is no valid encoding
+template<typename _Number>
+bool updatePackedArray(QVector<_Number> &array, const JsonSnapshot &snapshot, bool &valid)
+{
+    QVector<_Number> update;
+    valid = true;
+    if (snapshot.type() == JsonTreeItem::Value) {
+        valid = decodeBase64<_Number>(snapshot.value().toString(), update);
+        if (!valid) {
+            const bool changed = !array.isEmpty();
+            array.clear();
+            return changed;
+        }
+    } else {
+        update.reserve(snapshot.size());
+        NumberConverter<_Number> converter(update);
+        for (int pos = 0; pos < snapshot.size(); ++pos)
+            converter.addValue(QString(), snapshot.at(pos).value());
+    }
+
+    if (update == array)
+        return false;
+    array = update;
+    return true;
+}
+
+template<typename _Number>
+void exportPackedArray(const QVector<_Number> &array, bool base64Encoded, JsonTreeItemData::ElementSink &sink)
+{
+    if (base64Encoded) {
+        sink.addString(QString(), encodeBase64(array));
+        return;
+    }
+
+    for (_Number number : array)
+        addNumber(sink, number);
+}
+
+}
+
+template<ConfigItem::ExtendedType _T>
+void ConfigItem::convertElements()
+{
+    setBaseType<ParentType<_T>>();
+    ElementConverter<_T> converter(asExtendedType<_T>());
+    takeElements(converter);
+}
+
+template<ConfigItem::ExtendedType _T>
+ConfigItem::ValueType<_T> &ConfigItem::packedArray()
+{
+    if (m_extendedType != _T) {
+        // A string value is the base64 encoding of the array, the encoding is kept for saving
+        const bool encoded = type() == Value && static_cast<const JsonTreeItem *>(this)->value().userType() == QMetaType::QString;
+        if (encoded) {
+            using Number = typename ValueType<_T>::value_type;
+            ValueType<_T> array;
+            const bool valid = decodeBase64<Number>(static_cast<const JsonTreeItem *>(this)->value().toString(), array);
+            allocExtendedData<_T>();
+            asExtendedType<_T>() = array;
+            m_base64Encoded = true;
+
+            // A string, which is no valid encoding, is kept in place of the empty array
+            if (valid)
+                setValue(QVariant());
+        } else {
+            allocExtendedData<_T>();
+            convertElements<_T>();
+
+            // An encoded array is saved from a value node
+            if (m_base64Encoded)
+                setBaseType<Value>();
+        }
+    } else if (hasInvalidEncoding() && !asExtendedType<_T>().isEmpty()) {
+        // The elements, which have been added to the array, replace the string
+        setValue(QVariant());
+    }
+
+    markExposed();
+    return asExtendedType<_T>();
+}
+
 ConfigItem::ConfigItem()
     : JsonTreeItem(),
-      m_extendedData(nullptr),
-      m_extendedType(None)
+      m_extendedType(None),
+      m_base64Encoded(false)
 {
 }
 
@@ -18,36 +268,48 @@ void ConfigItem::clearExtended()
     switch (m_extendedType)
     {
     case StringMap:
-        // m_extendedData is a pointer to a QMap<QString, QString> object
+        // m_extendedData holds a QMap<QString, QString> object
         freeExtendedData<StringMap>();
         break;
     case StringList:
-        // m_extendedData is a pointer to a QStringList object
+        // m_extendedData holds a QStringList object
         freeExtendedData<StringList>();
         break;
     case IntList:
-        // m_extendedData is a pointer to a QList<int> object
+        // m_extendedData holds a QList<int> object
         freeExtendedData<IntList>();
         break;
+    case DoubleArray:
+        // m_extendedData holds a QVector<double> object
+        freeExtendedData<DoubleArray>();
+        break;
+    case Int64Array:
+        // m_extendedData holds a QVector<qint64> object
+        freeExtendedData<Int64Array>();
+        break;
+    case FloatArray:
+        // m_extendedData holds a QVector<float> object
+        freeExtendedData<FloatArray>();
+        break;
+    case UInt8Array:
+        // m_extendedData holds a QVector<quint8> object
+        freeExtendedData<UInt8Array>();
+        break;
     default:
         break;
     }
 
     m_extendedType = None;
-    m_extendedData = nullptr;
 }
 
 ConfigItem::ValueType<ConfigItem::StringMap> &ConfigItem::stringMap()
 {
     if (m_extendedType != StringMap) {
         allocExtendedData<StringMap>();
-
-        auto &object = forceAsType<ParentType<StringMap>>();
-        for (JsonTreeItem *dictItem : qAsConst(object))
-            asExtendedType<StringMap>()[dictItem->key()] = dictItem->value().toString();
-        object.clear();
+        convertElements<StringMap>();
     }
 
+    markExposed();
     return asExtendedType<StringMap>();
 }
 
@@ -55,13 +317,10 @@ ConfigItem::ValueType<ConfigItem::StringList> &ConfigItem::stringList()
 {
     if (m_extendedType != StringList) {
         allocExtendedData<StringList>();
-
-        auto &array = forceAsType<ParentType<StringList>>();
-        for (JsonTreeItem *strItem : qAsConst(array))
-            asExtendedType<StringList>().push_back(strItem->value().toString());
-        array.clear();
+        convertElements<StringList>();
     }
 
+    markExposed();
     return asExtendedType<StringList>();
 }
 
@@ -69,58 +328,209 @@ ConfigItem::ValueType<ConfigItem::IntList> &ConfigItem::intList()
 {
     if (m_extendedType != IntList) {
         allocExtendedData<IntList>();
-
-        auto &array = forceAsType<ParentType<IntList>>();
-        for (JsonTreeItem *intItem : qAsConst(array))
-            asExtendedType<IntList>().push_back(intItem->value().toInt());
-        array.clear();
+        convertElements<IntList>();
     }
 
+    markExposed();
     return asExtendedType<IntList>();
 }
 
-void ConfigItem::finalizeForExport()
+ConfigItem::ValueType<ConfigItem::DoubleArray> &ConfigItem::doubleArray()
+{
+    return packedArray<DoubleArray>();
+}
+
+ConfigItem::ValueType<ConfigItem::Int64Array> &ConfigItem::int64Array()
+{
+    return packedArray<Int64Array>();
+}
+
+ConfigItem::ValueType<ConfigItem::FloatArray> &ConfigItem::floatArray()
+{
+    return packedArray<FloatArray>();
+}
+
+ConfigItem::ValueType<ConfigItem::UInt8Array> &ConfigItem::uint8Array()
+{
+    return packedArray<UInt8Array>();
+}
+
+void ConfigItem::setBase64Encoded(bool enabled)
+{
+    if (enabled == m_base64Encoded)
+        return;
+
+    // A packed array changes the type of its node with the encoding
+    m_base64Encoded = enabled;
+    if (isPackedArray()) {
+        if (enabled)
+            setBaseType<Value>();
+        else
+            setBaseType<Array>();
+    }
+
+    markDirty();
+}
+
+void ConfigItem::copyExtended(const JsonTreeItem *source)
+{
+    const ConfigItem *item = static_cast<const ConfigItem *>(source);
+
+    switch (item->m_extendedType) {
+    case StringMap:
+        allocExtendedData<StringMap>();
+        asExtendedType<StringMap>() = item->asExtendedType<StringMap>();
+        break;
+    case StringList:
+        allocExtendedData<StringList>();
+        asExtendedType<StringList>() = item->asExtendedType<StringList>();
+        break;
+    case IntList:
+        allocExtendedData<IntList>();
+        asExtendedType<IntList>() = item->asExtendedType<IntList>();
+        break;
+    case DoubleArray:
+        allocExtendedData<DoubleArray>();
+        asExtendedType<DoubleArray>() = item->asExtendedType<DoubleArray>();
+        break;
+    case Int64Array:
+        allocExtendedData<Int64Array>();
+        asExtendedType<Int64Array>() = item->asExtendedType<Int64Array>();
+        break;
+    case FloatArray:
+        allocExtendedData<FloatArray>();
+        asExtendedType<FloatArray>() = item->asExtendedType<FloatArray>();
+        break;
+    case UInt8Array:
+        allocExtendedData<UInt8Array>();
+        asExtendedType<UInt8Array>() = item->asExtendedType<UInt8Array>();
+        break;
+    default:
+        break;
+    }
+
+    m_base64Encoded = item->m_base64Encoded;
+}
+
+bool ConfigItem::updateExtended(const JsonSnapshot &snapshot)
 {
+    // The snapshot is converted like the child nodes by the accessors, the containers are only
+    // assigned, if they differ
+    bool changed = false;
+    bool valid = true;
     switch (m_extendedType) {
     case StringMap: {
-        auto &object = forceAsType<ParentType<StringMap>>();
-        object.clear();
-
-        const QMap<QString, QString> &stringMap = asExtendedType<StringMap>();
-        const QStringList keys = stringMap.keys();
-        for (const QString &key : keys) {
-            ConfigItem *item = newItem();
-            item->setKey(key);
-            item->value() = stringMap[key];
-            object.push_back(item);
-        }
+        QMap<QString, QString> stringMap;
+        for (int pos = 0; pos < snapshot.size(); ++pos)
+            stringMap[snapshot.keyAt(pos)] = snapshot.at(pos).value().toString();
+        changed = stringMap != asExtendedType<StringMap>();
+        if (changed)
+            asExtendedType<StringMap>() = stringMap;
         break;
     }
     case StringList: {
-        auto &array = forceAsType<ParentType<StringList>>();
-        array.clear();
-
-        const QStringList &stringList = asExtendedType<StringList>();
-        for (const QString &str : stringList) {
-            ConfigItem *item = newItem();
-            item->value() = str;
-            array.push_back(item);
-        }
+        QStringList stringList;
+        stringList.reserve(snapshot.size());
+        for (int pos = 0; pos < snapshot.size(); ++pos)
+            stringList.push_back(snapshot.at(pos).value().toString());
+        changed = stringList != asExtendedType<StringList>();
+        if (changed)
+            asExtendedType<StringList>() = stringList;
         break;
     }
     case IntList: {
-        auto &array = forceAsType<ParentType<IntList>>();
-        array.clear();
-
-        const QList<int> &intArray = asExtendedType<IntList>();
-        for (int i : intArray) {
-            ConfigItem *item = newItem();
-            item->value() = i;
-            array.push_back(item);
-        }
+        QList<int> intList;
+        intList.reserve(snapshot.size());
+        for (int pos = 0; pos < snapshot.size(); ++pos)
+            intList.push_back(snapshot.at(pos).value().toInt());
+        changed = intList != asExtendedType<IntList>();
+        if (changed)
+            asExtendedType<IntList>() = intList;
         break;
     }
+    case DoubleArray:
+        changed = updatePackedArray(asExtendedType<DoubleArray>(), snapshot, valid);
+        break;
+    case Int64Array:
+        changed = updatePackedArray(asExtendedType<Int64Array>(), snapshot, valid);
+        break;
+    case FloatArray:
+        changed = updatePackedArray(asExtendedType<FloatArray>(), snapshot, valid);
+        break;
+    case UInt8Array:
+        changed = updatePackedArray(asExtendedType<UInt8Array>(), snapshot, valid);
+        break;
     default:
         break;
     }
+
+    // A string, which is no valid encoding, is kept next to the empty array like by the accessors,
+    // so the references returned by them stay valid
+    const QVariant invalidEncoding = valid ? QVariant() : snapshot.value();
+    if ((!valid || hasInvalidEncoding()) && static_cast<const JsonTreeItem *>(this)->value() != invalidEncoding) {
+        setValue(invalidEncoding);
+        changed = true;
+    }
+
+    if (changed)
+        markDirty();
+    return changed;
+}
+
+bool ConfigItem::keepsInvalidEncoding() const
+{
+    if (!hasInvalidEncoding())
+        return false;
+
+    switch (m_extendedType) {
+    case DoubleArray:
+        return asExtendedType<DoubleArray>().isEmpty();
+    case Int64Array:
+        return asExtendedType<Int64Array>().isEmpty();
+    case FloatArray:
+        return asExtendedType<FloatArray>().isEmpty();
+    case UInt8Array:
+        return asExtendedType<UInt8Array>().isEmpty();
+    default:
+        return false;
+    }
+}
+
+bool ConfigItem::exportExtended(JsonTreeItemData::ElementSink &sink) const
+{
+    // A string, which is no valid encoding, is written as it is
+    if (keepsInvalidEncoding())
+        return false;
+
+    // The elements are written straight from the containers, without creating child nodes
+    switch (m_extendedType) {
+    case StringMap: {
+        const QMap<QString, QString> &stringMap = asExtendedType<StringMap>();
+        for (auto it = stringMap.constBegin(); it != stringMap.constEnd(); ++it)
+            sink.addString(it.key(), it.value());
+        return true;
+    }
+    case StringList:
+        for (const QString &str : asExtendedType<StringList>())
+            sink.addString(QString(), str);
+        return true;
+    case IntList:
+        for (int i : asExtendedType<IntList>())
+            sink.addInteger(QString(), i);
+        return true;
+    case DoubleArray:
+        exportPackedArray(asExtendedType<DoubleArray>(), m_base64Encoded, sink);
+        return true;
+    case Int64Array:
+        exportPackedArray(asExtendedType<Int64Array>(), m_base64Encoded, sink);
+        return true;
+    case FloatArray:
+        exportPackedArray(asExtendedType<FloatArray>(), m_base64Encoded, sink);
+        return true;
+    case UInt8Array:
+        exportPackedArray(asExtendedType<UInt8Array>(), m_base64Encoded, sink);
+        return true;
+    default:
+        return false;
+    }
 }
@@ -1,16 +1,22 @@
 #ifndef CONFIGITEM_H
 #define CONFIGITEM_H
 
+#include "jsonpath.h"
 #include "jsontreeitem.h"
 
 namespace ConfigItemData {
 
 // Define available key datatypes
-enum Type {
+enum Type : quint8 {
     None,
     StringMap,  
     StringList, 
-    IntList
+    IntList,
+    // Packed numeric arrays
+    DoubleArray,
+    Int64Array,
+    FloatArray,
+    UInt8Array
 };
 
 template<Type>
@@ -32,6 +38,26 @@ template<> struct TypeTraits<IntList> {
     static constexpr JsonTreeItem::DataType ParentType = JsonTreeItem::Array;
 };
 
+template<> struct TypeTraits<DoubleArray> {
+    using Type = QVector<double>;
+    static constexpr JsonTreeItem::DataType ParentType = JsonTreeItem::Array;
+};
+
+template<> struct TypeTraits<Int64Array> {
+    using Type = QVector<qint64>;
+    static constexpr JsonTreeItem::DataType ParentType = JsonTreeItem::Array;
+};
+
+template<> struct TypeTraits<FloatArray> {
+    using Type = QVector<float>;
+    static constexpr JsonTreeItem::DataType ParentType = JsonTreeItem::Array;
+};
+
+template<> struct TypeTraits<UInt8Array> {
+    using Type = QVector<quint8>;
+    static constexpr JsonTreeItem::DataType ParentType = JsonTreeItem::Array;
+};
+
 }
 
 class ConfigItem : public JsonTreeItem
@@ -49,68 +75,165 @@ public:
     using ParentValueType = typename JsonTreeItem::ValueType<ParentType<_T>>;
 
     // Hier sind die Werte redundant deklariert
-    static constexpr ExtendedType None       = ConfigItemData::None;
-    static constexpr ExtendedType StringMap  = ConfigItemData::StringMap;
-    static constexpr ExtendedType StringList = ConfigItemData::StringList;
-    static constexpr ExtendedType IntList    = ConfigItemData::IntList;
+    static constexpr ExtendedType None        = ConfigItemData::None;
+    static constexpr ExtendedType StringMap   = ConfigItemData::StringMap;
+    static constexpr ExtendedType StringList  = ConfigItemData::StringList;
+    static constexpr ExtendedType IntList     = ConfigItemData::IntList;
+    static constexpr ExtendedType DoubleArray = ConfigItemData::DoubleArray;
+    static constexpr ExtendedType Int64Array  = ConfigItemData::Int64Array;
+    static constexpr ExtendedType FloatArray  = ConfigItemData::FloatArray;
+    static constexpr ExtendedType UInt8Array  = ConfigItemData::UInt8Array;
 
     ConfigItem();
     ~ConfigItem() override { clearExtended(); }
 
-    void clearExtended();
+    void clearExtended() override;
 
     // Load and / or manipulate string to string dictionary
     QMap<QString, QString> &stringMap();
     QMap<QString, QString> &stringMap(const QString &key) { return itemAt(key)->stringMap(); }
     QMap<QString, QString> &stringMap(const QString &objPath, const QString &key) { return itemAt(objPath, key)->stringMap(); }
+    QMap<QString, QString> &stringMap(const JsonPath &path) { return itemAt(path)->stringMap(); }
 
     // Load and / or manipulate string list
     QStringList &stringList();
     QStringList &stringList(const QString &key) { return itemAt(key)->stringList(); }
     QStringList &stringList(const QString &objPath, const QString &key) { return itemAt(objPath, key)->stringList(); }
+    QStringList &stringList(const JsonPath &path) { return itemAt(path)->stringList(); }
 
     // Load and / or manipulate int list
     QList<int> &intList();
     QList<int> &intList(const QString &key) { return itemAt(key)->intList(); }
     QList<int> &intList(const QString &objPath, const QString &key) { return itemAt(objPath, key)->intList(); }
+    QList<int> &intList(const JsonPath &path) { return itemAt(path)->intList(); }
+
+    // Load and / or manipulate packed numeric arrays
+    // The numbers are stored contiguously, with 8 bytes per double or int64, 4 per float and 1 per
+    // uint8 instead of a node per element, so constData() can be handed to vectorized code directly.
+    // The elements are converted like by QVariant, other values become 0. Integers beyond 2^53 are
+    // only exact, if the node has been loaded lazily, as value nodes hold them as double.
+    QVector<double> &doubleArray();
+    QVector<double> &doubleArray(const QString &key) { return itemAt(key)->doubleArray(); }
+    QVector<double> &doubleArray(const QString &objPath, const QString &key) { return itemAt(objPath, key)->doubleArray(); }
+    QVector<double> &doubleArray(const JsonPath &path) { return itemAt(path)->doubleArray(); }
+
+    QVector<qint64> &int64Array();
+    QVector<qint64> &int64Array(const QString &key) { return itemAt(key)->int64Array(); }
+    QVector<qint64> &int64Array(const QString &objPath, const QString &key) { return itemAt(objPath, key)->int64Array(); }
+    QVector<qint64> &int64Array(const JsonPath &path) { return itemAt(path)->int64Array(); }
+
+    QVector<float> &floatArray();
+    QVector<float> &floatArray(const QString &key) { return itemAt(key)->floatArray(); }
+    QVector<float> &floatArray(const QString &objPath, const QString &key) { return itemAt(objPath, key)->floatArray(); }
+    QVector<float> &floatArray(const JsonPath &path) { return itemAt(path)->floatArray(); }
+
+    QVector<quint8> &uint8Array();
+    QVector<quint8> &uint8Array(const QString &key) { return itemAt(key)->uint8Array(); }
+    QVector<quint8> &uint8Array(const QString &objPath, const QString &key) { return itemAt(objPath, key)->uint8Array(); }
+    QVector<quint8> &uint8Array(const JsonPath &path) { return itemAt(path)->uint8Array(); }
+
+    // Save the packed array of this node as a base64 string of its bytes in little endian order
+    // instead of a JSON array, which is much smaller and faster for huge arrays. The accessors load
+    // both forms, a node loaded from a string keeps the encoding. A string, which is no valid encoding
+    // of whole numbers, results in an empty array, but is kept and saved, until elements are added.
+    void setBase64Encoded(bool enabled);
+    bool isBase64Encoded() const { return m_base64Encoded; }
+
+    ConfigItem *clone() const { return static_cast<ConfigItem *>(JsonTreeItem::clone()); }
 
     ConfigItem *objectAt(const QString &objPath) { return static_cast<ConfigItem *>(JsonTreeItem::objectAt(objPath)); }
     const ConfigItem *objectAt(const QString &objPath) const { return static_cast<const ConfigItem *>(JsonTreeItem::objectAt(objPath)); }
 
     ConfigItem *itemAt(const QString &key) { return static_cast<ConfigItem *>(JsonTreeItem::itemAt(key)); }
     ConfigItem *itemAt(const QString &objPath, const QString &key) { return static_cast<ConfigItem *>(JsonTreeItem::itemAt(objPath, key)); }
+    ConfigItem *itemAt(const JsonPath &path) { return static_cast<ConfigItem *>(JsonTreeItem::itemAt(path)); }
 
 protected:
-    ConfigItem *newItem() const override { return new ConfigItem(); }
+    ConfigItem *newItem() const override { return createItem<ConfigItem>(); }
+    ConfigItem *newRoot() const override { return new ConfigItem; }
+    void copyExtended(const JsonTreeItem *source) override;
+    bool hasExtended() const override { return m_extendedType != None; }
+    bool updateExtended(const JsonSnapshot &snapshot) override;
+    bool exportExtended(JsonTreeItemData::ElementSink &sink) const override;
 
 private:
-    void *m_extendedData;
+    // Storage of the extended data, the active member is selected by m_extendedType
+    // With Qt 5 on a 64 bit platform a ConfigItem takes 96 bytes (80 bytes of JsonTreeItem, 8 bytes of
+    // data, the extended type and the encoding flag padded to 8 bytes) and no separate heap block.
+    union ExtendedData
+    {
+        ExtendedData() {}
+        ~ExtendedData() {}
+
+        QMap<QString, QString> stringMap;
+        QStringList stringList;
+        QList<int> intList;
+        QVector<double> doubleArray;
+        QVector<qint64> int64Array;
+        QVector<float> floatArray;
+        QVector<quint8> uint8Array;
+    };
+
+    ExtendedData m_extendedData;
     ExtendedType m_extendedType;
+    bool m_base64Encoded;
+
+    // The packed arrays are the last extended types
+    bool isPackedArray() const { return m_extendedType >= DoubleArray; }
+
+    // Whether the node holds a string next to the encoded packed array, which could not be decoded
+    bool hasInvalidEncoding() const
+    { return isPackedArray() && m_base64Encoded && type() == Value && !static_cast<const JsonTreeItem *>(this)->value().isNull(); }
 
-    void finalizeForExport() override;
+    // Whether the string is saved instead of the packed array, which is the case until elements are
+    // added to it
+    bool keepsInvalidEncoding() const;
+
+    // Accessor of the packed arrays
+    template<ExtendedType _T>
+    ValueType<_T> &packedArray();
 
     template<ExtendedType _T>
     ValueType<_T> &asExtendedType()
-    { return *static_cast<ValueType<_T> *>(m_extendedData); }
+    { return *reinterpret_cast<ValueType<_T> *>(&m_extendedData); }
 
     template<ExtendedType _T>
     const ValueType<_T> &asExtendedType() const
-    { return *static_cast<const ValueType<_T> *>(m_extendedData); }
+    { return *reinterpret_cast<const ValueType<_T> *>(&m_extendedData); }
 
-    // Allocate datafield with selected type
+    // Construct datafield with selected type
     template<ExtendedType _T>
     void allocExtendedData()
     {
         if (m_extendedType != None)
             clearExtended();
+        new (&m_extendedData) ValueType<_T>;
         m_extendedType = _T;
-        m_extendedData = new ValueType<_T>;
     }
 
-    // Delete data with selected type
+    // Change the type of the node, which holds the extended data in the form of the selected type
+    // Other than with setType(), the extended data is kept.
+    template<DataType _T>
+    void setBaseType()
+    {
+        const ExtendedType extendedType = m_extendedType;
+        m_extendedType = None;
+        setType<_T>();
+        m_extendedType = extendedType;
+    }
+
+    // Move the elements of the node into the extended data of the selected type
+    // The child nodes are deleted, lazy nodes are parsed into the data without creating them.
+    template<ExtendedType _T>
+    void convertElements();
+
+    // Destruct data with selected type
     template<ExtendedType _T>
     void freeExtendedData()
-    { delete static_cast<ValueType<_T> *>(m_extendedData); }
+    {
+        using ExtendedValueType = ValueType<_T>;
+        asExtendedType<_T>().~ExtendedValueType();
+    }
 };
 
 #endif // CONFIGITEM_H
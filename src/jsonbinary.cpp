@@ -0,0 +1,586 @@
+#include <QtEndian>
+
+#include <cstring>
+#include <limits>
+
+#include "jsonbinary.h"
+#include "jsontreeitem.h"
+
+namespace {
+
+// Floating point numbers are stored with the byte order of an unsigned integer of the same size
+template<int _Size> struct UnsignedOfSize;
+template<> struct UnsignedOfSize<4> { using Type = quint32; };
+template<> struct UnsignedOfSize<8> { using Type = quint64; };
+
+inline qint64 paddedSize(qint64 size)
+{
+    return (size + 3) & ~qint64(3);
+}
+
+}
+
+JsonBinaryWriter::JsonBinaryWriter(QByteArray *buffer)
+    : m_out(buffer),
+      m_elementCount(0)
+{
+}
+
+bool JsonBinaryWriter::write(JsonTreeItem *root)
+{
+    if (root->m_type != JsonTreeItem::Object && root->m_type != JsonTreeItem::Array)
+        return false;
+
+    writeNode(root);
+
+    qint64 stringsSize = 0;
+    for (const QString &str : qAsConst(m_strings))
+        stringsSize += 4 + paddedSize(str.size() * 2);
+
+    char header[JsonBinary::HeaderSize];
+    std::memcpy(header, JsonBinary::Magic, 4);
+    qToLittleEndian<quint32>(JsonBinary::Version, header + 4);
+    qToLittleEndian<quint32>(static_cast<quint32>(m_strings.size()), header + 8);
+    qToLittleEndian<quint32>(static_cast<quint32>(JsonBinary::HeaderSize + stringsSize), header + 12);
+
+    m_out->reserve(static_cast<int>(m_out->size() + JsonBinary::HeaderSize + stringsSize + m_nodes.size()));
+    m_out->append(header, JsonBinary::HeaderSize);
+
+    for (const QString &str : qAsConst(m_strings)) {
+        char length[4];
+        qToLittleEndian<quint32>(static_cast<quint32>(str.size()), length);
+        m_out->append(length, 4);
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        m_out->append(reinterpret_cast<const char *>(str.utf16()), str.size() * 2);
+#else
+        for (int i = 0; i < str.size(); ++i) {
+            char unit[2];
+            qToLittleEndian<quint16>(str.at(i).unicode(), unit);
+            m_out->append(unit, 2);
+        }
+#endif
+        const int padding = static_cast<int>(paddedSize(str.size() * 2)) - str.size() * 2;
+        if (padding > 0)
+            m_out->append(QByteArray(padding, '\0'));
+    }
+
+    m_out->append(m_nodes);
+    return true;
+}
+
+void JsonBinaryWriter::writeNode(JsonTreeItem *item)
+{
+    switch (item->m_type) {
+    case JsonTreeItem::Value:
+        if (!item->exportExtended(*this))
+            writeValue(item->asType<JsonTreeItem::Value>());
+        break;
+    case JsonTreeItem::Object: {
+        writeTag(JsonBinary::Object);
+
+        // Keys without a type are not exported, so the count is known only afterwards
+        const int countPos = m_nodes.size();
+        writeNumber<quint32>(0);
+
+        // The data of derived classes is written in place of the child nodes
+        m_elementCount = 0;
+        quint32 count = 0;
+        if (item->exportExtended(*this)) {
+            count = m_elementCount;
+        } else {
+            for (JsonTreeItem *child : qAsConst(item->asType<JsonTreeItem::Object>())) {
+                if (child->m_type == JsonTreeItem::None)
+                    continue;
+                writeString(child->m_key);
+                writeNode(child);
+                ++count;
+            }
+        }
+        qToLittleEndian<quint32>(count, m_nodes.data() + countPos);
+        break;
+    }
+    case JsonTreeItem::Array: {
+        writeTag(JsonBinary::Array);
+        const int countPos = m_nodes.size();
+        writeNumber<quint32>(0);
+
+        m_elementCount = 0;
+        quint32 count = 0;
+        if (item->exportExtended(*this)) {
+            count = m_elementCount;
+        } else {
+            const QVector<JsonTreeItem *> &children = item->asType<JsonTreeItem::Array>();
+            for (JsonTreeItem *child : children)
+                writeNode(child);
+            count = static_cast<quint32>(children.size());
+        }
+        qToLittleEndian<quint32>(count, m_nodes.data() + countPos);
+        break;
+    }
+    default:
+        writeTag(JsonBinary::Null);
+        break;
+    }
+}
+
+void JsonBinaryWriter::writeValue(const QVariant &value)
+{
+    switch (static_cast<int>(value.type())) {
+    case QVariant::Invalid:
+        writeTag(JsonBinary::Null);
+        break;
+    case QVariant::Bool:
+        writeTag(value.toBool() ? JsonBinary::True : JsonBinary::False);
+        break;
+    case QVariant::Int:
+        writeTag(JsonBinary::Int);
+        writeNumber<qint32>(value.toInt());
+        break;
+    case QVariant::UInt:
+        writeTag(JsonBinary::UInt);
+        writeNumber<quint32>(value.toUInt());
+        break;
+    case QVariant::LongLong:
+        writeTag(JsonBinary::LongLong);
+        writeNumber<qint64>(value.toLongLong());
+        break;
+    case QVariant::ULongLong:
+        writeTag(JsonBinary::ULongLong);
+        writeNumber<quint64>(value.toULongLong());
+        break;
+    case QMetaType::Float:
+        writeTag(JsonBinary::Float);
+        writeNumber<float>(value.toFloat());
+        break;
+    case QVariant::Double:
+        writeTag(JsonBinary::Double);
+        writeNumber<double>(value.toDouble());
+        break;
+    case QVariant::ByteArray: {
+        const QByteArray data = value.toByteArray();
+        writeTag(JsonBinary::ByteArray);
+        writeNumber<quint32>(static_cast<quint32>(data.size()));
+        m_nodes.append(data);
+        break;
+    }
+    case QVariant::StringList: {
+        const QStringList list = value.toStringList();
+        writeTag(JsonBinary::StringList);
+        writeNumber<quint32>(static_cast<quint32>(list.size()));
+        for (const QString &str : list)
+            writeString(str);
+        break;
+    }
+    case QVariant::List: {
+        const QVariantList list = value.toList();
+        writeTag(JsonBinary::List);
+        writeNumber<quint32>(static_cast<quint32>(list.size()));
+        for (const QVariant &element : list)
+            writeValue(element);
+        break;
+    }
+    case QVariant::Map: {
+        const QVariantMap map = value.toMap();
+        writeTag(JsonBinary::Map);
+        writeNumber<quint32>(static_cast<quint32>(map.size()));
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            writeString(it.key());
+            writeValue(it.value());
+        }
+        break;
+    }
+    default:
+        // Strings and all other types, which can be converted to a string
+        writeTag(JsonBinary::String);
+        writeString(value.toString());
+        break;
+    }
+}
+
+void JsonBinaryWriter::addValue(const QString &key, const QVariant &value)
+{
+    if (!key.isNull())
+        writeString(key);
+    writeValue(value);
+    ++m_elementCount;
+}
+
+void JsonBinaryWriter::addString(const QString &key, const QString &str)
+{
+    if (!key.isNull())
+        writeString(key);
+    writeTag(JsonBinary::String);
+    writeString(str);
+    ++m_elementCount;
+}
+
+void JsonBinaryWriter::addInteger(const QString &key, qint64 number)
+{
+    if (!key.isNull())
+        writeString(key);
+    if (number >= std::numeric_limits<qint32>::min() && number <= std::numeric_limits<qint32>::max()) {
+        writeTag(JsonBinary::Int);
+        writeNumber<qint32>(static_cast<qint32>(number));
+    } else {
+        writeTag(JsonBinary::LongLong);
+        writeNumber<qint64>(number);
+    }
+    ++m_elementCount;
+}
+
+void JsonBinaryWriter::addDouble(const QString &key, double number)
+{
+    if (!key.isNull())
+        writeString(key);
+    writeTag(JsonBinary::Double);
+    writeNumber<double>(number);
+    ++m_elementCount;
+}
+
+void JsonBinaryWriter::addFloat(const QString &key, float number)
+{
+    if (!key.isNull())
+        writeString(key);
+    writeTag(JsonBinary::Float);
+    writeNumber<float>(number);
+    ++m_elementCount;
+}
+
+void JsonBinaryWriter::writeString(const QString &str)
+{
+    auto it = m_stringIndex.find(str);
+    if (it == m_stringIndex.end()) {
+        it = m_stringIndex.insert(str, static_cast<quint32>(m_strings.size()));
+        m_strings.push_back(str);
+    }
+    writeNumber<quint32>(it.value());
+}
+
+template<typename _T>
+void JsonBinaryWriter::writeNumber(_T number)
+{
+    using Bits = typename UnsignedOfSize<sizeof(_T)>::Type;
+    Bits bits;
+    std::memcpy(&bits, &number, sizeof(_T));
+
+    char data[sizeof(_T)];
+    qToLittleEndian<Bits>(bits, data);
+    m_nodes.append(data, sizeof(_T));
+}
+
+JsonBinaryReader::JsonBinaryReader(const char *data, qint64 size)
+    : m_begin(data),
+      m_end(data + size),
+      m_pos(data),
+      m_depth(0),
+      m_error(JsonParseError::NoError)
+{
+}
+
+bool JsonBinaryReader::read(JsonTreeItem *target, JsonParseError *error)
+{
+    bool ok = false;
+    quint32 stringCount = 0;
+    quint32 rootOffset = 0;
+
+    if (m_end - m_begin < JsonBinary::HeaderSize || std::memcmp(m_begin, JsonBinary::Magic, 4) != 0) {
+        fail(JsonParseError::InvalidBinary);
+    } else if (qFromLittleEndian<quint32>(m_begin + 4) != JsonBinary::Version) {
+        fail(JsonParseError::UnsupportedVersion);
+    } else {
+        stringCount = qFromLittleEndian<quint32>(m_begin + 8);
+        rootOffset = qFromLittleEndian<quint32>(m_begin + 12);
+        m_pos = m_begin + JsonBinary::HeaderSize;
+
+        if (!readStrings(stringCount)) {
+            // The error has been set
+        } else if (m_pos - m_begin != rootOffset || m_pos == m_end) {
+            fail(JsonParseError::InvalidBinary);
+        } else if (*m_pos != JsonBinary::Object && *m_pos != JsonBinary::Array) {
+            fail(JsonParseError::MissingContainer);
+        } else if (readNode(target)) {
+            if (m_pos == m_end)
+                ok = true;
+            else
+                fail(JsonParseError::TrailingCharacters);
+        }
+    }
+
+    if (error) {
+        error->error = m_error;
+        error->offset = m_pos - m_begin;
+        error->line = 0;
+        error->column = 0;
+    }
+    return ok;
+}
+
+bool JsonBinaryReader::readStrings(quint32 count)
+{
+    // Each string takes at least its length
+    if (count > (m_end - m_pos) / 4)
+        return fail(JsonParseError::InvalidBinary);
+
+    m_strings.reserve(static_cast<int>(count));
+    for (quint32 i = 0; i < count; ++i) {
+        quint32 length;
+        if (!readNumber(length))
+            return false;
+
+        const qint64 size = paddedSize(qint64(length) * 2);
+        if (size > m_end - m_pos)
+            return fail(JsonParseError::InvalidBinary);
+
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        // The string table starts at a multiple of 4 bytes, so the code units are aligned
+        m_strings.push_back(QString(reinterpret_cast<const QChar *>(m_pos), static_cast<int>(length)));
+#else
+        QString str(static_cast<int>(length), Qt::Uninitialized);
+        for (quint32 j = 0; j < length; ++j)
+            str[j] = QChar(qFromLittleEndian<quint16>(m_pos + 2 * j));
+        m_strings.push_back(str);
+#endif
+        m_pos += size;
+    }
+
+    return true;
+}
+
+bool JsonBinaryReader::readNode(JsonTreeItem *item)
+{
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+
+    switch (*m_pos) {
+    case JsonBinary::Object: {
+        if (++m_depth > JsonParser::MaxDepth)
+            return fail(JsonParseError::DepthExceeded);
+        ++m_pos;
+
+        quint32 count;
+        if (!readCount(count))
+            return false;
+
+        item->allocData<JsonTreeItem::Object>();
+        item->asType<JsonTreeItem::Object>().reserve(static_cast<int>(count));
+
+        // Keys are taken over as they are, duplicate keys in the snapshot are not merged
+        for (quint32 i = 0; i < count; ++i) {
+            QString key;
+            if (!readString(key))
+                return false;
+
+            JsonTreeItem *child = item->newItem();
+            child->assignKey(key);
+            item->insertChild(child);
+            if (!readNode(child))
+                return false;
+        }
+
+        --m_depth;
+        return true;
+    }
+    case JsonBinary::Array: {
+        if (++m_depth > JsonParser::MaxDepth)
+            return fail(JsonParseError::DepthExceeded);
+        ++m_pos;
+
+        quint32 count;
+        if (!readCount(count))
+            return false;
+
+        item->allocData<JsonTreeItem::Array>();
+        item->asType<JsonTreeItem::Array>().reserve(static_cast<int>(count));
+
+        for (quint32 i = 0; i < count; ++i) {
+            JsonTreeItem *child = item->newItem();
+            item->insertChild(child);
+            if (!readNode(child))
+                return false;
+        }
+
+        --m_depth;
+        return true;
+    }
+    default:
+        item->allocData<JsonTreeItem::Value>();
+        return readValue(item->asType<JsonTreeItem::Value>());
+    }
+}
+
+bool JsonBinaryReader::readValue(QVariant &value)
+{
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+
+    switch (*m_pos++) {
+    case JsonBinary::Null:
+        value = QVariant();
+        return true;
+    case JsonBinary::False:
+        value = false;
+        return true;
+    case JsonBinary::True:
+        value = true;
+        return true;
+    case JsonBinary::Int: {
+        qint32 number;
+        if (!readNumber(number))
+            return false;
+        value = number;
+        return true;
+    }
+    case JsonBinary::UInt: {
+        quint32 number;
+        if (!readNumber(number))
+            return false;
+        value = number;
+        return true;
+    }
+    case JsonBinary::LongLong: {
+        qint64 number;
+        if (!readNumber(number))
+            return false;
+        value = static_cast<qlonglong>(number);
+        return true;
+    }
+    case JsonBinary::ULongLong: {
+        quint64 number;
+        if (!readNumber(number))
+            return false;
+        value = static_cast<qulonglong>(number);
+        return true;
+    }
+    case JsonBinary::Float: {
+        float number;
+        if (!readNumber(number))
+            return false;
+        value = number;
+        return true;
+    }
+    case JsonBinary::Double: {
+        double number;
+        if (!readNumber(number))
+            return false;
+        value = number;
+        return true;
+    }
+    case JsonBinary::String: {
+        QString str;
+        if (!readString(str))
+            return false;
+        value = str;
+        return true;
+    }
+    case JsonBinary::ByteArray: {
+        quint32 size;
+        if (!readNumber(size))
+            return false;
+        if (size > m_end - m_pos)
+            return fail(JsonParseError::UnexpectedEnd);
+        value = QByteArray(m_pos, static_cast<int>(size));
+        m_pos += size;
+        return true;
+    }
+    case JsonBinary::StringList: {
+        quint32 count;
+        if (!readCount(count))
+            return false;
+        QStringList list;
+        list.reserve(static_cast<int>(count));
+        for (quint32 i = 0; i < count; ++i) {
+            QString str;
+            if (!readString(str))
+                return false;
+            list.push_back(str);
+        }
+        value = list;
+        return true;
+    }
+    case JsonBinary::List: {
+        if (++m_depth > JsonParser::MaxDepth)
+            return fail(JsonParseError::DepthExceeded);
+        quint32 count;
+        if (!readCount(count))
+            return false;
+        QVariantList list;
+        list.reserve(static_cast<int>(count));
+        for (quint32 i = 0; i < count; ++i) {
+            QVariant element;
+            if (!readValue(element))
+                return false;
+            list.push_back(element);
+        }
+        value = list;
+        --m_depth;
+        return true;
+    }
+    case JsonBinary::Map: {
+        if (++m_depth > JsonParser::MaxDepth)
+            return fail(JsonParseError::DepthExceeded);
+        quint32 count;
+        if (!readCount(count))
+            return false;
+        QVariantMap map;
+        for (quint32 i = 0; i < count; ++i) {
+            QString key;
+            if (!readString(key) || !readValue(map[key]))
+                return false;
+        }
+        value = map;
+        --m_depth;
+        return true;
+    }
+    default:
+        --m_pos;
+        return fail(JsonParseError::InvalidBinary);
+    }
+}
+
+bool JsonBinaryReader::readString(QString &str)
+{
+    quint32 index;
+    if (!readNumber(index))
+        return false;
+    if (index >= static_cast<quint32>(m_strings.size())) {
+        m_pos -= 4;
+        return fail(JsonParseError::InvalidBinary);
+    }
+
+    // The string shares its data with the string table
+    str = m_strings.at(static_cast<int>(index));
+    return true;
+}
+
+bool JsonBinaryReader::readCount(quint32 &count)
+{
+    if (!readNumber(count))
+        return false;
+
+    // Each element takes at least one byte, which limits the memory reserved for a corrupt count
+    if (count > m_end - m_pos) {
+        m_pos -= 4;
+        return fail(JsonParseError::InvalidBinary);
+    }
+    return true;
+}
+
+template<typename _T>
+bool JsonBinaryReader::readNumber(_T &number)
+{
+    if (m_end - m_pos < static_cast<qint64>(sizeof(_T)))
+        return fail(JsonParseError::UnexpectedEnd);
+
+    using Bits = typename UnsignedOfSize<sizeof(_T)>::Type;
+    const Bits bits = qFromLittleEndian<Bits>(m_pos);
+    std::memcpy(&number, &bits, sizeof(_T));
+    m_pos += sizeof(_T);
+    return true;
+}
+
+bool JsonBinaryReader::fail(JsonParseError::Error error)
+{
+    m_error = error;
+    return false;
+}
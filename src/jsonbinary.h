@@ -0,0 +1,130 @@
+#ifndef JSONBINARY_H
+#define JSONBINARY_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+#include "jsonparser.h"
+#include "jsontreeitem.h"
+
+
+// Compact binary snapshot of a tree, which is loaded much faster than the JSON text
+// All integers are little endian. The snapshot consists of:
+//   header:  magic "JTBS", quint32 version, quint32 number of strings, quint32 offset of the root
+//   strings: quint32 length in UTF-16 code units and the code units, padded to 4 bytes
+//   nodes:   pre-order, each node is a tag byte followed by its payload, strings are referenced by
+//            their quint32 index in the string table, objects and arrays by a quint32 element count
+// Keys and strings are stored once, so the loaded nodes share them. Values keep their QVariant type
+// (e.g. int, qlonglong, double), while the JSON parser reads all numbers as double. Variant types,
+// which have no tag, are stored as string like in JSON.
+namespace JsonBinary {
+
+static constexpr char Magic[4] = {'J', 'T', 'B', 'S'};
+
+// Snapshots of other versions are rejected, the version has to be incremented on each change of
+// the layout
+static constexpr quint32 Version = 1;
+
+static constexpr int HeaderSize = 16;
+
+enum Tag : quint8 {
+    // Values of Value nodes
+    Null,
+    False,
+    True,
+    Int,
+    UInt,
+    LongLong,
+    ULongLong,
+    Float,
+    Double,
+    String,
+    ByteArray,
+    // Objects and arrays of the tree, an object is followed by a key index in front of each element
+    Object,
+    Array,
+    // Variant lists and maps, which are held by a single Value node
+    List,
+    Map,
+    StringList
+};
+
+}
+
+// Writer of binary snapshots
+// The nodes are written in a single pass into a separate buffer, which is appended behind the
+// string table, when the tree is complete.
+class JsonBinaryWriter : private JsonTreeItemData::ElementSink
+{
+public:
+    // The snapshot is appended to the buffer
+    explicit JsonBinaryWriter(QByteArray *buffer);
+
+    // Write the tree, the root has to be an Object or an Array
+    // Lazy nodes are materialized by this.
+    bool write(JsonTreeItem *root);
+
+private:
+    QByteArray *m_out;
+    QByteArray m_nodes;
+
+    QHash<QString, quint32> m_stringIndex;
+    QVector<QString> m_strings;
+
+    // Number of elements, which have been passed by the derived class of the current node
+    quint32 m_elementCount;
+
+    void writeNode(JsonTreeItem *item);
+    void writeValue(const QVariant &value);
+    void writeString(const QString &str);
+
+    template<typename _T>
+    void writeNumber(_T number);
+
+    void writeTag(JsonBinary::Tag tag) { m_nodes.append(static_cast<char>(tag)); }
+
+    // Elements of the data of derived classes, which are written in place of the child nodes
+    void addValue(const QString &key, const QVariant &value) override;
+    void addString(const QString &key, const QString &str) override;
+    void addInteger(const QString &key, qint64 number) override;
+    void addDouble(const QString &key, double number) override;
+    void addFloat(const QString &key, float number) override;
+};
+
+// Reader of binary snapshots, which creates the nodes of the tree directly like JsonParser
+// Every offset and count is checked against the size of the snapshot, so a corrupt snapshot is
+// reported as error instead of being read out of bounds.
+class JsonBinaryReader
+{
+public:
+    // The data is not copied, it has to stay valid while reading
+    JsonBinaryReader(const char *data, qint64 size);
+
+    // Replace the content of the target node with the snapshot
+    // If an error occurs, the nodes created up to the error position remain in the tree.
+    bool read(JsonTreeItem *target, JsonParseError *error = nullptr);
+
+private:
+    const char *m_begin;
+    const char *m_end;
+    const char *m_pos;
+    int m_depth;
+    JsonParseError::Error m_error;
+
+    QVector<QString> m_strings;
+
+    bool readStrings(quint32 count);
+    bool readNode(JsonTreeItem *item);
+    bool readValue(QVariant &value);
+    bool readString(QString &str);
+    bool readCount(quint32 &count);
+
+    template<typename _T>
+    bool readNumber(_T &number);
+
+    bool fail(JsonParseError::Error error);
+};
+
+#endif // JSONBINARY_H
@@ -0,0 +1,136 @@
+#include <QFile>
+#include <QFileInfo>
+
+#include "jsonfilewatcher.h"
+#include "jsontreeitem.h"
+
+JsonFileWatcher::JsonFileWatcher(JsonTreeItem *tree, const QString &filename)
+    : m_tree(tree),
+      m_filename(QFileInfo(filename).absoluteFilePath()),
+      m_directory(QFileInfo(filename).absolutePath()),
+      m_current(0),
+      m_loaded(false),
+      m_nextId(1)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setInterval(DefaultDebounceInterval);
+
+    // Every notification restarts the timer, so the file is only read, when the writes are done
+    QObject::connect(&m_timer, &QTimer::timeout, &m_timer, [this]() { reload(); });
+    QObject::connect(&m_watcher, &QFileSystemWatcher::fileChanged, &m_timer, [this]() {
+        watchFile();
+        m_timer.start();
+    });
+    QObject::connect(&m_watcher, &QFileSystemWatcher::directoryChanged, &m_timer, [this]() {
+        // Other files in the directory are of no interest
+        if (!m_watcher.files().contains(m_filename) && watchFile())
+            m_timer.start();
+    });
+
+    m_watcher.addPath(m_directory);
+    watchFile();
+}
+
+int JsonFileWatcher::addCallback(const JsonPath &path, const Callback &callback)
+{
+    m_subscriptions.push_back({m_nextId, path, callback});
+    return m_nextId++;
+}
+
+void JsonFileWatcher::removeCallback(int id)
+{
+    for (int pos = 0; pos < m_subscriptions.size(); ++pos) {
+        if (m_subscriptions.at(pos).id == id) {
+            m_subscriptions.remove(pos);
+            return;
+        }
+    }
+}
+
+bool JsonFileWatcher::reload(JsonParseError *error)
+{
+    m_lastError = JsonParseError();
+
+    QFile file(m_filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        m_lastError.error = JsonParseError::FileError;
+        if (error)
+            *error = m_lastError;
+        return false;
+    }
+
+    const QByteArray document = file.readAll();
+    file.close();
+
+    // The document is validated apart from the tree, so that an invalid one leaves it unchanged
+    JsonTreeItem &previous = m_versions[m_current];
+    JsonTreeItem &next = m_versions[1 - m_current];
+    if (!next.loadFromJson(document, &m_lastError, JsonTreeItem::Lazy)) {
+        next.reset();
+        if (error)
+            *error = m_lastError;
+        return false;
+    }
+
+    // On the first reload, the whole tree is compared with the document. As this parses all of it,
+    // the document is loaded lazily again for the comparison with the next one.
+    QVector<JsonPath> changedPaths;
+    if (m_loaded) {
+        m_tree->update(previous, next, &changedPaths);
+    } else {
+        m_tree->update(next, &changedPaths);
+        next.loadFromJson(document, nullptr, JsonTreeItem::Lazy);
+    }
+
+    // The previous document is not needed anymore
+    previous.reset();
+    m_current = 1 - m_current;
+    m_loaded = true;
+
+    if (error)
+        *error = m_lastError;
+
+    if (!changedPaths.isEmpty())
+        notify(changedPaths);
+    return true;
+}
+
+bool JsonFileWatcher::watchFile()
+{
+    if (!QFile::exists(m_filename))
+        return false;
+
+    if (!m_watcher.files().contains(m_filename))
+        m_watcher.addPath(m_filename);
+    return true;
+}
+
+void JsonFileWatcher::notify(const QVector<JsonPath> &changedPaths)
+{
+    // Callbacks may add or remove callbacks
+    const QVector<Subscription> subscriptions = m_subscriptions;
+
+    for (const Subscription &subscription : subscriptions) {
+        QVector<JsonPath> paths;
+        for (const JsonPath &changed : changedPaths) {
+            if (overlaps(subscription.path, changed))
+                paths.push_back(changed);
+        }
+
+        if (!paths.isEmpty())
+            subscription.callback(paths);
+    }
+}
+
+bool JsonFileWatcher::overlaps(const JsonPath &path, const JsonPath &changed)
+{
+    const QStringList &segments = path.segments();
+    const QStringList &changedSegments = changed.segments();
+
+    const int depth = qMin(segments.size(), changedSegments.size());
+    for (int i = 0; i < depth; ++i) {
+        if (segments.at(i) != changedSegments.at(i))
+            return false;
+    }
+    return true;
+}
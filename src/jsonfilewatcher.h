@@ -0,0 +1,91 @@
+#ifndef JSONFILEWATCHER_H
+#define JSONFILEWATCHER_H
+
+#include <QByteArray>
+#include <QFileSystemWatcher>
+#include <QString>
+#include <QTimer>
+#include <QVector>
+
+#include <functional>
+
+#include "jsonparser.h"
+#include "jsonpath.h"
+#include "jsontreeitem.h"
+
+// Reloads a tree, whenever its file is changed on disk
+// The changes between the previous and the reloaded document are applied with JsonTreeItem::update(),
+// so only the nodes, which have changed, are modified and references to the values of the others stay
+// valid. Both documents are loaded lazily, so apart from validating the reloaded document only the
+// changed parts are parsed. Notifications of the file system are debounced, so a burst of writes
+// causes a single reload. A file, which is replaced by a rename like in saveToFile(), is watched
+// again through its directory. Changes of the tree, which have not been saved to the file, are only
+// overwritten, if the file changes in the same place.
+// The watcher has to be used on the thread, which owns the tree, and needs the event loop of it.
+class JsonFileWatcher
+{
+public:
+    // Receives the changed paths of a reload relative to the root of the tree
+    using Callback = std::function<void(const QVector<JsonPath> &changedPaths)>;
+
+    // Milliseconds without further notifications, after which the file is reloaded
+    static constexpr int DefaultDebounceInterval = 100;
+
+    // The tree is not loaded here, reload() loads it initially
+    JsonFileWatcher(JsonTreeItem *tree, const QString &filename);
+
+    JsonFileWatcher(const JsonFileWatcher &) = delete;
+    JsonFileWatcher &operator=(const JsonFileWatcher &) = delete;
+
+    const QString &filename() const { return m_filename; }
+
+    void setDebounceInterval(int msec) { m_timer.setInterval(msec); }
+    int debounceInterval() const { return m_timer.interval(); }
+
+    // Register a callback for the changes at or below the path and those, which replace a node above
+    // it, an empty path receives all changes. After a reload, each callback is called once with all
+    // of its paths, when the whole document has been applied. Returns the id for removeCallback().
+    int addCallback(const JsonPath &path, const Callback &callback);
+    void removeCallback(int id);
+
+    // Read the file and apply the changes to the tree, this is called after the debounce interval
+    // An unchanged document is only validated. If the file cannot be read or the document is invalid,
+    // the tree is unchanged and the error is reported and kept for lastError().
+    bool reload(JsonParseError *error = nullptr);
+
+    const JsonParseError &lastError() const { return m_lastError; }
+
+private:
+    struct Subscription
+    {
+        int id;
+        JsonPath path;
+        Callback callback;
+    };
+
+    JsonTreeItem *m_tree;
+    QString m_filename;
+    QString m_directory;
+    QFileSystemWatcher m_watcher;
+    QTimer m_timer;
+
+    // Lazily loaded documents of the last successful reload and of the one before, which are swapped
+    // by each reload
+    JsonTreeItem m_versions[2];
+    int m_current;
+    bool m_loaded;
+    JsonParseError m_lastError;
+
+    QVector<Subscription> m_subscriptions;
+    int m_nextId;
+
+    // Watch the file again, after it has been replaced, returns whether it exists
+    bool watchFile();
+
+    void notify(const QVector<JsonPath> &changedPaths);
+
+    // Whether one of the paths is at or below the other
+    static bool overlaps(const JsonPath &path, const JsonPath &changed);
+};
+
+#endif // JSONFILEWATCHER_H
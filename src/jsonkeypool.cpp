@@ -0,0 +1,22 @@
+#include "jsonkeypool.h"
+
+quint16 JsonKeyPool::intern(const QString &key)
+{
+    auto it = m_ids.constFind(key);
+    if (it != m_ids.constEnd())
+        return it.value();
+
+    if (m_keys.size() >= MaxKeys)
+        return 0;
+
+    m_keys.push_back(key);
+    const quint16 id = static_cast<quint16>(m_keys.size());
+    m_ids.insert(m_keys.last(), id);
+    return id;
+}
+
+void JsonKeyPool::clear()
+{
+    m_ids.clear();
+    m_keys.clear();
+}
@@ -0,0 +1,42 @@
+#ifndef JSONKEYPOOL_H
+#define JSONKEYPOOL_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Interned object keys of a tree
+// Every distinct key is stored once and numbered from 1, the nodes share the string of the pool and
+// keep its id, so lookups compare ids instead of strings. The id 0 stands for a key, which is not
+// in the pool. Keys stay in the pool until it is cleared, even if no node uses them anymore. Once
+// MaxKeys keys are in the pool, further keys are not interned. The pool is not thread-safe.
+class JsonKeyPool
+{
+public:
+    static constexpr int MaxKeys = 0xffff;
+
+    JsonKeyPool() {}
+
+    JsonKeyPool(const JsonKeyPool &) = delete;
+    JsonKeyPool &operator=(const JsonKeyPool &) = delete;
+
+    // Id of the key, which is added to the pool, if it is not in there yet
+    // Returns 0, if the pool is full.
+    quint16 intern(const QString &key);
+
+    // Id of the key without adding it, 0 if it is not in the pool
+    quint16 id(const QString &key) const { return m_ids.value(key, 0); }
+
+    // Shared string of an id, which is not 0
+    const QString &key(quint16 id) const { return m_keys.at(id - 1); }
+
+    int size() const { return m_keys.size(); }
+
+    void clear();
+
+private:
+    QHash<QString, quint16> m_ids;
+    QVector<QString> m_keys;
+};
+
+#endif // JSONKEYPOOL_H
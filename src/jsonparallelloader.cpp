@@ -0,0 +1,223 @@
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "jsonkeypool.h"
+#include "jsonparallelloader.h"
+#include "jsontreearena.h"
+
+class JsonParallelLoader::Helper : public QRunnable
+{
+public:
+    Helper(JsonParallelLoader *loader, void (JsonParallelLoader::*work)(int), int worker)
+        : m_loader(loader), m_work(work), m_worker(worker), m_finished(false)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        (m_loader->*m_work)(m_worker);
+
+        QMutexLocker locker(&m_mutex);
+        m_finished = true;
+        m_done.wakeAll();
+    }
+
+    // Block until run() has returned
+    void wait()
+    {
+        QMutexLocker locker(&m_mutex);
+        while (!m_finished)
+            m_done.wait(&m_mutex);
+    }
+
+private:
+    JsonParallelLoader *m_loader;
+    void (JsonParallelLoader::*m_work)(int);
+    int m_worker;
+
+    QMutex m_mutex;
+    QWaitCondition m_done;
+    bool m_finished;
+};
+
+JsonParallelLoader::JsonParallelLoader(const char *data, qint64 size)
+    : m_data(data),
+      m_size(size),
+      m_tree(nullptr),
+      m_chunkSize(1)
+{
+}
+
+JsonParallelLoader::~JsonParallelLoader()
+{
+    for (Worker *worker : qAsConst(m_workers)) {
+        delete worker->tree.arena;
+        delete worker->tree.keys;
+        delete worker;
+    }
+}
+
+bool JsonParallelLoader::load(JsonTreeItem *target, JsonParseError *error)
+{
+    JsonParser parser(m_data, m_size);
+
+    const int threads = QThreadPool::globalInstance()->maxThreadCount();
+    if (threads <= 1 || m_size < MinParallelSize)
+        return parser.parse(target, JsonParser::Load, error);
+
+    if (!parser.parse(target, JsonParser::Split, error))
+        return false;
+
+    // A few tasks per thread even out the different sizes of the subtrees
+    m_tree = target->m_tree;
+    collectTasks(target, m_size / (threads * 4));
+    if (m_tasks.isEmpty())
+        return true;
+
+    m_chunkSize = qMax(1, m_tasks.size() / (threads * 16));
+    for (int i = 0; i < threads; ++i) {
+        Worker *worker = new Worker;
+        if (m_tree && m_tree->arena)
+            worker->tree.arena = new JsonTreeArena;
+        if (m_tree && m_tree->keys)
+            worker->tree.keys = new JsonKeyPool;
+        m_workers.push_back(worker);
+    }
+
+    runParallel(&JsonParallelLoader::parseTasks);
+
+    // The keys of all threads are interned in the pool of the tree, before the nodes are mapped to it
+    if (m_tree && m_tree->keys) {
+        for (Worker *worker : qAsConst(m_workers)) {
+            const JsonKeyPool *keys = worker->tree.keys;
+            worker->keyIds.resize(keys->size() + 1);
+            worker->keyIds[0] = 0;
+            for (int id = 1; id <= keys->size(); ++id)
+                worker->keyIds[id] = m_tree->keys->intern(keys->key(static_cast<quint16>(id)));
+        }
+        runParallel(&JsonParallelLoader::mergeTasks);
+    }
+
+    if (m_tree && m_tree->arena) {
+        for (Worker *worker : qAsConst(m_workers))
+            m_tree->arena->adopt(*worker->tree.arena);
+    }
+
+    return true;
+}
+
+void JsonParallelLoader::collectTasks(JsonTreeItem *item, qint64 grain)
+{
+    for (JsonTreeItem *child : qAsConst(item->m_data.children)) {
+        if (!(child->m_flags & JsonTreeItem::LazyNode))
+            continue;
+
+        const JsonTreeItemData::LazyRange range = child->m_data.range;
+        if (range.end - range.begin > grain) {
+            child->materialize();
+            collectTasks(child, grain);
+        } else {
+            m_tasks.push_back(Task{child, item, 0});
+        }
+    }
+}
+
+void JsonParallelLoader::runParallel(void (JsonParallelLoader::*work)(int worker))
+{
+    m_nextChunk.storeRelaxed(0);
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    QVector<Helper *> helpers;
+    for (int worker = 1; worker < m_workers.size(); ++worker) {
+        helpers.push_back(new Helper(this, work, worker));
+        pool->start(helpers.last());
+    }
+
+    (this->*work)(0);
+
+    // Helpers, which have not been started yet, would not find any work anymore. Taking them back
+    // avoids waiting for a busy pool, e.g. if this thread belongs to the pool itself.
+    for (Helper *helper : qAsConst(helpers)) {
+        if (!pool->tryTake(helper))
+            helper->wait();
+        delete helper;
+    }
+}
+
+void JsonParallelLoader::parseTasks(int worker)
+{
+    JsonTreeItemData::Tree *tree = &m_workers.at(worker)->tree;
+    const bool mergeKeys = m_tree && m_tree->keys;
+    Task *tasks = m_tasks.data();
+
+    for (;;) {
+        const int begin = m_nextChunk.fetchAndAddRelaxed(1) * m_chunkSize;
+        if (begin >= m_tasks.size())
+            break;
+
+        const int end = qMin(begin + m_chunkSize, m_tasks.size());
+        for (int i = begin; i < end; ++i) {
+            Task &task = tasks[i];
+            task.worker = worker;
+
+            // The node is detached from its parent, so that nothing outside of the subtree is modified
+            JsonTreeItem *item = task.item;
+            const JsonTreeItemData::LazyRange range = item->m_data.range;
+            item->m_parent = nullptr;
+            item->m_tree = tree;
+            item->m_flags &= ~JsonTreeItem::LazyNode;
+            item->m_type = JsonTreeItem::None;
+
+            // The range has been validated by the first pass
+            JsonParser parser(range.begin, range.end - range.begin);
+            parser.parse(item, JsonParser::Load);
+
+            if (!mergeKeys)
+                finishTask(task);
+        }
+    }
+}
+
+void JsonParallelLoader::mergeTasks(int worker)
+{
+    Q_UNUSED(worker)
+
+    for (;;) {
+        const int begin = m_nextChunk.fetchAndAddRelaxed(1) * m_chunkSize;
+        if (begin >= m_tasks.size())
+            break;
+
+        const int end = qMin(begin + m_chunkSize, m_tasks.size());
+        for (int i = begin; i < end; ++i)
+            finishTask(m_tasks.at(i));
+    }
+}
+
+void JsonParallelLoader::finishTask(const Task &task)
+{
+    const JsonKeyPool *pool = m_tree ? m_tree->keys : nullptr;
+    adoptNodes(task.item, m_tree, pool, m_workers.at(task.worker)->keyIds);
+    task.item->m_parent = task.parent;
+}
+
+void JsonParallelLoader::adoptNodes(JsonTreeItem *item, JsonTreeItemData::Tree *tree, const JsonKeyPool *pool,
+                                    const QVector<quint16> &keyIds)
+{
+    item->m_tree = tree;
+    if (item->m_type != JsonTreeItem::Object && item->m_type != JsonTreeItem::Array)
+        return;
+
+    const bool object = item->m_type == JsonTreeItem::Object;
+    for (JsonTreeItem *child : qAsConst(item->m_data.children)) {
+        if (object && pool) {
+            child->m_keyId = keyIds.at(child->m_keyId);
+            if (child->m_keyId)
+                child->m_key = pool->key(child->m_keyId);
+        }
+        adoptNodes(child, tree, pool, keyIds);
+    }
+}
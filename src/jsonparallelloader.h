@@ -0,0 +1,88 @@
+#ifndef JSONPARALLELLOADER_H
+#define JSONPARALLELLOADER_H
+
+#include <QAtomicInt>
+#include <QVector>
+
+#include "jsonparser.h"
+#include "jsontreeitem.h"
+
+class JsonKeyPool;
+
+// Loader, which parses large documents on several threads
+// A first pass on the calling thread validates the document like lazy loading and creates the child
+// nodes of the root, whose objects and arrays become lazy nodes. Lazy nodes, which are large compared
+// to the document, are split further into their elements. The remaining ranges are parsed into their
+// nodes by the calling thread and the threads of QThreadPool::globalInstance(). The nodes are parsed
+// in place, so the tree is the same as with JsonParser.
+// Each thread allocates its nodes from an arena of its own, if the tree uses one, and interns its
+// keys in a pool of its own. Both are merged into the tree, when all threads are done.
+class JsonParallelLoader
+{
+public:
+    // Documents below this size are parsed on the calling thread only
+    static constexpr qint64 MinParallelSize = 256 * 1024;
+
+    // The data is not copied, it has to stay valid while loading
+    JsonParallelLoader(const char *data, qint64 size);
+    ~JsonParallelLoader();
+
+    JsonParallelLoader(const JsonParallelLoader &) = delete;
+    JsonParallelLoader &operator=(const JsonParallelLoader &) = delete;
+
+    // Replace the content of the target node, which has to be the root, with the document
+    // The number of threads is the maximum thread count of the global thread pool. If the document
+    // is invalid, the error is reported like by JsonParser.
+    bool load(JsonTreeItem *target, JsonParseError *error = nullptr);
+
+private:
+    // Lazy node, which is parsed as a whole by one thread
+    struct Task
+    {
+        JsonTreeItem *item;
+        JsonTreeItem *parent;
+        int worker;
+    };
+
+    // State of a thread, which the nodes refer to until they are merged into the tree
+    struct Worker
+    {
+        JsonTreeItemData::Tree tree;
+        // Ids of the keys in the pool of the tree, indexed by the ids in the pool of the thread
+        QVector<quint16> keyIds;
+    };
+
+    class Helper;
+
+    const char *m_data;
+    qint64 m_size;
+
+    // State of the target tree, a nullptr if the root has none
+    JsonTreeItemData::Tree *m_tree;
+
+    QVector<Task> m_tasks;
+    QVector<Worker *> m_workers;
+
+    // The tasks are taken in chunks of consecutive tasks
+    int m_chunkSize;
+    QAtomicInt m_nextChunk;
+
+    // Collect the lazy child nodes, nodes larger than grain are materialized and split further
+    void collectTasks(JsonTreeItem *item, qint64 grain);
+
+    // Run the work on the calling thread and on helper threads, until all chunks have been taken
+    void runParallel(void (JsonParallelLoader::*work)(int worker));
+
+    // Work of the two phases: parse the tasks and then merge their nodes into the tree
+    void parseTasks(int worker);
+    void mergeTasks(int worker);
+
+    // Attach the nodes of the task to the tree again
+    void finishTask(const Task &task);
+
+    // Let the nodes of the subtree refer to the tree and map their keys to its pool
+    static void adoptNodes(JsonTreeItem *item, JsonTreeItemData::Tree *tree, const JsonKeyPool *pool,
+                           const QVector<quint16> &keyIds);
+};
+
+#endif // JSONPARALLELLOADER_H
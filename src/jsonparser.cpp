@@ -0,0 +1,898 @@
+#include <QByteArray>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+#include "jsonparser.h"
+#include "jsonsimd.h"
+#include "jsontreeitem.h"
+
+namespace {
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Convert an integer, which has been validated by scanNumber(), if it fits into 64 bits
+// Integers with up to 18 digits always fit and are accumulated directly.
+inline bool toInteger(const char *begin, const char *end, qint64 &number)
+{
+    const bool negative = *begin == '-';
+    if (negative)
+        ++begin;
+    if (end - begin > 18)
+        return false;
+
+    qint64 value = 0;
+    for (const char *c = begin; c != end; ++c)
+        value = value * 10 + (*c - '0');
+    number = negative ? -value : value;
+    return true;
+}
+
+// Convert a number, which has been validated by scanNumber()
+// Both conversions don't depend on the locale, std::from_chars doesn't allocate either.
+bool toDouble(const char *begin, const char *end, double &number)
+{
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const std::from_chars_result result = std::from_chars(begin, end, number);
+    return result.ec == std::errc() && result.ptr == end;
+#else
+    bool ok;
+    number = QByteArray(begin, static_cast<int>(end - begin)).toDouble(&ok);
+    return ok;
+#endif
+}
+
+int hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+void appendUtf8(QByteArray &buffer, uint ucs4)
+{
+    if (ucs4 < 0x80) {
+        buffer.append(char(ucs4));
+    } else if (ucs4 < 0x800) {
+        buffer.append(char(0xc0 | (ucs4 >> 6)));
+        buffer.append(char(0x80 | (ucs4 & 0x3f)));
+    } else if (ucs4 < 0x10000) {
+        buffer.append(char(0xe0 | (ucs4 >> 12)));
+        buffer.append(char(0x80 | ((ucs4 >> 6) & 0x3f)));
+        buffer.append(char(0x80 | (ucs4 & 0x3f)));
+    } else {
+        buffer.append(char(0xf0 | (ucs4 >> 18)));
+        buffer.append(char(0x80 | ((ucs4 >> 12) & 0x3f)));
+        buffer.append(char(0x80 | ((ucs4 >> 6) & 0x3f)));
+        buffer.append(char(0x80 | (ucs4 & 0x3f)));
+    }
+}
+
+}
+
+QString JsonParseError::errorString() const
+{
+    QString message;
+
+    switch (error) {
+    case NoError:
+        return QString("no error occurred");
+    case UnexpectedEnd:
+        message = "unexpected end of document";
+        break;
+    case UnexpectedCharacter:
+        message = "unexpected character";
+        break;
+    case MissingContainer:
+        message = "document is neither an object nor an array";
+        break;
+    case InvalidNumber:
+        message = "invalid number";
+        break;
+    case InvalidString:
+        message = "invalid character in string";
+        break;
+    case InvalidEscape:
+        message = "invalid escape sequence";
+        break;
+    case DepthExceeded:
+        message = "maximum nesting depth exceeded";
+        break;
+    case TrailingCharacters:
+        message = "garbage at the end of the document";
+        break;
+    case InvalidUtf8:
+        message = "invalid UTF-8 sequence in string";
+        break;
+    case FileError:
+        return QString("file could not be read");
+    case InvalidBinary:
+        return QString("invalid binary snapshot at offset %1").arg(offset);
+    case UnsupportedVersion:
+        return QString("unsupported version of the binary snapshot");
+    }
+
+    return QString("%1 at line %2, column %3").arg(message).arg(line).arg(column);
+}
+
+JsonParser::JsonParser(const char *data, qint64 size)
+    : m_begin(data),
+      m_end(data + size),
+      m_pos(data),
+      m_depth(0),
+      m_mode(Load),
+      m_error(JsonParseError::NoError)
+{
+}
+
+bool JsonParser::parse(JsonTreeItem *target, Mode mode, JsonParseError *error)
+{
+    m_pos = m_begin;
+    m_depth = 0;
+    m_mode = mode;
+    m_error = JsonParseError::NoError;
+
+    const bool merge = mode == Append;
+    const bool lazy = mode == LazyLoad;
+
+    skipWhitespace();
+    const char *begin = m_pos;
+
+    bool ok;
+    if (m_pos == m_end)
+        ok = fail(JsonParseError::UnexpectedEnd);
+    else if (*m_pos == '{')
+        ok = lazy ? skipObject() : parseObject(target, merge);
+    else if (*m_pos == '[')
+        ok = lazy ? skipArray() : parseArray(target, merge);
+    else
+        ok = fail(JsonParseError::MissingContainer);
+
+    const char *end = m_pos;
+    if (ok) {
+        skipWhitespace();
+        if (m_pos != m_end)
+            ok = fail(JsonParseError::TrailingCharacters);
+    }
+
+    // The whole document has been validated, the target references it now
+    if (ok && lazy)
+        target->setLazy(*begin == '{' ? JsonTreeItem::Object : JsonTreeItem::Array, begin, end);
+
+    fillError(error);
+    return ok;
+}
+
+bool JsonParser::parseElements(JsonTreeItemData::ElementSink &sink, JsonParseError *error)
+{
+    m_pos = m_begin;
+    m_depth = 0;
+    m_mode = Load;
+    m_error = JsonParseError::NoError;
+
+    skipWhitespace();
+
+    bool ok;
+    if (m_pos == m_end)
+        ok = fail(JsonParseError::UnexpectedEnd);
+    else if (*m_pos == '{' || *m_pos == '[')
+        ok = parseElementList(sink);
+    else
+        ok = fail(JsonParseError::MissingContainer);
+
+    if (ok) {
+        skipWhitespace();
+        if (m_pos != m_end)
+            ok = fail(JsonParseError::TrailingCharacters);
+    }
+
+    fillError(error);
+    return ok;
+}
+
+bool JsonParser::parseElementList(JsonTreeItemData::ElementSink &sink)
+{
+    const bool isObject = *m_pos == '{';
+    const char close = isObject ? '}' : ']';
+
+    // Skip the opening brace or bracket
+    ++m_pos;
+    skipWhitespace();
+
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+    if (*m_pos == close) {
+        ++m_pos;
+        return true;
+    }
+
+    // The key stays null for the elements of arrays
+    QString key;
+    for (;;) {
+        if (isObject) {
+            if (m_pos == m_end)
+                return fail(JsonParseError::UnexpectedEnd);
+            if (*m_pos != '"')
+                return fail(JsonParseError::UnexpectedCharacter);
+            if (!parseString(key))
+                return false;
+
+            skipWhitespace();
+            if (m_pos == m_end)
+                return fail(JsonParseError::UnexpectedEnd);
+            if (*m_pos != ':')
+                return fail(JsonParseError::UnexpectedCharacter);
+            ++m_pos;
+            skipWhitespace();
+        }
+
+        if (!parseElement(key, sink))
+            return false;
+
+        skipWhitespace();
+        if (m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+        if (*m_pos == close) {
+            ++m_pos;
+            break;
+        }
+        if (*m_pos != ',')
+            return fail(JsonParseError::UnexpectedCharacter);
+        ++m_pos;
+        skipWhitespace();
+    }
+
+    return true;
+}
+
+bool JsonParser::parseElement(const QString &key, JsonTreeItemData::ElementSink &sink)
+{
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+
+    switch (*m_pos) {
+    case '{':
+    case '[':
+        if (!skipValue())
+            return false;
+        sink.addValue(key, QVariant());
+        return true;
+    case '"': {
+        QString str;
+        if (!parseString(str))
+            return false;
+        sink.addString(key, str);
+        return true;
+    }
+    case 't':
+        if (!parseLiteral("true", 4))
+            return false;
+        sink.addValue(key, true);
+        return true;
+    case 'f':
+        if (!parseLiteral("false", 5))
+            return false;
+        sink.addValue(key, false);
+        return true;
+    case 'n':
+        if (!parseLiteral("null", 4))
+            return false;
+        sink.addValue(key, QVariant());
+        return true;
+    default: {
+        // Integers are passed exactly, as long as they fit into 64 bits, other numbers as double
+        const char *start = m_pos;
+        bool isInteger;
+        if (!scanNumber(isInteger))
+            return false;
+
+        qint64 integer;
+        if (isInteger && toInteger(start, m_pos, integer)) {
+            sink.addInteger(key, integer);
+            return true;
+        }
+
+        double number;
+        if (!toDouble(start, m_pos, number))
+            return fail(JsonParseError::InvalidNumber);
+        sink.addDouble(key, number);
+        return true;
+    }
+    }
+}
+
+bool JsonParser::parseValue(JsonTreeItem *item, bool merge)
+{
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+
+    switch (*m_pos) {
+    case '{':
+        if (m_mode == Materialize)
+            return parseLazy(item);
+        if (m_mode == Split)
+            return skipLazy(item);
+        return parseObject(item, merge);
+    case '[':
+        if (m_mode == Materialize)
+            return parseLazy(item);
+        if (m_mode == Split)
+            return skipLazy(item);
+        return parseArray(item, merge);
+    case '"': {
+        // Scalar values overwrite the node in both modes
+        item->allocData<JsonTreeItem::Value>();
+        QString str;
+        if (!parseString(str))
+            return false;
+        item->asType<JsonTreeItem::Value>() = str;
+        return true;
+    }
+    case 't':
+        item->allocData<JsonTreeItem::Value>();
+        if (!parseLiteral("true", 4))
+            return false;
+        item->asType<JsonTreeItem::Value>() = true;
+        return true;
+    case 'f':
+        item->allocData<JsonTreeItem::Value>();
+        if (!parseLiteral("false", 5))
+            return false;
+        item->asType<JsonTreeItem::Value>() = false;
+        return true;
+    case 'n':
+        // null is represented by an invalid QVariant
+        item->allocData<JsonTreeItem::Value>();
+        return parseLiteral("null", 4);
+    default: {
+        item->allocData<JsonTreeItem::Value>();
+        double number;
+        if (!parseNumber(number))
+            return false;
+        item->asType<JsonTreeItem::Value>() = number;
+        return true;
+    }
+    }
+}
+
+bool JsonParser::parseObject(JsonTreeItem *item, bool merge)
+{
+    if (++m_depth > MaxDepth)
+        return fail(JsonParseError::DepthExceeded);
+
+    if (!merge || item->m_type != JsonTreeItem::Object)
+        item->allocData<JsonTreeItem::Object>();
+
+    // Skip the opening brace
+    ++m_pos;
+    skipWhitespace();
+
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+    if (*m_pos == '}') {
+        ++m_pos;
+        --m_depth;
+        return true;
+    }
+
+    QString key;
+    for (;;) {
+        if (m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+        if (*m_pos != '"')
+            return fail(JsonParseError::UnexpectedCharacter);
+        if (!parseString(key))
+            return false;
+
+        skipWhitespace();
+        if (m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+        if (*m_pos != ':')
+            return fail(JsonParseError::UnexpectedCharacter);
+        ++m_pos;
+        skipWhitespace();
+
+        // An existing key is either merged or, for duplicate keys in a document, overwritten
+        JsonTreeItem *child = item->find(key);
+        if (!child) {
+            child = item->newItem();
+            child->assignKey(key);
+            item->insertChild(child);
+            if (!parseValue(child, false))
+                return false;
+        } else if (!parseValue(child, merge)) {
+            return false;
+        }
+
+        skipWhitespace();
+        if (m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+        if (*m_pos == '}') {
+            ++m_pos;
+            break;
+        }
+        if (*m_pos != ',')
+            return fail(JsonParseError::UnexpectedCharacter);
+        ++m_pos;
+        skipWhitespace();
+    }
+
+    --m_depth;
+    return true;
+}
+
+bool JsonParser::parseArray(JsonTreeItem *item, bool merge)
+{
+    if (++m_depth > MaxDepth)
+        return fail(JsonParseError::DepthExceeded);
+
+    // Merging appends the elements to an existing array
+    if (!merge || item->m_type != JsonTreeItem::Array)
+        item->allocData<JsonTreeItem::Array>();
+
+    // Skip the opening bracket
+    ++m_pos;
+    skipWhitespace();
+
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+    if (*m_pos == ']') {
+        ++m_pos;
+        --m_depth;
+        return true;
+    }
+
+    for (;;) {
+        JsonTreeItem *child = item->newItem();
+        item->insertChild(child);
+        if (!parseValue(child, false))
+            return false;
+
+        skipWhitespace();
+        if (m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+        if (*m_pos == ']') {
+            ++m_pos;
+            break;
+        }
+        if (*m_pos != ',')
+            return fail(JsonParseError::UnexpectedCharacter);
+        ++m_pos;
+        skipWhitespace();
+    }
+
+    --m_depth;
+    return true;
+}
+
+bool JsonParser::parseString(QString &str)
+{
+    // Skip the opening quote
+    const char *start = ++m_pos;
+
+    // Fast path for strings without escape sequences, pure ASCII does not need UTF-8 decoding
+    bool nonAscii = false;
+    m_pos = JsonSimd::scanString(m_pos, m_end, nonAscii);
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+    if (nonAscii && !checkUtf8(start, m_pos))
+        return false;
+
+    if (*m_pos == '"') {
+        const int size = static_cast<int>(m_pos - start);
+        str = nonAscii ? QString::fromUtf8(start, size) : QString::fromLatin1(start, size);
+        ++m_pos;
+        return true;
+    }
+    if (*m_pos == '\\')
+        return parseEscapedString(start, str);
+    return fail(JsonParseError::InvalidString);
+}
+
+bool JsonParser::parseEscapedString(const char *start, QString &str)
+{
+    QByteArray buffer(start, static_cast<int>(m_pos - start));
+
+    while (m_pos != m_end) {
+        // Copy the run up to the next quote, backslash or control character at once
+        const char *run = m_pos;
+        bool nonAscii = false;
+        m_pos = JsonSimd::scanString(m_pos, m_end, nonAscii);
+        if (m_pos == m_end)
+            break;
+        if (nonAscii && !checkUtf8(run, m_pos))
+            return false;
+        buffer.append(run, static_cast<int>(m_pos - run));
+
+        const uchar c = static_cast<uchar>(*m_pos);
+        if (c == '"') {
+            str = QString::fromUtf8(buffer);
+            ++m_pos;
+            return true;
+        }
+        if (c < 0x20)
+            return fail(JsonParseError::InvalidString);
+
+        // Decode the escape sequence
+        if (++m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+
+        switch (*m_pos++) {
+        case '"':  buffer.append('"'); break;
+        case '\\': buffer.append('\\'); break;
+        case '/':  buffer.append('/'); break;
+        case 'b':  buffer.append('\b'); break;
+        case 'f':  buffer.append('\f'); break;
+        case 'n':  buffer.append('\n'); break;
+        case 'r':  buffer.append('\r'); break;
+        case 't':  buffer.append('\t'); break;
+        case 'u': {
+            uint ucs4 = 0;
+            for (int i = 0; i < 4; ++i) {
+                if (m_pos == m_end)
+                    return fail(JsonParseError::UnexpectedEnd);
+                const int digit = hexValue(*m_pos++);
+                if (digit < 0)
+                    return fail(JsonParseError::InvalidEscape);
+                ucs4 = (ucs4 << 4) | static_cast<uint>(digit);
+            }
+
+            // Combine a surrogate pair, which is given by two consecutive escape sequences
+            if (ucs4 >= 0xd800 && ucs4 < 0xdc00 && m_end - m_pos >= 6 && m_pos[0] == '\\' && m_pos[1] == 'u') {
+                uint low = 0;
+                bool valid = true;
+                for (int i = 2; i < 6 && valid; ++i) {
+                    const int digit = hexValue(m_pos[i]);
+                    valid = digit >= 0;
+                    low = (low << 4) | static_cast<uint>(digit);
+                }
+                if (valid && low >= 0xdc00 && low < 0xe000) {
+                    ucs4 = 0x10000 + ((ucs4 - 0xd800) << 10) + (low - 0xdc00);
+                    m_pos += 6;
+                }
+            }
+
+            appendUtf8(buffer, ucs4);
+            break;
+        }
+        default:
+            --m_pos;
+            return fail(JsonParseError::InvalidEscape);
+        }
+    }
+
+    return fail(JsonParseError::UnexpectedEnd);
+}
+
+bool JsonParser::parseNumber(double &number)
+{
+    const char *start = m_pos;
+    bool isInteger;
+    if (!scanNumber(isInteger))
+        return false;
+
+    // Integers with up to 15 digits are exactly representable as double
+    const int digits = static_cast<int>(m_pos - start) - (*start == '-' ? 1 : 0);
+    qint64 integer;
+    if (isInteger && digits <= 15 && toInteger(start, m_pos, integer)) {
+        number = static_cast<double>(integer);
+        return true;
+    }
+
+    if (!toDouble(start, m_pos, number))
+        return fail(JsonParseError::InvalidNumber);
+    return true;
+}
+
+bool JsonParser::scanNumber(bool &isInteger)
+{
+    const char *start = m_pos;
+    isInteger = true;
+
+    if (m_pos != m_end && *m_pos == '-')
+        ++m_pos;
+
+    // Integer part without leading zeros
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+    if (*m_pos == '0') {
+        ++m_pos;
+    } else if (isDigit(*m_pos)) {
+        while (m_pos != m_end && isDigit(*m_pos))
+            ++m_pos;
+    } else {
+        return fail(m_pos == start ? JsonParseError::UnexpectedCharacter : JsonParseError::InvalidNumber);
+    }
+
+    // Fraction
+    if (m_pos != m_end && *m_pos == '.') {
+        isInteger = false;
+        ++m_pos;
+        if (m_pos == m_end || !isDigit(*m_pos))
+            return fail(JsonParseError::InvalidNumber);
+        while (m_pos != m_end && isDigit(*m_pos))
+            ++m_pos;
+    }
+
+    // Exponent
+    if (m_pos != m_end && (*m_pos == 'e' || *m_pos == 'E')) {
+        isInteger = false;
+        ++m_pos;
+        if (m_pos != m_end && (*m_pos == '+' || *m_pos == '-'))
+            ++m_pos;
+        if (m_pos == m_end || !isDigit(*m_pos))
+            return fail(JsonParseError::InvalidNumber);
+        while (m_pos != m_end && isDigit(*m_pos))
+            ++m_pos;
+    }
+
+    return true;
+}
+
+bool JsonParser::parseLiteral(const char *literal, int length)
+{
+    if (m_end - m_pos < length) {
+        m_pos = m_end;
+        return fail(JsonParseError::UnexpectedEnd);
+    }
+
+    for (int i = 0; i < length; ++i, ++m_pos) {
+        if (*m_pos != literal[i])
+            return fail(JsonParseError::UnexpectedCharacter);
+    }
+
+    return true;
+}
+
+bool JsonParser::parseLazy(JsonTreeItem *item)
+{
+    const char *begin = m_pos;
+
+    // Only strings need attention, as they may contain brackets
+    const char *end = JsonSimd::findClosing(m_pos, m_end);
+    if (!end) {
+        m_pos = m_end;
+        return fail(JsonParseError::UnexpectedEnd);
+    }
+
+    m_pos = end;
+    item->setLazy(*begin == '{' ? JsonTreeItem::Object : JsonTreeItem::Array, begin, m_pos);
+    return true;
+}
+
+bool JsonParser::skipLazy(JsonTreeItem *item)
+{
+    const char *begin = m_pos;
+    const bool object = *begin == '{';
+    if (!(object ? skipObject() : skipArray()))
+        return false;
+
+    item->setLazy(object ? JsonTreeItem::Object : JsonTreeItem::Array, begin, m_pos);
+    return true;
+}
+
+bool JsonParser::skipValue()
+{
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+
+    switch (*m_pos) {
+    case '{':
+        return skipObject();
+    case '[':
+        return skipArray();
+    case '"':
+        return skipString();
+    case 't':
+        return parseLiteral("true", 4);
+    case 'f':
+        return parseLiteral("false", 5);
+    case 'n':
+        return parseLiteral("null", 4);
+    default: {
+        bool isInteger;
+        return scanNumber(isInteger);
+    }
+    }
+}
+
+bool JsonParser::skipObject()
+{
+    if (++m_depth > MaxDepth)
+        return fail(JsonParseError::DepthExceeded);
+
+    // Skip the opening brace
+    ++m_pos;
+    skipWhitespace();
+
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+    if (*m_pos == '}') {
+        ++m_pos;
+        --m_depth;
+        return true;
+    }
+
+    for (;;) {
+        if (m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+        if (*m_pos != '"')
+            return fail(JsonParseError::UnexpectedCharacter);
+        if (!skipString())
+            return false;
+
+        skipWhitespace();
+        if (m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+        if (*m_pos != ':')
+            return fail(JsonParseError::UnexpectedCharacter);
+        ++m_pos;
+        skipWhitespace();
+
+        if (!skipValue())
+            return false;
+
+        skipWhitespace();
+        if (m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+        if (*m_pos == '}') {
+            ++m_pos;
+            break;
+        }
+        if (*m_pos != ',')
+            return fail(JsonParseError::UnexpectedCharacter);
+        ++m_pos;
+        skipWhitespace();
+    }
+
+    --m_depth;
+    return true;
+}
+
+bool JsonParser::skipArray()
+{
+    if (++m_depth > MaxDepth)
+        return fail(JsonParseError::DepthExceeded);
+
+    // Skip the opening bracket
+    ++m_pos;
+    skipWhitespace();
+
+    if (m_pos == m_end)
+        return fail(JsonParseError::UnexpectedEnd);
+    if (*m_pos == ']') {
+        ++m_pos;
+        --m_depth;
+        return true;
+    }
+
+    for (;;) {
+        if (!skipValue())
+            return false;
+
+        skipWhitespace();
+        if (m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+        if (*m_pos == ']') {
+            ++m_pos;
+            break;
+        }
+        if (*m_pos != ',')
+            return fail(JsonParseError::UnexpectedCharacter);
+        ++m_pos;
+        skipWhitespace();
+    }
+
+    --m_depth;
+    return true;
+}
+
+bool JsonParser::skipString()
+{
+    // Skip the opening quote
+    ++m_pos;
+
+    // The same checks as in parseString(), so that a lazy load reports the same errors
+    while (m_pos != m_end) {
+        const char *run = m_pos;
+        bool nonAscii = false;
+        m_pos = JsonSimd::scanString(m_pos, m_end, nonAscii);
+        if (m_pos == m_end)
+            break;
+        if (nonAscii && !checkUtf8(run, m_pos))
+            return false;
+
+        const uchar c = static_cast<uchar>(*m_pos);
+        if (c == '"') {
+            ++m_pos;
+            return true;
+        }
+        if (c < 0x20)
+            return fail(JsonParseError::InvalidString);
+
+        // Validate the escape sequence
+        if (++m_pos == m_end)
+            return fail(JsonParseError::UnexpectedEnd);
+
+        switch (*m_pos++) {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            break;
+        case 'u':
+            for (int i = 0; i < 4; ++i) {
+                if (m_pos == m_end)
+                    return fail(JsonParseError::UnexpectedEnd);
+                if (hexValue(*m_pos++) < 0)
+                    return fail(JsonParseError::InvalidEscape);
+            }
+            break;
+        default:
+            --m_pos;
+            return fail(JsonParseError::InvalidEscape);
+        }
+    }
+
+    return fail(JsonParseError::UnexpectedEnd);
+}
+
+void JsonParser::skipWhitespace()
+{
+    m_pos = JsonSimd::skipWhitespace(m_pos, m_end);
+}
+
+bool JsonParser::checkUtf8(const char *begin, const char *end)
+{
+    const char *invalid = JsonSimd::validateUtf8(begin, end);
+    if (invalid == end)
+        return true;
+
+    m_pos = invalid;
+    return fail(JsonParseError::InvalidUtf8);
+}
+
+bool JsonParser::fail(JsonParseError::Error error)
+{
+    m_error = error;
+    return false;
+}
+
+void JsonParser::fillError(JsonParseError *error) const
+{
+    if (!error)
+        return;
+
+    error->error = m_error;
+    error->offset = m_pos - m_begin;
+    error->line = 0;
+    error->column = 0;
+
+    if (m_error == JsonParseError::NoError)
+        return;
+
+    // Lines and columns are only counted in case of an error
+    const char *lineStart = m_begin;
+    int line = 1;
+    for (const char *c = m_begin; c != m_pos; ++c) {
+        if (*c == '\n') {
+            ++line;
+            lineStart = c + 1;
+        }
+    }
+
+    error->line = line;
+    error->column = static_cast<int>(m_pos - lineStart) + 1;
+}
@@ -0,0 +1,133 @@
+#ifndef JSONPARSER_H
+#define JSONPARSER_H
+
+#include <QString>
+
+class JsonTreeItem;
+
+namespace JsonTreeItemData {
+
+class ElementSink;
+
+}
+
+// Description of an error, which occurred while reading a JSON document
+struct JsonParseError
+{
+    enum Error {
+        NoError,
+        UnexpectedEnd,
+        UnexpectedCharacter,
+        MissingContainer,
+        InvalidNumber,
+        InvalidString,
+        InvalidEscape,
+        DepthExceeded,
+        TrailingCharacters,
+        // The file could not be opened or read, offset, line and column are not set
+        FileError,
+        // The binary snapshot is corrupt or has an unsupported version, line and column are not set
+        InvalidBinary,
+        UnsupportedVersion,
+        // A string is not valid UTF-8
+        InvalidUtf8
+    };
+
+    Error error = NoError;
+
+    // Position of the error as byte offset and as line and column, both starting at 1
+    qint64 offset = 0;
+    int line = 0;
+    int column = 0;
+
+    QString errorString() const;
+};
+
+// Single pass parser, which reads a JSON document and creates the nodes of the tree directly
+// New nodes are created with newItem() of their parent, so derived classes of JsonTreeItem get
+// nodes of their own type. The keys of objects keep the order of the document.
+class JsonParser
+{
+public:
+    enum Mode {
+        // Replace the content of the target node with the document
+        Load,
+        // Merge the document into the target node like JsonTreeItem::appendJson()
+        Append,
+        // Validate the document and turn the target node into a lazy node, which references it
+        LazyLoad,
+        // Parse the content of a lazy node, whose range has been validated before, nested objects
+        // and arrays become lazy nodes themselves
+        Materialize,
+        // Validate the document and create the child nodes of the target, whose objects and arrays
+        // become lazy nodes, so that they can be parsed separately (see JsonParallelLoader)
+        Split
+    };
+
+    // Objects and arrays may be nested up to this depth
+    static constexpr int MaxDepth = 1024;
+
+    // The data is not copied, it has to stay valid while parsing
+    JsonParser(const char *data, qint64 size);
+
+    // Parse the document, which has to be an object or an array, into the target node
+    // If an error occurs, the nodes created up to the error position remain in the tree.
+    bool parse(JsonTreeItem *target, Mode mode, JsonParseError *error = nullptr);
+
+    // Pass the elements of the document, which has to be an object or an array, to the sink
+    // without creating nodes (see JsonTreeItem::takeElements()). Nested objects and arrays are
+    // validated and passed as invalid values. Integers, which fit into 64 bits, are passed to
+    // addInteger(), other numbers to addDouble().
+    bool parseElements(JsonTreeItemData::ElementSink &sink, JsonParseError *error = nullptr);
+
+private:
+    const char *m_begin;
+    const char *m_end;
+    const char *m_pos;
+    int m_depth;
+    Mode m_mode;
+    JsonParseError::Error m_error;
+
+    // The parse functions expect m_pos at the first character of the value.
+    // If merge is set, the value is merged into the existing content of the node.
+    bool parseValue(JsonTreeItem *item, bool merge);
+    bool parseObject(JsonTreeItem *item, bool merge);
+    bool parseArray(JsonTreeItem *item, bool merge);
+    bool parseString(QString &str);
+    bool parseNumber(double &number);
+    bool parseLiteral(const char *literal, int length);
+
+    // Functions for parseElements(), which expect m_pos at the first character of the container or
+    // the element
+    bool parseElementList(JsonTreeItemData::ElementSink &sink);
+    bool parseElement(const QString &key, JsonTreeItemData::ElementSink &sink);
+
+    // Find the end of an object or an array, which has been validated before, and turn the node
+    // into a lazy node
+    bool parseLazy(JsonTreeItem *item);
+
+    // Validate an object or an array and turn the node into a lazy node
+    bool skipLazy(JsonTreeItem *item);
+
+    // The skip functions validate a value without creating nodes
+    bool skipValue();
+    bool skipObject();
+    bool skipArray();
+    bool skipString();
+
+    // Validate a number and move m_pos behind it
+    bool scanNumber(bool &isInteger);
+
+    // Decode the remainder of a string, which contains escape sequences
+    bool parseEscapedString(const char *start, QString &str);
+
+    void skipWhitespace();
+
+    // Fail with InvalidUtf8 at the first invalid byte of the range, if there is one
+    bool checkUtf8(const char *begin, const char *end);
+
+    bool fail(JsonParseError::Error error);
+    void fillError(JsonParseError *error) const;
+};
+
+#endif // JSONPARSER_H
@@ -0,0 +1,348 @@
+#include "jsonpatch.h"
+#include "jsontreeitem.h"
+
+void JsonPatch::diff(const JsonSnapshot &from, const JsonSnapshot &to, JsonTreeItem *patch)
+{
+    JsonPatch generator(patch);
+    generator.diffNode(from, to);
+}
+
+void JsonPatch::diffNode(const JsonSnapshot &from, const JsonSnapshot &to)
+{
+    // Unchanged subtrees share their snapshot nodes, equal ones of other trees have equal hashes
+    if (from.isSharedWith(to) || from.hash() == to.hash())
+        return;
+
+    const JsonTreeItem::DataType type = from.type();
+    if (type != to.type() || (type != JsonTreeItem::Object && type != JsonTreeItem::Array)) {
+        addOperation("replace", &to);
+        return;
+    }
+
+    if (type == JsonTreeItem::Object)
+        diffObject(from, to);
+    else
+        diffArray(from, to);
+}
+
+void JsonPatch::diffObject(const JsonSnapshot &from, const JsonSnapshot &to)
+{
+    // Usually the keys are at the same positions in both versions
+    for (int pos = 0; pos < from.size(); ++pos) {
+        const QString key = from.keyAt(pos);
+        const JsonSnapshot element = pos < to.size() && to.keyAt(pos) == key ? to.at(pos) : to.child(key);
+
+        const int size = pushSegment(key);
+        if (element.isNull())
+            addOperation("remove");
+        else
+            diffNode(from.at(pos), element);
+        m_path.truncate(size);
+    }
+
+    for (int pos = 0; pos < to.size(); ++pos) {
+        const QString key = to.keyAt(pos);
+        if ((pos < from.size() && from.keyAt(pos) == key) || !from.child(key).isNull())
+            continue;
+
+        const int size = pushSegment(key);
+        const JsonSnapshot element = to.at(pos);
+        addOperation("add", &element);
+        m_path.truncate(size);
+    }
+}
+
+void JsonPatch::diffArray(const JsonSnapshot &from, const JsonSnapshot &to)
+{
+    auto equal = [](const JsonSnapshot &element, const JsonSnapshot &other) {
+        return element.isSharedWith(other) || element.hash() == other.hash();
+    };
+
+    const int size = from.size();
+    const int toSize = to.size();
+
+    int head = 0;
+    while (head < size && head < toSize && equal(from.at(head), to.at(head)))
+        ++head;
+
+    int tail = 0;
+    while (tail < size - head && tail < toSize - head && equal(from.at(size - 1 - tail), to.at(toSize - 1 - tail)))
+        ++tail;
+
+    // The elements in between are compared by position, the rest is inserted or removed in front of the tail
+    const int count = size - head - tail;
+    const int toCount = toSize - head - tail;
+    const int common = qMin(count, toCount);
+
+    for (int pos = head; pos < head + common; ++pos) {
+        const int pathSize = pushSegment(QString::number(pos));
+        diffNode(from.at(pos), to.at(pos));
+        m_path.truncate(pathSize);
+    }
+
+    for (int pos = head + common; pos < head + toCount; ++pos) {
+        const JsonSnapshot element = to.at(pos);
+        addOperation("add", pos, &element);
+    }
+
+    // Removed from the back, so the positions of the remaining ones do not change
+    for (int pos = head + count - 1; pos >= head + common; --pos)
+        addOperation("remove", pos);
+}
+
+void JsonPatch::addOperation(const QString &op, const JsonSnapshot *value)
+{
+    JsonTreeItem *operation = m_patch->newItem();
+    m_patch->insertChild(operation);
+
+    operation->value("op") = op;
+    operation->value("path") = m_path;
+    if (value)
+        operation->itemAt("value")->restore(*value);
+}
+
+void JsonPatch::addOperation(const QString &op, int pos, const JsonSnapshot *value)
+{
+    const int size = pushSegment(QString::number(pos));
+    addOperation(op, value);
+    m_path.truncate(size);
+}
+
+int JsonPatch::pushSegment(const QString &segment)
+{
+    const int size = m_path.size();
+    m_path += '/';
+    if (segment.contains('~') || segment.contains('/'))
+        m_path += QString(segment).replace("~", "~0").replace("/", "~1");
+    else
+        m_path += segment;
+    return size;
+}
+
+bool JsonPatch::apply(JsonTreeItem *root, JsonTreeItem *patch)
+{
+    if (patch->type() != JsonTreeItem::Array)
+        return false;
+
+    for (JsonTreeItem *operation : patch->asType<JsonTreeItem::Array>()) {
+        if (!applyOperation(root, operation))
+            return false;
+    }
+    return true;
+}
+
+bool JsonPatch::applyOperation(JsonTreeItem *root, JsonTreeItem *operation)
+{
+    if (operation->type() != JsonTreeItem::Object)
+        return false;
+
+    auto member = [operation](const QString &key) {
+        const JsonTreeItem *item = operation->find(key);
+        return item ? item->value() : QVariant();
+    };
+
+    QStringList segments;
+    if (!parsePointer(member("path"), segments))
+        return false;
+
+    const QString op = member("op").toString();
+
+    if (op == "remove") {
+        JsonTreeItem *item = take(root, segments);
+        if (!item)
+            return false;
+        JsonTreeItem::destroyItem(item);
+        return true;
+    }
+
+    if (op == "move" || op == "copy") {
+        QStringList fromSegments;
+        if (!parsePointer(member("from"), fromSegments))
+            return false;
+
+        if (op == "copy") {
+            JsonTreeItem *source = resolve(root, fromSegments, fromSegments.size());
+            return source && add(root, segments, source->snapshot());
+        }
+
+        // A node cannot be moved into its own subtree, moving it onto itself changes nothing
+        if (fromSegments == segments)
+            return resolve(root, segments, segments.size()) != nullptr;
+        if (fromSegments.size() < segments.size() && fromSegments == segments.mid(0, fromSegments.size()))
+            return false;
+
+        JsonTreeItem *item = take(root, fromSegments);
+        return item && insert(root, segments, item);
+    }
+
+    // The remaining operations have a value
+    JsonTreeItem *value = operation->find("value");
+    if (!value)
+        return false;
+
+    if (op == "add")
+        return add(root, segments, value->snapshot());
+
+    if (op == "replace" || op == "test") {
+        JsonTreeItem *item = resolve(root, segments, segments.size());
+        if (!item)
+            return false;
+        if (op == "test")
+            return item->snapshot() == value->snapshot();
+        item->restore(value->snapshot());
+        return true;
+    }
+
+    return false;
+}
+
+bool JsonPatch::parsePointer(const QVariant &pointer, QStringList &segments)
+{
+    if (pointer.userType() != QMetaType::QString)
+        return false;
+
+    // The empty pointer is the root, every other one starts with "/" before each segment
+    const QString str = pointer.toString();
+    if (str.isEmpty()) {
+        segments.clear();
+        return true;
+    }
+    if (!str.startsWith('/'))
+        return false;
+
+    segments = str.mid(1).split('/');
+    for (QString &segment : segments) {
+        for (int pos = segment.indexOf('~'); pos >= 0; pos = segment.indexOf('~', pos + 1)) {
+            if (pos + 1 >= segment.size() || (segment.at(pos + 1) != '0' && segment.at(pos + 1) != '1'))
+                return false;
+        }
+        segment.replace("~1", "/").replace("~0", "~");
+    }
+    return true;
+}
+
+int JsonPatch::arrayPosition(const QString &segment, int size)
+{
+    // Positions are written without leading zeros
+    bool ok;
+    const int pos = segment.toInt(&ok);
+    if (!ok || pos < 0 || pos >= size || QString::number(pos) != segment)
+        return -1;
+    return pos;
+}
+
+JsonTreeItem *JsonPatch::resolve(JsonTreeItem *root, const QStringList &segments, int depth)
+{
+    JsonTreeItem *item = root;
+    for (int i = 0; i < depth; ++i) {
+        expand(item);
+        if (item->type() == JsonTreeItem::Object) {
+            item = item->find(segments.at(i));
+        } else if (item->type() == JsonTreeItem::Array) {
+            const QVector<JsonTreeItem *> &elements = item->asType<JsonTreeItem::Array>();
+            const int pos = arrayPosition(segments.at(i), elements.size());
+            item = pos >= 0 ? elements.at(pos) : nullptr;
+        } else {
+            item = nullptr;
+        }
+
+        if (!item)
+            return nullptr;
+    }
+    return item;
+}
+
+void JsonPatch::expand(JsonTreeItem *item)
+{
+    if ((item->type() != JsonTreeItem::Object && item->type() != JsonTreeItem::Array) || !item->hasExtended())
+        return;
+
+    // The content stays the same, the accessors of the derived class convert the child nodes back
+    const JsonSnapshot snapshot = item->snapshot();
+    item->m_snapshot = JsonSnapshot();
+    item->restore(snapshot);
+}
+
+bool JsonPatch::add(JsonTreeItem *root, const QStringList &segments, const JsonSnapshot &value)
+{
+    if (segments.isEmpty()) {
+        root->restore(value);
+        return true;
+    }
+
+    JsonTreeItem *item = root->newItem();
+    item->restore(value);
+    return insert(root, segments, item);
+}
+
+bool JsonPatch::insert(JsonTreeItem *root, const QStringList &segments, JsonTreeItem *item)
+{
+    // The root takes over the content of the node
+    if (segments.isEmpty()) {
+        root->restore(item->snapshot());
+        JsonTreeItem::destroyItem(item);
+        return true;
+    }
+
+    JsonTreeItem *parent = resolve(root, segments, segments.size() - 1);
+    if (parent)
+        expand(parent);
+
+    const QString &key = segments.last();
+    bool inserted = false;
+    if (parent && parent->type() == JsonTreeItem::Object) {
+        parent->syncIndex();
+        const int pos = parent->indexOf(key);
+        item->assignKey(key);
+        if (pos < 0) {
+            parent->insertChild(item);
+        } else {
+            // The node takes the position of the replaced one, so the index stays valid
+            QVector<JsonTreeItem *> &children = parent->asType<JsonTreeItem::Object>();
+            JsonTreeItem::destroyItem(children.at(pos));
+            children[pos] = item;
+            item->m_parent = parent;
+            parent->bumpGeneration();
+        }
+        inserted = true;
+    } else if (parent && parent->type() == JsonTreeItem::Array) {
+        const int size = parent->asType<JsonTreeItem::Array>().size();
+        const int pos = key == "-" ? size : arrayPosition(key, size + 1);
+        if (pos >= 0) {
+            parent->insertChildAt(pos, item);
+            inserted = true;
+        }
+    }
+
+    if (!inserted) {
+        JsonTreeItem::destroyItem(item);
+        return false;
+    }
+
+    // The fragment of the last output belongs to the previous position of a moved node
+    item->m_fragmentSize = 0;
+    item->m_flags |= JsonTreeItem::ChangedFlags;
+    parent->markDirty();
+    return true;
+}
+
+JsonTreeItem *JsonPatch::take(JsonTreeItem *root, const QStringList &segments)
+{
+    // The root cannot be removed
+    if (segments.isEmpty())
+        return nullptr;
+
+    JsonTreeItem *parent = resolve(root, segments, segments.size() - 1);
+    if (!parent)
+        return nullptr;
+    expand(parent);
+
+    int pos = -1;
+    if (parent->type() == JsonTreeItem::Object) {
+        parent->syncIndex();
+        pos = parent->indexOf(segments.last());
+    } else if (parent->type() == JsonTreeItem::Array) {
+        pos = arrayPosition(segments.last(), parent->asType<JsonTreeItem::Array>().size());
+    }
+    return pos >= 0 ? parent->takeChildAt(pos) : nullptr;
+}
@@ -0,0 +1,67 @@
+#ifndef JSONPATCH_H
+#define JSONPATCH_H
+
+#include <QString>
+#include <QStringList>
+
+#include "jsonsnapshot.h"
+
+class JsonTreeItem;
+
+// Generation and application of JSON Patch documents (RFC 6902) for JsonTreeItem::diff() and
+// JsonTreeItem::applyPatch()
+// The paths of the operations are JSON Pointers (RFC 6901) like "/servers/0/port", in which "~1"
+// stands for "/" and "~0" for "~". The documents are handled as trees, the patch is an array node
+// of operation objects.
+class JsonPatch
+{
+public:
+    // Append the operations, which turn the snapshot from into the snapshot to, to the array node patch
+    // Subtrees with equal hashes are skipped without walking them. Objects are compared by key, arrays
+    // by position after skipping the elements, which are equal at their head and at their tail, so
+    // inserting or removing a single element results in a single operation.
+    static void diff(const JsonSnapshot &from, const JsonSnapshot &to, JsonTreeItem *patch);
+
+    // Apply the operations of the array node patch to the subtree of the root in their order
+    // Returns false at the first operation, which is invalid or fails, the preceding ones are not undone.
+    static bool apply(JsonTreeItem *root, JsonTreeItem *patch);
+
+private:
+    JsonTreeItem *m_patch;
+    // Pointer of the compared nodes
+    QString m_path;
+
+    explicit JsonPatch(JsonTreeItem *patch) : m_patch(patch) {}
+
+    void diffNode(const JsonSnapshot &from, const JsonSnapshot &to);
+    void diffObject(const JsonSnapshot &from, const JsonSnapshot &to);
+    void diffArray(const JsonSnapshot &from, const JsonSnapshot &to);
+
+    // Append an operation at the current path, the value is omitted for a nullptr
+    void addOperation(const QString &op, const JsonSnapshot *value = nullptr);
+    void addOperation(const QString &op, int pos, const JsonSnapshot *value = nullptr);
+
+    // Append a key or a position to the current path, which is truncated to the returned size afterwards
+    int pushSegment(const QString &segment);
+
+    static bool applyOperation(JsonTreeItem *root, JsonTreeItem *operation);
+
+    // Split a pointer into its unescaped segments, returns false, if it is not a valid pointer
+    static bool parsePointer(const QVariant &pointer, QStringList &segments);
+
+    // Position in an array of the size, which is given by the segment, -1 if it is not a valid one
+    static int arrayPosition(const QString &segment, int size);
+
+    // Node at the first depth segments, a nullptr if there is none
+    static JsonTreeItem *resolve(JsonTreeItem *root, const QStringList &segments, int depth);
+
+    // Turn the data of a derived class into child nodes, so the pointers can lead into them
+    static void expand(JsonTreeItem *item);
+
+    // Operations on the node at the segments, add() and insert() replace a member of an object
+    static bool add(JsonTreeItem *root, const QStringList &segments, const JsonSnapshot &value);
+    static bool insert(JsonTreeItem *root, const QStringList &segments, JsonTreeItem *item);
+    static JsonTreeItem *take(JsonTreeItem *root, const QStringList &segments);
+};
+
+#endif // JSONPATCH_H
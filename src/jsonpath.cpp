@@ -0,0 +1,49 @@
+#include "jsonpath.h"
+#include "jsontreeitem.h"
+
+JsonPath::JsonPath(const QString &path)
+    : m_segments(path.split("/", Qt::SkipEmptyParts))
+{
+}
+
+JsonPath::JsonPath(const QString &objPath, const QString &key)
+    : m_segments(objPath.split("/", Qt::SkipEmptyParts))
+{
+    m_segments.push_back(key);
+}
+
+JsonItemHandle::JsonItemHandle()
+    : m_root(nullptr),
+      m_item(nullptr),
+      m_generation(0)
+{
+}
+
+JsonItemHandle::JsonItemHandle(JsonTreeItem *root, const JsonPath &path)
+    : m_root(root),
+      m_path(path),
+      m_item(nullptr),
+      m_generation(0)
+{
+}
+
+JsonTreeItem *JsonItemHandle::item()
+{
+    if (!m_root)
+        return nullptr;
+
+    if (!m_item || m_generation != m_root->generation()) {
+        m_item = m_root->itemAt(m_path);
+        m_generation = m_root->generation();
+    }
+
+    return m_item;
+}
+
+QVariant &JsonItemHandle::value()
+{
+    QVariant &value = item()->value();
+    // A type change of the node itself does not move it, so the cached node stays valid
+    m_generation = m_root->generation();
+    return value;
+}
@@ -0,0 +1,66 @@
+#ifndef JSONPATH_H
+#define JSONPATH_H
+
+#include <QStringList>
+#include <QVariant>
+
+class JsonTreeItem;
+
+// A path to a node in the tree, which is split into its segments only once
+// The last segment is the key, the segments before it form the object path.
+class JsonPath
+{
+public:
+    JsonPath() {}
+
+    // The path is split at every "/", empty segments are skipped
+    explicit JsonPath(const QString &path);
+
+    // Only the object path is split, the key is taken as it is
+    JsonPath(const QString &objPath, const QString &key);
+
+    // The segments are taken as they are, so they may contain "/"
+    explicit JsonPath(const QStringList &segments) : m_segments(segments) {}
+
+    const QStringList &segments() const { return m_segments; }
+
+    bool isEmpty() const { return m_segments.isEmpty(); }
+
+    // Number of segments, which form the object path
+    int objectDepth() const { return m_segments.isEmpty() ? 0 : m_segments.size() - 1; }
+
+    // The key is an empty string for an empty path
+    QString key() const { return m_segments.isEmpty() ? QString() : m_segments.last(); }
+
+    QString toString() const { return m_segments.join("/"); }
+
+    bool operator==(const JsonPath &other) const { return m_segments == other.m_segments; }
+    bool operator!=(const JsonPath &other) const { return m_segments != other.m_segments; }
+
+private:
+    QStringList m_segments;
+};
+
+// A path bound to a tree, which caches the node it resolves to
+// The node is only looked up again, if the structure of the tree below the bound root has changed
+// since the last access, which is detected through its generation counter. Like itemAt(), the
+// handle creates the node if it does not exist. The root has to outlive the handle.
+class JsonItemHandle
+{
+public:
+    JsonItemHandle();
+    JsonItemHandle(JsonTreeItem *root, const JsonPath &path);
+
+    const JsonPath &path() const { return m_path; }
+
+    JsonTreeItem *item();
+    QVariant &value();
+
+private:
+    JsonTreeItem *m_root;
+    JsonPath m_path;
+    JsonTreeItem *m_item;
+    uint m_generation;
+};
+
+#endif // JSONPATH_H
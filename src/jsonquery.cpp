@@ -0,0 +1,119 @@
+#include "jsonpath.h"
+#include "jsonquery.h"
+#include "jsontreeitem.h"
+
+int JsonQuery::addPath(const QString &path)
+{
+    return addSegments(JsonPath(path).segments());
+}
+
+int JsonQuery::addPath(const JsonPath &path)
+{
+    return addSegments(path.segments());
+}
+
+int JsonQuery::addPointer(const QString &pointer)
+{
+    // The empty pointer is the root, every other one starts with "/" before each segment
+    QStringList segments = pointer.split("/");
+    segments.removeFirst();
+    for (QString &segment : segments)
+        segment.replace("~1", "/").replace("~0", "~");
+    return addSegments(segments);
+}
+
+int JsonQuery::addSegments(const QStringList &segments)
+{
+    int node = 0;
+    for (const QString &segment : segments)
+        node = childNode(node, segment);
+
+    m_nodes[node].paths.push_back(m_pathCount);
+    return m_pathCount++;
+}
+
+int JsonQuery::childNode(int node, const QString &key)
+{
+    for (int child : qAsConst(m_nodes.at(node).children)) {
+        if (m_nodes.at(child).key == key)
+            return child;
+    }
+
+    // Positions are written without leading zeros like in JSON Pointer
+    bool ok;
+    int position = key.toInt(&ok);
+    if (!ok || position < 0 || QString::number(position) != key)
+        position = -1;
+
+    m_nodes.push_back(Node{key, position, key == "*", {}, {}});
+    const int child = m_nodes.size() - 1;
+    m_nodes[node].children.push_back(child);
+    return child;
+}
+
+QVector<JsonQuery::Match> JsonQuery::match(const JsonTreeItem &root) const
+{
+    QVector<Match> matches;
+    QStringList captures;
+    resolve(0, &root, captures, matches);
+    return matches;
+}
+
+QVector<QVariant> JsonQuery::values(const JsonTreeItem &root) const
+{
+    QVector<QVariant> values(m_pathCount);
+    QVector<bool> matched(m_pathCount, false);
+    for (const Match &match : match(root)) {
+        if (!matched.at(match.path)) {
+            matched[match.path] = true;
+            values[match.path] = match.item->value();
+        }
+    }
+    return values;
+}
+
+void JsonQuery::resolve(int node, const JsonTreeItem *item, QStringList &captures, QVector<Match> &matches) const
+{
+    const Node &trieNode = m_nodes.at(node);
+    for (int path : trieNode.paths)
+        matches.push_back(Match{path, item, captures});
+
+    if (trieNode.children.isEmpty())
+        return;
+
+    switch (item->type()) {
+    case JsonTreeItem::Object: {
+        for (int child : trieNode.children) {
+            const Node &next = m_nodes.at(child);
+            if (next.wildcard) {
+                for (const JsonTreeItem *element : item->object()) {
+                    captures.push_back(element->key());
+                    resolve(child, element, captures, matches);
+                    captures.pop_back();
+                }
+            } else if (const JsonTreeItem *element = item->itemAt(next.key)) {
+                resolve(child, element, captures, matches);
+            }
+        }
+        break;
+    }
+    case JsonTreeItem::Array: {
+        const JsonTreeItem::ConstChildren elements = item->array();
+        for (int child : trieNode.children) {
+            const Node &next = m_nodes.at(child);
+            if (next.wildcard) {
+                for (int pos = 0; pos < elements.size(); ++pos) {
+                    captures.push_back(QString::number(pos));
+                    resolve(child, elements.at(pos), captures, matches);
+                    captures.pop_back();
+                }
+            } else if (next.position >= 0 && next.position < elements.size()) {
+                resolve(child, elements.at(next.position), captures, matches);
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+}
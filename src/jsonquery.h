@@ -0,0 +1,67 @@
+#ifndef JSONQUERY_H
+#define JSONQUERY_H
+
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class JsonPath;
+class JsonTreeItem;
+
+// Set of paths, which are resolved together in one traversal of a tree
+// The paths are merged into a trie, so the nodes on common prefixes are looked up only once, e.g. the
+// object of 50 keys below "Components" is found once instead of 50 times. A segment "*" is a
+// wildcard, which matches every child of an object or an array. Other segments match a key of an
+// object or a position in an array. Like the const lookups of JsonTreeItem, a query never creates
+// nodes, but it materializes the lazy nodes, which it traverses.
+class JsonQuery
+{
+public:
+    struct Match
+    {
+        // Index of the path, which has been returned by addPath() or addPointer()
+        int path;
+        const JsonTreeItem *item;
+        // Keys or positions of the segments, which have been matched by wildcards
+        QStringList captures;
+    };
+
+    // Add a path, which is split at every "/" like JsonPath, and return its index
+    int addPath(const QString &path);
+    int addPath(const JsonPath &path);
+
+    // Add a JSON Pointer (RFC 6901) like "/servers/0/port", where "~1" stands for "/" and "~0" for "~"
+    int addPointer(const QString &pointer);
+
+    int size() const { return m_pathCount; }
+
+    // All nodes matching the paths, grouped by the trie, i.e. the matches of a path are in the order
+    // of the tree, but the paths are not in the order they have been added
+    QVector<Match> match(const JsonTreeItem &root) const;
+
+    // Value of the first match of each path in the order of the paths, an invalid QVariant for paths
+    // without a match or with a match, which is not a value
+    QVector<QVariant> values(const JsonTreeItem &root) const;
+
+private:
+    // Node of the trie, the root is the first node
+    struct Node
+    {
+        QString key;
+        // Position in an array, if the key is a number, -1 otherwise
+        int position;
+        bool wildcard;
+        QVector<int> children;
+        QVector<int> paths;
+    };
+
+    QVector<Node> m_nodes = {Node{QString(), -1, false, {}, {}}};
+    int m_pathCount = 0;
+
+    int addSegments(const QStringList &segments);
+    int childNode(int node, const QString &key);
+
+    void resolve(int node, const JsonTreeItem *item, QStringList &captures, QVector<Match> &matches) const;
+};
+
+#endif // JSONQUERY_H
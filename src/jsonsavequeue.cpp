@@ -0,0 +1,86 @@
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSaveFile>
+
+#include "jsonsavequeue.h"
+
+class JsonSaveQueue::Task : public QRunnable
+{
+public:
+    Task(JsonSaveQueue *queue, const QString &filename) : m_queue(queue), m_filename(filename) {}
+
+    void run() override { m_queue->process(m_filename); }
+
+private:
+    JsonSaveQueue *m_queue;
+    QString m_filename;
+};
+
+JsonSaveQueue::JsonSaveQueue()
+{
+    // A single thread keeps the writes of a file in order
+    m_pool.setMaxThreadCount(1);
+}
+
+JsonSaveQueue::~JsonSaveQueue()
+{
+    m_pool.waitForDone();
+}
+
+JsonSaveQueue *JsonSaveQueue::instance()
+{
+    // Destroyed at exit, after the remaining documents have been written
+    static JsonSaveQueue queue;
+    return &queue;
+}
+
+QFuture<bool> JsonSaveQueue::enqueue(const QString &filename, const QByteArray &data)
+{
+    const QString path = QFileInfo(filename).absoluteFilePath();
+
+    QMutexLocker locker(&m_mutex);
+
+    auto it = m_pending.find(path);
+    if (it != m_pending.end()) {
+        it->data = data;
+        return it->result.future();
+    }
+
+    Request &request = m_pending[path];
+    request.data = data;
+    request.result.reportStarted();
+    m_pool.start(new Task(this, path));
+    return request.result.future();
+}
+
+void JsonSaveQueue::waitForDone()
+{
+    m_pool.waitForDone();
+}
+
+void JsonSaveQueue::process(const QString &filename)
+{
+    // Requests enqueued from now on get their own write
+    m_mutex.lock();
+    Request request = m_pending.take(filename);
+    m_mutex.unlock();
+
+    const bool ok = writeFile(filename, request.data);
+    request.result.reportResult(ok);
+    request.result.reportFinished();
+}
+
+bool JsonSaveQueue::writeFile(const QString &filename, const QByteArray &data)
+{
+    // The data is written to a temporary file, which is synced to disk and renamed by commit()
+    QSaveFile file(filename);
+    if (!file.open(QSaveFile::WriteOnly))
+        return false;
+
+    // Without commit(), the temporary file is discarded and the file is left unchanged
+    if (file.write(data) != data.size())
+        return false;
+
+    return file.commit();
+}
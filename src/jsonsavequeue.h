@@ -0,0 +1,55 @@
+#ifndef JSONSAVEQUEUE_H
+#define JSONSAVEQUEUE_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QFutureInterface>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <QThreadPool>
+
+// Writes serialized documents to files on a single worker thread
+// Every file is replaced atomically, so it holds either the old or the new document after a crash.
+// Writes are executed in the order they are enqueued. A document, which is enqueued while an older
+// one for the same file is still waiting, replaces the older one, so both requests are completed by
+// a single write.
+class JsonSaveQueue
+{
+public:
+    static JsonSaveQueue *instance();
+
+    JsonSaveQueue(const JsonSaveQueue &) = delete;
+    JsonSaveQueue &operator=(const JsonSaveQueue &) = delete;
+
+    // The future returns whether the file has been written
+    QFuture<bool> enqueue(const QString &filename, const QByteArray &data);
+
+    // Block until all enqueued documents have been written
+    void waitForDone();
+
+    // Write the data to a temporary file, flush it to disk and rename it to the file
+    static bool writeFile(const QString &filename, const QByteArray &data);
+
+private:
+    struct Request
+    {
+        QByteArray data;
+        QFutureInterface<bool> result;
+    };
+
+    class Task;
+
+    JsonSaveQueue();
+    ~JsonSaveQueue();
+
+    // Write the document, which is waiting for the file
+    void process(const QString &filename);
+
+    QMutex m_mutex;
+    // Documents, which have been enqueued, but whose write has not been started yet
+    QHash<QString, Request> m_pending;
+    QThreadPool m_pool;
+};
+
+#endif // JSONSAVEQUEUE_H
@@ -0,0 +1,476 @@
+#include <QtAlgorithms>
+
+#include <cstring>
+
+#include "jsonsimd.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#define JSONSIMD_SSE2
+#if defined(__GNUC__) || defined(__clang__)
+#define JSONSIMD_AVX2
+#endif
+#endif
+
+namespace JsonSimd {
+
+namespace {
+
+inline bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Bit masks of the characters in a block of 64 bytes, bit i stands for byte i
+struct BlockMasks
+{
+    quint64 quote;
+    quint64 backslash;
+    quint64 open;
+    quint64 close;
+};
+
+// Characters, which are escaped by a backslash, carrying an unfinished sequence of backslashes
+// over to the next block (the algorithm of simdjson)
+inline quint64 findEscaped(quint64 backslash, quint64 &prevEscaped)
+{
+    backslash &= ~prevEscaped;
+    const quint64 followsEscape = backslash << 1 | prevEscaped;
+
+    // Sequences of backslashes, which start on an odd bit, are cleared by the addition, so only
+    // the sequences starting on an even bit flip the mask below
+    const quint64 evenBits = 0x5555555555555555ULL;
+    const quint64 oddSequenceStarts = backslash & ~evenBits & ~followsEscape;
+    const quint64 sequencesStartingOnEvenBits = oddSequenceStarts + backslash;
+    prevEscaped = sequencesStartingOnEvenBits < oddSequenceStarts ? 1 : 0;
+
+    const quint64 invertMask = sequencesStartingOnEvenBits << 1;
+    return (evenBits ^ invertMask) & followsEscape;
+}
+
+// Each bit is the XOR of all bits up to it, so the bits between two quotes are set
+inline quint64 prefixXor(quint64 bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+template<typename _Classify>
+const char *findClosingInBlocks(const char *pos, const char *end, _Classify classify)
+{
+    int depth = 0;
+    quint64 prevEscaped = 0;
+    quint64 prevInString = 0;
+
+    for (const char *block = pos; block < end; block += 64) {
+        // The last block is padded with whitespace
+        char padded[64];
+        const char *data = block;
+        if (end - block < 64) {
+            std::memset(padded, ' ', sizeof(padded));
+            std::memcpy(padded, block, static_cast<size_t>(end - block));
+            data = padded;
+        }
+
+        const BlockMasks masks = classify(data);
+        const quint64 quotes = masks.quote & ~findEscaped(masks.backslash, prevEscaped);
+        const quint64 inString = prefixXor(quotes) ^ prevInString;
+        prevInString = static_cast<quint64>(static_cast<qint64>(inString) >> 63);
+
+        for (quint64 structural = (masks.open | masks.close) & ~inString; structural; structural &= structural - 1) {
+            const uint bit = qCountTrailingZeroBits(structural);
+            if (masks.open & (quint64(1) << bit))
+                ++depth;
+            else if (--depth == 0)
+                return block + bit + 1;
+        }
+    }
+
+    return nullptr;
+}
+
+// Scalar implementations, which are also used for the remainders of the vectorized ones
+
+const char *scanStringScalar(const char *pos, const char *end, bool &nonAscii)
+{
+    uchar bits = 0;
+    for (; pos != end; ++pos) {
+        const uchar c = static_cast<uchar>(*pos);
+        if (c == '"' || c == '\\' || c < 0x20)
+            break;
+        bits |= c;
+    }
+    if (bits & 0x80)
+        nonAscii = true;
+    return pos;
+}
+
+const char *skipWhitespaceScalar(const char *pos, const char *end)
+{
+    while (pos != end && isWhitespace(*pos))
+        ++pos;
+    return pos;
+}
+
+// Only strings need attention, as they may contain brackets
+const char *findClosingScalar(const char *pos, const char *end)
+{
+    int depth = 0;
+    while (pos != end) {
+        switch (*pos++) {
+        case '"':
+            while (pos != end && *pos != '"') {
+                if (*pos == '\\' && pos + 1 != end)
+                    ++pos;
+                ++pos;
+            }
+            if (pos != end)
+                ++pos;
+            break;
+        case '{':
+        case '[':
+            ++depth;
+            break;
+        case '}':
+        case ']':
+            if (--depth == 0)
+                return pos;
+            break;
+        default:
+            break;
+        }
+    }
+
+    return nullptr;
+}
+
+// Position behind the UTF-8 sequence at pos, a nullptr if it is invalid
+const char *nextSequence(const char *pos, const char *end)
+{
+    const uchar c = static_cast<uchar>(*pos);
+    if (c < 0x80)
+        return pos + 1;
+
+    int length;
+    uint ucs4;
+    uint minimum;
+    if ((c & 0xe0) == 0xc0) {
+        length = 2;
+        ucs4 = c & 0x1f;
+        minimum = 0x80;
+    } else if ((c & 0xf0) == 0xe0) {
+        length = 3;
+        ucs4 = c & 0x0f;
+        minimum = 0x800;
+    } else if ((c & 0xf8) == 0xf0) {
+        length = 4;
+        ucs4 = c & 0x07;
+        minimum = 0x10000;
+    } else {
+        return nullptr;
+    }
+
+    if (end - pos < length)
+        return nullptr;
+    for (int i = 1; i < length; ++i) {
+        const uchar next = static_cast<uchar>(pos[i]);
+        if ((next & 0xc0) != 0x80)
+            return nullptr;
+        ucs4 = (ucs4 << 6) | (next & 0x3f);
+    }
+
+    if (ucs4 < minimum || ucs4 > 0x10ffff || (ucs4 >= 0xd800 && ucs4 < 0xe000))
+        return nullptr;
+    return pos + length;
+}
+
+const char *validateUtf8Scalar(const char *pos, const char *end)
+{
+    while (pos != end) {
+        const char *next = nextSequence(pos, end);
+        if (!next)
+            return pos;
+        pos = next;
+    }
+
+    return end;
+}
+
+#ifdef JSONSIMD_SSE2
+
+const char *scanStringSse2(const char *pos, const char *end, bool &nonAscii)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1f);
+
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+        // Unsigned comparison c <= 0x1f by max(c, 0x1f) == 0x1f
+        const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                             _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+        const uint specialMask = static_cast<uint>(_mm_movemask_epi8(special));
+        const uint highMask = static_cast<uint>(_mm_movemask_epi8(chunk));
+        if (specialMask) {
+            const uint offset = qCountTrailingZeroBits(specialMask);
+            if (highMask & ((1u << offset) - 1))
+                nonAscii = true;
+            return pos + offset;
+        }
+        if (highMask)
+            nonAscii = true;
+    }
+
+    return scanStringScalar(pos, end, nonAscii);
+}
+
+const char *skipWhitespaceSse2(const char *pos, const char *end)
+{
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+        const __m128i whitespace = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')),
+                                                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+                                                _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+                                                             _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t'))));
+        const uint other = ~static_cast<uint>(_mm_movemask_epi8(whitespace)) & 0xffff;
+        if (other)
+            return pos + qCountTrailingZeroBits(other);
+    }
+
+    return skipWhitespaceScalar(pos, end);
+}
+
+BlockMasks classifySse2(const char *block)
+{
+    BlockMasks masks = {0, 0, 0, 0};
+    // '{' and '[' as well as '}' and ']' only differ in the bit 0x20
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+
+    for (int i = 0; i < 4; ++i) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block + 16 * i));
+        const __m128i folded = _mm_or_si128(chunk, caseBit);
+        const int shift = 16 * i;
+        masks.quote |= quint64(uint(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))))) << shift;
+        masks.backslash |= quint64(uint(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))))) << shift;
+        masks.open |= quint64(uint(_mm_movemask_epi8(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{'))))) << shift;
+        masks.close |= quint64(uint(_mm_movemask_epi8(_mm_cmpeq_epi8(folded, _mm_set1_epi8('}'))))) << shift;
+    }
+
+    return masks;
+}
+
+const char *findClosingSse2(const char *pos, const char *end)
+{
+    return findClosingInBlocks(pos, end, classifySse2);
+}
+
+const char *validateUtf8Sse2(const char *pos, const char *end)
+{
+    // ASCII chunks are skipped, in other chunks the sequences are validated one by one
+    while (end - pos >= 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pos));
+        const uint highMask = static_cast<uint>(_mm_movemask_epi8(chunk));
+        if (!highMask) {
+            pos += 16;
+            continue;
+        }
+
+        // The last sequence may extend into the next chunk
+        const char *chunkEnd = pos + 16;
+        pos += qCountTrailingZeroBits(highMask);
+        while (pos < chunkEnd) {
+            const char *next = nextSequence(pos, end);
+            if (!next)
+                return pos;
+            pos = next;
+        }
+    }
+
+    return validateUtf8Scalar(pos, end);
+}
+
+#endif // JSONSIMD_SSE2
+
+#ifdef JSONSIMD_AVX2
+
+__attribute__((target("avx2")))
+const char *scanStringAvx2(const char *pos, const char *end, bool &nonAscii)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1f);
+
+    for (; end - pos >= 32; pos += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos));
+        const __m256i special = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, quote), _mm256_cmpeq_epi8(chunk, backslash)),
+                                                _mm256_cmpeq_epi8(_mm256_max_epu8(chunk, control), control));
+        const uint specialMask = static_cast<uint>(_mm256_movemask_epi8(special));
+        const uint highMask = static_cast<uint>(_mm256_movemask_epi8(chunk));
+        if (specialMask) {
+            const uint offset = qCountTrailingZeroBits(specialMask);
+            if (highMask & ((quint64(1) << offset) - 1))
+                nonAscii = true;
+            return pos + offset;
+        }
+        if (highMask)
+            nonAscii = true;
+    }
+
+    return scanStringSse2(pos, end, nonAscii);
+}
+
+__attribute__((target("avx2")))
+const char *skipWhitespaceAvx2(const char *pos, const char *end)
+{
+    for (; end - pos >= 32; pos += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(pos));
+        const __m256i whitespace = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')),
+                                                                   _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n'))),
+                                                   _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')),
+                                                                   _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\t'))));
+        const uint other = ~static_cast<uint>(_mm256_movemask_epi8(whitespace));
+        if (other)
+            return pos + qCountTrailingZeroBits(other);
+    }
+
+    return skipWhitespaceSse2(pos, end);
+}
+
+__attribute__((target("avx2")))
+BlockMasks classifyAvx2(const char *block)
+{
+    BlockMasks masks = {0, 0, 0, 0};
+    const __m256i caseBit = _mm256_set1_epi8(0x20);
+
+    for (int i = 0; i < 2; ++i) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(block + 32 * i));
+        const __m256i folded = _mm256_or_si256(chunk, caseBit);
+        const int shift = 32 * i;
+        masks.quote |= quint64(uint(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))))) << shift;
+        masks.backslash |= quint64(uint(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))))) << shift;
+        masks.open |= quint64(uint(_mm256_movemask_epi8(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('{'))))) << shift;
+        masks.close |= quint64(uint(_mm256_movemask_epi8(_mm256_cmpeq_epi8(folded, _mm256_set1_epi8('}'))))) << shift;
+    }
+
+    return masks;
+}
+
+__attribute__((target("avx2")))
+const char *findClosingAvx2(const char *pos, const char *end)
+{
+    return findClosingInBlocks(pos, end, classifyAvx2);
+}
+
+#endif // JSONSIMD_AVX2
+
+struct Functions
+{
+    const char *(*scanString)(const char *, const char *, bool &);
+    const char *(*skipWhitespace)(const char *, const char *);
+    const char *(*findClosing)(const char *, const char *);
+    const char *(*validateUtf8)(const char *, const char *);
+};
+
+const Functions scalarFunctions = {scanStringScalar, skipWhitespaceScalar, findClosingScalar, validateUtf8Scalar};
+#ifdef JSONSIMD_SSE2
+const Functions sse2Functions = {scanStringSse2, skipWhitespaceSse2, findClosingSse2, validateUtf8Sse2};
+#endif
+#ifdef JSONSIMD_AVX2
+const Functions avx2Functions = {scanStringAvx2, skipWhitespaceAvx2, findClosingAvx2, validateUtf8Sse2};
+#endif
+
+Level detectLevel()
+{
+#ifdef JSONSIMD_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return Avx2;
+#endif
+#ifdef JSONSIMD_SSE2
+    return Sse2;
+#else
+    return Scalar;
+#endif
+}
+
+const Functions *functionsOf(Level level)
+{
+    switch (level) {
+#ifdef JSONSIMD_AVX2
+    case Avx2:
+        return &avx2Functions;
+#endif
+#ifdef JSONSIMD_SSE2
+    case Sse2:
+        return &sse2Functions;
+#endif
+    default:
+        return &scalarFunctions;
+    }
+}
+
+// The scalar functions are used until the initializer below has run, e.g. if a document is parsed
+// while other static objects are constructed
+Level bestLevel = Scalar;
+Level currentLevel = Scalar;
+const Functions *functions = &scalarFunctions;
+
+struct Initializer
+{
+    Initializer()
+    {
+        bestLevel = currentLevel = detectLevel();
+        functions = functionsOf(bestLevel);
+    }
+} initializer;
+
+}
+
+Level level()
+{
+    return currentLevel;
+}
+
+Level supportedLevel()
+{
+    return bestLevel;
+}
+
+void setLevel(Level level)
+{
+    currentLevel = qMin(level, bestLevel);
+    functions = functionsOf(currentLevel);
+}
+
+const char *scanString(const char *pos, const char *end, bool &nonAscii)
+{
+    return functions->scanString(pos, end, nonAscii);
+}
+
+const char *skipWhitespace(const char *pos, const char *end)
+{
+    // Most runs of whitespace are a single space, which is not worth loading a vector for
+    if (pos == end || !isWhitespace(*pos))
+        return pos;
+    ++pos;
+    if (pos == end || !isWhitespace(*pos))
+        return pos;
+    return functions->skipWhitespace(pos, end);
+}
+
+const char *findClosing(const char *pos, const char *end)
+{
+    return functions->findClosing(pos, end);
+}
+
+const char *validateUtf8(const char *pos, const char *end)
+{
+    return functions->validateUtf8(pos, end);
+}
+
+}
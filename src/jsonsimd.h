@@ -0,0 +1,46 @@
+#ifndef JSONSIMD_H
+#define JSONSIMD_H
+
+#include <QtGlobal>
+
+// Vectorized scanning of JSON text for JsonParser
+// The functions process 16 bytes (SSE2) or 32 bytes (AVX2) at once. The instruction set is picked at
+// runtime from the features of the processor, other processors use a scalar fallback. All levels
+// give the same results.
+namespace JsonSimd {
+
+enum Level {
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// Level, which is used by the functions
+Level level();
+
+// Best level, which is supported by the processor
+Level supportedLevel();
+
+// Use another level, e.g. to compare them in tests and benchmarks
+// Levels above supportedLevel() are lowered to it. This must not be called while parsing.
+void setLevel(Level level);
+
+// Position of the first quote, backslash or control character, end if there is none
+// nonAscii is set, if a byte before that position has its high bit set.
+const char *scanString(const char *pos, const char *end, bool &nonAscii);
+
+// Position of the first character, which is not JSON whitespace, end if there is none
+const char *skipWhitespace(const char *pos, const char *end);
+
+// Position behind the bracket, which closes the object or array at pos, a nullptr if there is none
+// The text is classified in blocks of 64 bytes into quotes, backslashes and brackets. Only brackets
+// outside of strings are visited, so the object or array must have been validated before.
+const char *findClosing(const char *pos, const char *end);
+
+// Position of the first byte, which does not start a valid UTF-8 sequence, end if the text is valid
+// Overlong encodings, surrogates and code points above U+10FFFF are invalid.
+const char *validateUtf8(const char *pos, const char *end);
+
+}
+
+#endif // JSONSIMD_H
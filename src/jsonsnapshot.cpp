@@ -0,0 +1,274 @@
+#include <cstring>
+
+#include "jsonpath.h"
+#include "jsonsnapshot.h"
+#include "jsontreeitem.h"
+
+JsonSnapshot::JsonSnapshot()
+{
+}
+
+JsonSnapshot::JsonSnapshot(JsonSnapshotData *data)
+    : d(data)
+{
+}
+
+JsonSnapshot::JsonSnapshot(const JsonSnapshot &other) = default;
+JsonSnapshot::JsonSnapshot(JsonSnapshot &&other) noexcept = default;
+JsonSnapshot::~JsonSnapshot() = default;
+
+JsonSnapshot &JsonSnapshot::operator=(const JsonSnapshot &other) = default;
+JsonSnapshot &JsonSnapshot::operator=(JsonSnapshot &&other) noexcept = default;
+
+JsonSnapshot::DataType JsonSnapshot::type() const
+{
+    return d ? d->type : JsonTreeItem::None;
+}
+
+QVariant JsonSnapshot::value() const
+{
+    return d && d->type == JsonTreeItem::Value ? d->value : QVariant();
+}
+
+QVariant JsonSnapshot::value(const QString &objPath, const QString &key) const
+{
+    return itemAt(objPath, key).value();
+}
+
+QVariant JsonSnapshot::value(const JsonPath &path) const
+{
+    return itemAt(path).value();
+}
+
+int JsonSnapshot::size() const
+{
+    return d ? d->children.size() : 0;
+}
+
+JsonSnapshot JsonSnapshot::at(int pos) const
+{
+    return d && pos >= 0 && pos < d->children.size() ? d->children.at(pos) : JsonSnapshot();
+}
+
+QString JsonSnapshot::keyAt(int pos) const
+{
+    return d && pos >= 0 && pos < d->keys.size() ? d->keys.at(pos) : QString();
+}
+
+JsonSnapshot JsonSnapshot::child(const QString &key) const
+{
+    if (!d || d->type != JsonTreeItem::Object)
+        return JsonSnapshot();
+
+    if (!d->index.isEmpty()) {
+        auto it = d->index.constFind(key);
+        return it != d->index.constEnd() ? d->children.at(it.value()) : JsonSnapshot();
+    }
+
+    const int pos = d->keys.indexOf(key);
+    return pos >= 0 ? d->children.at(pos) : JsonSnapshot();
+}
+
+JsonSnapshot JsonSnapshot::itemAt(const QString &objPath, const QString &key) const
+{
+    const QStringList dirs = objPath.split("/", Qt::SkipEmptyParts);
+    return objectAt(dirs, dirs.size()).child(key);
+}
+
+JsonSnapshot JsonSnapshot::itemAt(const JsonPath &path) const
+{
+    return objectAt(path.segments(), path.objectDepth()).child(path.key());
+}
+
+JsonSnapshot JsonSnapshot::objectAt(const QStringList &segments, int depth) const
+{
+    JsonSnapshot obj = *this;
+    for (int i = 0; i < depth && !obj.isNull(); ++i)
+        obj = obj.child(segments.at(i));
+    return obj;
+}
+
+namespace {
+
+quint64 mixHash(quint64 hash, quint64 value)
+{
+    value *= 0x9e3779b97f4a7c15ULL;
+    value ^= value >> 29;
+    hash = (hash ^ value) * 0xbf58476d1ce4e5b9ULL;
+    return hash ^ (hash >> 32);
+}
+
+// FNV-1a of the UTF-16 code units
+quint64 stringHash(const QString &str)
+{
+    quint64 hash = 0xcbf29ce484222325ULL;
+    const QChar *chars = str.constData();
+    for (int i = 0; i < str.size(); ++i)
+        hash = (hash ^ chars[i].unicode()) * 0x100000001b3ULL;
+    return mixHash(hash, static_cast<quint64>(str.size()));
+}
+
+bool isNumber(int type)
+{
+    switch (type) {
+    case QMetaType::Int:
+    case QMetaType::UInt:
+    case QMetaType::LongLong:
+    case QMetaType::ULongLong:
+    case QMetaType::Double:
+    case QMetaType::Float:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Convert a number into a double, returns false if no double has exactly its value
+bool exactDouble(const QVariant &value, double &number)
+{
+    switch (value.userType()) {
+    case QMetaType::Double:
+    case QMetaType::Float:
+        number = value.toDouble();
+        return true;
+    case QMetaType::ULongLong: {
+        const qulonglong integer = value.toULongLong();
+        number = static_cast<double>(integer);
+        return number < 18446744073709551616.0 && static_cast<qulonglong>(number) == integer;
+    }
+    default: {
+        const qint64 integer = value.toLongLong();
+        number = static_cast<double>(integer);
+        return number < 9223372036854775808.0 && static_cast<qint64>(number) == integer;
+    }
+    }
+}
+
+bool equalValues(const QVariant &value, const QVariant &other)
+{
+    const int type = value.userType();
+    if (isNumber(type) && isNumber(other.userType())) {
+        double number, otherNumber;
+        const bool exact = exactDouble(value, number);
+        if (exact != exactDouble(other, otherNumber))
+            return false;
+        // Integers, which are too large for a double, are compared by their digits
+        return exact ? number == otherNumber : value.toString() == other.toString();
+    }
+    return type == other.userType() && value == other;
+}
+
+// Hash, which is equal for the values equalValues() considers equal
+quint64 valueHash(const QVariant &value)
+{
+    const int type = value.userType();
+    if (isNumber(type)) {
+        double number;
+        if (!exactDouble(value, number))
+            return mixHash(QMetaType::LongLong, stringHash(value.toString()));
+
+        // Zero and negative zero are equal
+        if (number == 0)
+            number = 0;
+        quint64 bits;
+        memcpy(&bits, &number, sizeof(bits));
+        return mixHash(QMetaType::Double, bits);
+    }
+
+    quint64 hash = static_cast<quint64>(type);
+    switch (type) {
+    case QMetaType::UnknownType:
+        return hash;
+    case QMetaType::Bool:
+        return mixHash(hash, value.toBool());
+    case QMetaType::QVariantList:
+    case QMetaType::QStringList:
+        for (const QVariant &element : value.toList())
+            hash = mixHash(hash, valueHash(element));
+        return hash;
+    case QMetaType::QVariantMap: {
+        const QVariantMap map = value.toMap();
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it)
+            hash = mixHash(mixHash(hash, stringHash(it.key())), valueHash(it.value()));
+        return hash;
+    }
+    default:
+        return mixHash(hash, stringHash(value.toString()));
+    }
+}
+
+}
+
+quint64 JsonSnapshot::hash() const
+{
+    if (!d)
+        return 0;
+
+    quint64 hash = d->hash.loadRelaxed();
+    if (hash)
+        return hash;
+
+    hash = mixHash(0, d->type);
+    switch (d->type) {
+    case JsonTreeItem::Value:
+        hash = mixHash(hash, valueHash(d->value));
+        break;
+    case JsonTreeItem::Object: {
+        // The sum of the members does not depend on their order
+        quint64 members = 0;
+        for (int pos = 0; pos < d->children.size(); ++pos)
+            members += mixHash(stringHash(d->keys.at(pos)), d->children.at(pos).hash());
+        hash = mixHash(mixHash(hash, static_cast<quint64>(d->children.size())), members);
+        break;
+    }
+    case JsonTreeItem::Array:
+        for (const JsonSnapshot &child : d->children)
+            hash = mixHash(hash, child.hash());
+        hash = mixHash(hash, static_cast<quint64>(d->children.size()));
+        break;
+    default:
+        break;
+    }
+
+    // 0 marks a hash, which has not been computed yet
+    if (!hash)
+        hash = 1;
+    d->hash.storeRelaxed(hash);
+    return hash;
+}
+
+bool JsonSnapshot::operator==(const JsonSnapshot &other) const
+{
+    if (d == other.d)
+        return true;
+    if (!d || !other.d || d->type != other.d->type || d->children.size() != other.d->children.size())
+        return false;
+
+    // Hashes, which have been computed already, rule out most differences at once
+    const quint64 hash = d->hash.loadRelaxed();
+    const quint64 otherHash = other.d->hash.loadRelaxed();
+    if (hash && otherHash && hash != otherHash)
+        return false;
+
+    switch (d->type) {
+    case JsonTreeItem::Value:
+        return equalValues(d->value, other.d->value);
+    case JsonTreeItem::Object:
+        for (int pos = 0; pos < d->children.size(); ++pos) {
+            // Usually the keys are in the same order
+            const QString &key = d->keys.at(pos);
+            const JsonSnapshot element = other.d->keys.at(pos) == key ? other.d->children.at(pos) : other.child(key);
+            if (element != d->children.at(pos))
+                return false;
+        }
+        return true;
+    case JsonTreeItem::Array:
+        for (int pos = 0; pos < d->children.size(); ++pos) {
+            if (d->children.at(pos) != other.d->children.at(pos))
+                return false;
+        }
+        return true;
+    default:
+        return true;
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef JSONSNAPSHOT_H
+#define JSONSNAPSHOT_H
+
+#include <QAtomicInteger>
+#include <QExplicitlySharedDataPointer>
+#include <QHash>
+#include <QSharedData>
+#include <QString>
+#include <QVariant>
+#include <QVector>
+
+class JsonPath;
+struct JsonSnapshotData;
+
+namespace JsonTreeItemData {
+
+// Defined in jsontreeitem.h
+enum Type : quint8;
+
+}
+
+// Immutable view of a node and its subtree at the time JsonTreeItem::snapshot() was called
+// Snapshots share the nodes of unchanged subtrees with each other, so copying a snapshot is O(1)
+// and taking the next one only creates the nodes on the paths, which have changed in the meantime.
+// Each of these holds a new vector of its children, which costs O(width) per changed object or array.
+// Snapshots can be read from any thread. The lookups never create nodes, they return a null
+// snapshot or an invalid QVariant, if the path does not exist.
+class JsonSnapshot
+{
+public:
+    using DataType = JsonTreeItemData::Type;
+
+    JsonSnapshot();
+    JsonSnapshot(const JsonSnapshot &other);
+    JsonSnapshot(JsonSnapshot &&other) noexcept;
+    ~JsonSnapshot();
+
+    JsonSnapshot &operator=(const JsonSnapshot &other);
+    JsonSnapshot &operator=(JsonSnapshot &&other) noexcept;
+
+    // A null snapshot stands for a missing node
+    bool isNull() const { return !d; }
+
+    DataType type() const;
+
+    // Value of a Value node, an invalid QVariant for other types
+    QVariant value() const;
+    QVariant value(const QString &key) const { return value(QString(), key); }
+    QVariant value(const QString &objPath, const QString &key) const;
+    QVariant value(const JsonPath &path) const;
+
+    // Child nodes of an Object or an Array in the order of the tree
+    int size() const;
+    JsonSnapshot at(int pos) const;
+    QString keyAt(int pos) const;
+
+    // Child node of an Object with the specified key
+    JsonSnapshot child(const QString &key) const;
+
+    JsonSnapshot itemAt(const QString &key) const { return child(key); }
+    JsonSnapshot itemAt(const QString &objPath, const QString &key) const;
+    JsonSnapshot itemAt(const JsonPath &path) const;
+
+    bool contains(const QString &key) const { return !child(key).isNull(); }
+    bool contains(const QString &objPath, const QString &key) const { return !itemAt(objPath, key).isNull(); }
+
+    // Whether both snapshots share the same node, in which case they are equal
+    bool isSharedWith(const JsonSnapshot &other) const { return d == other.d; }
+
+    // Hash of the content of the subtree, 0 for a null snapshot
+    // The hash is computed on the first call and kept in the snapshot nodes. As unchanged subtrees
+    // share their nodes with the previous snapshots, only the hashes of the changed paths are
+    // computed again. Equal subtrees have equal hashes, so different hashes prove a change, while
+    // equal ones are taken as equal content by JsonTreeItem::diff().
+    quint64 hash() const;
+
+    // Whether both subtrees have the same content
+    // Like in JSON, the keys of an object are compared independent of their order and numbers by their
+    // value, whatever their type in the QVariant.
+    bool operator==(const JsonSnapshot &other) const;
+    bool operator!=(const JsonSnapshot &other) const { return !(*this == other); }
+
+private:
+    friend class JsonTreeItem;
+
+    QExplicitlySharedDataPointer<JsonSnapshotData> d;
+
+    explicit JsonSnapshot(JsonSnapshotData *data);
+
+    // Walk the object path, which is given by the first depth segments
+    JsonSnapshot objectAt(const QStringList &segments, int depth) const;
+};
+
+// Node of a snapshot, which is not modified anymore after it has been created
+struct JsonSnapshotData : public QSharedData
+{
+    JsonTreeItemData::Type type;
+    QVariant value;
+
+    // Keys of the child nodes of an Object, parallel to children
+    QVector<QString> keys;
+    QVector<JsonSnapshot> children;
+
+    // Positions of the keys of wide objects, like the index of JsonTreeItem
+    QHash<QString, int> index;
+
+    // Hash of the subtree, 0 until JsonSnapshot::hash() has computed it
+    // Snapshot nodes are read by several threads, so it is stored atomically. Threads, which compute
+    // it at the same time, store the same value.
+    mutable QAtomicInteger<quint64> hash;
+};
+
+#endif // JSONSNAPSHOT_H
@@ -0,0 +1,93 @@
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "jsontreearena.h"
+
+namespace {
+
+inline char *alignUp(char *pos, size_t alignment)
+{
+    const uintptr_t address = reinterpret_cast<uintptr_t>(pos);
+    return reinterpret_cast<char *>((address + alignment - 1) & ~(uintptr_t(alignment) - 1));
+}
+
+char *allocateBlock(size_t size)
+{
+    char *block = static_cast<char *>(std::malloc(size));
+    if (!block)
+        throw std::bad_alloc();
+    return block;
+}
+
+}
+
+JsonTreeArena::JsonTreeArena()
+    : m_pos(nullptr),
+      m_end(nullptr),
+      m_allocatedBytes(0)
+{
+}
+
+JsonTreeArena::~JsonTreeArena()
+{
+    for (char *block : qAsConst(m_blocks))
+        std::free(block);
+}
+
+void *JsonTreeArena::allocate(size_t size, size_t alignment)
+{
+    m_allocatedBytes += size;
+
+    char *pos = alignUp(m_pos, alignment);
+    if (m_pos && pos + size <= m_end) {
+        m_pos = pos + size;
+        return pos;
+    }
+
+    // Large allocations get a block of their own, so that the current block can still be used
+    if (size + alignment > BlockSize / 4) {
+        char *block = allocateBlock(size + alignment);
+        m_blocks.push_back(block);
+        return alignUp(block, alignment);
+    }
+
+    char *block = allocateBlock(BlockSize);
+    m_blocks.push_back(block);
+    m_end = block + BlockSize;
+
+    pos = alignUp(block, alignment);
+    m_pos = pos + size;
+    return pos;
+}
+
+void JsonTreeArena::reset()
+{
+    m_allocatedBytes = 0;
+
+    if (m_blocks.isEmpty())
+        return;
+
+    // Keep one standard block, all others are released
+    char *current = m_end ? m_end - BlockSize : nullptr;
+    for (char *block : qAsConst(m_blocks)) {
+        if (block != current)
+            std::free(block);
+    }
+    m_blocks.clear();
+
+    if (current)
+        m_blocks.push_back(current);
+    m_pos = current;
+}
+
+void JsonTreeArena::adopt(JsonTreeArena &other)
+{
+    m_blocks += other.m_blocks;
+    m_allocatedBytes += other.m_allocatedBytes;
+
+    other.m_blocks.clear();
+    other.m_pos = nullptr;
+    other.m_end = nullptr;
+    other.m_allocatedBytes = 0;
+}
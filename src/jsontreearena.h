@@ -0,0 +1,42 @@
+#ifndef JSONTREEARENA_H
+#define JSONTREEARENA_H
+
+#include <QVector>
+
+#include <cstddef>
+
+// Bump allocator for the nodes of a tree
+// Memory is taken from blocks of BlockSize bytes and is only given back all at once by reset() or
+// the destructor. The objects in the arena have to be destroyed before. The arena is not thread-safe.
+class JsonTreeArena
+{
+public:
+    static constexpr size_t BlockSize = 64 * 1024;
+
+    JsonTreeArena();
+    ~JsonTreeArena();
+
+    JsonTreeArena(const JsonTreeArena &) = delete;
+    JsonTreeArena &operator=(const JsonTreeArena &) = delete;
+
+    void *allocate(size_t size, size_t alignment);
+
+    // Release all allocations, the first block is kept for reuse
+    void reset();
+
+    // Take over the blocks of another arena, whose objects now belong to this arena
+    // The other arena is empty afterwards, allocations continue in the current block of this one.
+    void adopt(JsonTreeArena &other);
+
+    // Number of bytes handed out since the last reset
+    size_t allocatedBytes() const { return m_allocatedBytes; }
+    int blockCount() const { return m_blocks.size(); }
+
+private:
+    QVector<char *> m_blocks;
+    char *m_pos;
+    char *m_end;
+    size_t m_allocatedBytes;
+};
+
+#endif // JSONTREEARENA_H
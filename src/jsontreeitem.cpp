@@ -1,179 +1,1317 @@
 #include <QFile>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QJsonValue>
+#include <QSaveFile>
 
+#include <algorithm>
+#include <cstring>
+
+#include "jsonbinary.h"
+#include "jsonkeypool.h"
+#include "jsonparallelloader.h"
+#include "jsonparser.h"
+#include "jsonpatch.h"
+#include "jsonpath.h"
+#include "jsonsavequeue.h"
 #include "jsontreeitem.h"
+#include "jsonwriter.h"
+
+// The size, which is documented in the header, is kept in check for Qt 5 on a 64 bit platform
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0) && QT_POINTER_SIZE == 8
+static_assert(sizeof(JsonTreeItem) == 80, "The size of a JsonTreeItem differs from the one in jsontreeitem.h");
+#endif
 
 JsonTreeItem::JsonTreeItem()
     : m_type(None),
-      m_data(nullptr)
+      m_flags(0),
+      m_keyId(0),
+      m_generation(0),
+      m_parent(nullptr),
+      m_index(nullptr),
+      m_tree(nullptr),
+      m_fragmentOffset(0),
+      m_fragmentSize(0)
+{
+}
+
+JsonTreeItem::~JsonTreeItem()
+{
+    releaseData();
+
+    if (m_flags & OwnsTree)
+        deleteTree();
+}
+
+void JsonTreeItem::setArenaEnabled(bool enabled)
+{
+    if (m_parent || enabled == isArenaEnabled())
+        return;
+
+    clear();
+
+    if (enabled) {
+        ensureTree()->arena = new JsonTreeArena;
+    } else {
+        delete m_tree->arena;
+        m_tree->arena = nullptr;
+    }
+}
+
+void JsonTreeItem::setKeyInterningEnabled(bool enabled)
+{
+    if (m_parent || enabled == isKeyInterningEnabled())
+        return;
+
+    if (enabled) {
+        ensureTree()->keys = new JsonKeyPool;
+        internKeys(m_tree->keys);
+    } else {
+        delete m_tree->keys;
+        m_tree->keys = nullptr;
+        internKeys(nullptr);
+    }
+}
+
+bool JsonTreeItem::loadFromFile(const QString &filename, JsonParseError *error, LoadMode mode)
+{
+    QFile *file = new QFile(filename);
+    if (!file->open(QFile::ReadOnly)) {
+        delete file;
+        if (error)
+            *error = JsonParseError{JsonParseError::FileError};
+        return false;
+    }
+
+    const qint64 size = file->size();
+    const char *data = size > 0 ? reinterpret_cast<const char *>(file->map(0, size)) : nullptr;
+
+    if (data && mode == Lazy && !m_parent) {
+        // The file stays mapped for the lazy nodes, until the tree is cleared
+        reset();
+        ensureTree()->sourceFile = file;
+        return loadFromData(data, size, error, Lazy);
+    }
+
+    bool ok;
+    if (data) {
+        reset();
+        ok = loadFromData(data, size, error, mode == Parallel ? Parallel : Eager);
+    } else {
+        // Empty files and files, which cannot be mapped, are read into a buffer
+        const QByteArray json = file->readAll();
+        if (file->error() != QFile::NoError) {
+            delete file;
+            if (error)
+                *error = JsonParseError{JsonParseError::FileError};
+            return false;
+        }
+        ok = loadFromJson(json, error, mode);
+    }
+
+    // Deleting the file also removes the mapping
+    delete file;
+    return ok;
+}
+
+bool JsonTreeItem::saveToFile(const QString &filename, JsonFormat format)
+{
+    if (m_type != Object && m_type != Array)
+        return false;
+
+    // Without commit(), the temporary file is discarded and the file is left unchanged
+    QSaveFile file(filename);
+    if (!file.open(QSaveFile::WriteOnly))
+        return false;
+    if (m_parent)
+        return saveToDevice(&file, format) && file.commit();
+
+    QByteArray json;
+    if (!serialize(json, format))
+        return false;
+
+    JsonPhaseTimer timer(this, JsonTreeStats::Write, json.size());
+    return file.write(json) == json.size() && file.commit();
+}
+
+QFuture<bool> JsonTreeItem::saveToFileAsync(const QString &filename, JsonFormat format)
+{
+    QByteArray json;
+    if ((m_type != Object && m_type != Array) || !serialize(json, format)) {
+        QFutureInterface<bool> result;
+        result.reportStarted();
+        result.reportResult(false);
+        result.reportFinished();
+        return result.future();
+    }
+
+    // The byte array is implicitly shared with the cache of the root, so it is not copied
+    return JsonSaveQueue::instance()->enqueue(filename, json);
+}
+
+bool JsonTreeItem::loadFromJson(const QByteArray &json, JsonParseError *error, LoadMode mode)
+{
+    reset();
+
+    if (mode != Lazy || m_parent)
+        return loadFromData(json.constData(), json.size(), error, mode == Parallel ? Parallel : Eager);
+
+    // The byte array is implicitly shared, so keeping it for the lazy nodes does not copy it
+    const QByteArray &source = ensureTree()->source = json;
+    return loadFromData(source.constData(), source.size(), error, Lazy);
+}
+
+bool JsonTreeItem::loadFromData(const char *data, qint64 size, JsonParseError *error, LoadMode mode)
+{
+    JsonPhaseTimer timer(this, JsonTreeStats::Parse, size);
+
+    bool ok;
+    if (mode == Parallel && !m_parent) {
+        JsonParallelLoader loader(data, size);
+        ok = loader.load(this, error);
+    } else {
+        JsonParser parser(data, size);
+        ok = parser.parse(this, mode == Lazy ? JsonParser::LazyLoad : JsonParser::Load, error);
+    }
+
+    if (!ok) {
+        reset();
+        return false;
+    }
+
+    return true;
+}
+
+QByteArray JsonTreeItem::saveToJson(JsonFormat format)
+{
+    QByteArray json;
+    saveToJson(json, format);
+    return json;
+}
+
+bool JsonTreeItem::saveToJson(QByteArray &buffer, JsonFormat format)
+{
+    return serialize(buffer, format);
+}
+
+bool JsonTreeItem::loadFromBinary(const QByteArray &data, JsonParseError *error)
+{
+    reset();
+    return loadFromBinaryData(data.constData(), data.size(), error);
+}
+
+QByteArray JsonTreeItem::saveToBinary()
+{
+    QByteArray data;
+    JsonPhaseTimer timer(this, JsonTreeStats::Export);
+    JsonBinaryWriter writer(&data);
+    writer.write(this);
+    timer.setBytes(data.size());
+    return data;
+}
+
+bool JsonTreeItem::loadFromBinaryFile(const QString &filename, JsonParseError *error)
+{
+    QFile file(filename);
+    if (!file.open(QFile::ReadOnly)) {
+        if (error)
+            *error = JsonParseError{JsonParseError::FileError};
+        return false;
+    }
+
+    // No node references the snapshot after loading, so the mapping is released with the file
+    const qint64 size = file.size();
+    const char *data = size > 0 ? reinterpret_cast<const char *>(file.map(0, size)) : nullptr;
+    if (!data) {
+        const QByteArray binary = file.readAll();
+        if (file.error() != QFile::NoError) {
+            if (error)
+                *error = JsonParseError{JsonParseError::FileError};
+            return false;
+        }
+        return loadFromBinary(binary, error);
+    }
+
+    reset();
+    return loadFromBinaryData(data, size, error);
+}
+
+bool JsonTreeItem::saveToBinaryFile(const QString &filename)
+{
+    if (m_type != Object && m_type != Array)
+        return false;
+
+    const QByteArray data = saveToBinary();
+    JsonPhaseTimer timer(this, JsonTreeStats::Write, data.size());
+    return JsonSaveQueue::writeFile(filename, data);
+}
+
+bool JsonTreeItem::loadFromBinaryData(const char *data, qint64 size, JsonParseError *error)
+{
+    JsonPhaseTimer timer(this, JsonTreeStats::Import, size);
+    JsonBinaryReader reader(data, size);
+    if (!reader.read(this, error)) {
+        reset();
+        return false;
+    }
+
+    return true;
+}
+
+bool JsonTreeItem::saveToDevice(QIODevice *device, JsonFormat format)
+{
+    if (m_parent) {
+        // The document is streamed, so the time of writing is part of the export
+        JsonPhaseTimer timer(this, JsonTreeStats::Export);
+        JsonWriter writer(device, format);
+        return writer.write(this);
+    }
+
+    QByteArray json;
+    if (!serialize(json, format))
+        return false;
+
+    JsonPhaseTimer timer(this, JsonTreeStats::Write, json.size());
+    return device->write(json) == json.size();
+}
+
+bool JsonTreeItem::serialize(QByteArray &output, JsonFormat format)
+{
+    JsonPhaseTimer timer(this, JsonTreeStats::Export);
+
+    // Only the root keeps its output for incremental saving
+    if (m_parent) {
+        output.resize(0);
+        JsonWriter writer(&output, format);
+        const bool ok = writer.write(this);
+        timer.setBytes(output.size());
+        return ok;
+    }
+
+    JsonTreeItemData::Tree *tree = ensureTree();
+    const bool reuse = tree->saveCacheValid && tree->saveFormat == format;
+
+    QByteArray json;
+    json.reserve(tree->saveCache.size());
+
+    JsonWriter writer(&json, format);
+    if (!writer.writeIncremental(this, reuse ? &tree->saveCache : nullptr)) {
+        // The recorded fragments refer to the incomplete output, which is not kept
+        tree->saveCacheValid = false;
+        output = json;
+        return false;
+    }
+
+    // The byte arrays are implicitly shared, so the output is not copied
+    tree->saveCache = json;
+    tree->saveFormat = format;
+    tree->saveCacheValid = true;
+    output = json;
+    timer.setBytes(json.size());
+    return true;
+}
+
+bool JsonTreeItem::appendJson(const QByteArray &json, JsonParseError *error)
+{
+    JsonPhaseTimer timer(this, JsonTreeStats::Parse, json.size());
+    JsonParser parser(json.constData(), json.size());
+    return parser.parse(this, JsonParser::Append, error);
+}
+
+void JsonTreeItem::clear()
+{
+    if (m_type != None)
+        bumpGeneration();
+    releaseData();
+    clearExtended();
+    markDirty();
+
+    if (m_flags & OwnsTree)
+        releaseTree();
+}
+
+void JsonTreeItem::releaseData()
+{
+    // References, which have been returned to the data, become invalid with it
+    m_flags &= ~ExposedFlags;
+
+    // A lazy node only references the source document
+    if (m_flags & LazyNode) {
+        m_flags &= ~LazyNode;
+        m_type = None;
+        return;
+    }
+
+    switch (m_type)
+    {
+    case Value:
+        // m_data holds a QVariant object
+        freeData<Value>();
+        break;
+    case Object:
+        // Delete all child nodes, before destructing the QVector
+        for (JsonTreeItem *item : qAsConst(asType<Object>()))
+            destroyItem(item);
+        // m_data holds a QVector<JsonTreeItem *> object
+        freeData<Object>();
+        break;
+    case Array:
+        // Delete all child nodes, before destructing the QVector
+        for (JsonTreeItem *item : qAsConst(asType<Array>()))
+            destroyItem(item);
+        // m_data holds a QVector<JsonTreeItem *> object
+        freeData<Array>();
+        break;
+    default:
+        break;
+    }
+
+    dropIndex();
+
+    m_type = None;
+}
+
+JsonTreeItemData::Tree *JsonTreeItem::ensureTree()
+{
+    if (!m_tree) {
+        m_tree = new JsonTreeItemData::Tree;
+        m_flags |= OwnsTree;
+    }
+    return m_tree;
+}
+
+void JsonTreeItem::releaseTree()
+{
+    // Nothing in the arena or the source is referenced anymore, so they are released at once
+    if (m_tree->arena)
+        m_tree->arena->reset();
+
+    m_tree->source.clear();
+    delete m_tree->sourceFile;
+    m_tree->sourceFile = nullptr;
+
+    m_tree->saveCache.clear();
+    m_tree->saveCacheValid = false;
+
+    m_tree->graftedSources.clear();
+
+    // The keys of the next content are interned from scratch
+    if (m_tree->keys)
+        m_tree->keys->clear();
+}
+
+void JsonTreeItem::deleteTree()
+{
+    releaseTree();
+    delete m_tree->arena;
+    delete m_tree->keys;
+    delete m_tree;
+    m_tree = nullptr;
+    m_flags &= ~OwnsTree;
+}
+
+void JsonTreeItem::setLazy(DataType type, const char *begin, const char *end)
+{
+    // Releasing the data like in clear() would release the source document at the root
+    if (m_type != None) {
+        bumpGeneration();
+        releaseData();
+        clearExtended();
+    }
+
+    m_type = type;
+    m_flags |= LazyNode;
+    m_data.range = JsonTreeItemData::LazyRange{begin, end};
+    markDirty();
+}
+
+void JsonTreeItem::materialize()
+{
+    const JsonTreeItemData::LazyRange range = m_data.range;
+    m_flags &= ~LazyNode;
+    m_type = None;
+
+    // The parsed tree does not necessarily render like the source range (e.g. duplicate keys are
+    // merged), so the old fragment of this node cannot be reused
+    markDirty();
+
+    JsonPhaseTimer timer(this, JsonTreeStats::Parse, range.end - range.begin);
+
+    // The range has been validated, when the document was loaded
+    JsonParser parser(range.begin, range.end - range.begin);
+    parser.parse(this, JsonParser::Materialize);
+}
+
+bool JsonTreeItem::hasLazyNodes() const
+{
+    if (m_flags & LazyNode)
+        return true;
+    if (m_type != Object && m_type != Array)
+        return false;
+
+    for (const JsonTreeItem *child : m_data.children) {
+        if (child->hasLazyNodes())
+            return true;
+    }
+    return false;
+}
+
+void JsonTreeItem::materializeAll()
+{
+    if (m_flags & LazyNode)
+        materialize();
+    if (m_type != Object && m_type != Array)
+        return;
+
+    for (JsonTreeItem *child : qAsConst(m_data.children))
+        child->materializeAll();
+}
+
+JsonTreeItem *JsonTreeItem::detachSubtree(JsonTreeItem *item)
+{
+    // The arena is only released with its tree, so its nodes are copied to the heap
+    if (item->m_flags & ArenaNode) {
+        JsonTreeItem *copy = item->newRoot();
+        copy->m_key = item->m_key;
+        copy->copyFrom(item);
+        destroyItem(item);
+        return copy;
+    }
+
+    // Lazy nodes keep referencing the source documents of the tree, which are shared with the new
+    // tree. Only a mapped file cannot be shared.
+    JsonTreeItemData::Tree *tree = item->m_tree;
+    const bool lazy = tree && (tree->sourceFile || !tree->source.isEmpty() || !tree->graftedSources.isEmpty())
+                      && item->hasLazyNodes();
+    if (lazy && tree->sourceFile)
+        item->materializeAll();
+
+    item->m_parent = nullptr;
+    item->m_keyId = 0;
+    item->m_fragmentSize = 0;
+    item->m_tree = nullptr;
+    if (lazy && !tree->sourceFile) {
+        JsonTreeItemData::Tree *own = item->ensureTree();
+        own->source = tree->source;
+        own->graftedSources = tree->graftedSources;
+    }
+
+    // The nodes release their keys from the pool of the previous tree
+    item->internKeys(nullptr);
+    return item;
+}
+
+JsonTreeItem *JsonTreeItem::adoptSubtree(JsonTreeItem *item)
+{
+    JsonTreeItem *root = this;
+    while (root->m_parent)
+        root = root->m_parent;
+
+    if (item->m_flags & OwnsTree) {
+        JsonTreeItemData::Tree *tree = item->m_tree;
+
+        // The arena is only released with its tree, so its nodes are copied into this tree
+        if (tree->arena) {
+            JsonTreeItem *copy = newItem();
+            copy->copyFrom(item);
+            delete item;
+            return copy;
+        }
+
+        // The source documents of lazy nodes are kept by this tree from now on
+        if ((tree->sourceFile || !tree->source.isEmpty() || !tree->graftedSources.isEmpty()) && item->hasLazyNodes()) {
+            if (tree->sourceFile) {
+                item->materializeAll();
+            } else {
+                JsonTreeItemData::Tree *own = root->ensureTree();
+                if (!tree->source.isEmpty())
+                    own->graftedSources.push_back(tree->source);
+                own->graftedSources += tree->graftedSources;
+            }
+        }
+        item->deleteTree();
+    }
+
+    item->m_tree = root->m_tree;
+    item->m_keyId = 0;
+    item->m_fragmentSize = 0;
+    item->internKeys(item->m_tree ? item->m_tree->keys : nullptr);
+    return item;
+}
+
+JsonTreeItem *JsonTreeItem::insertTree(const QString &key, std::unique_ptr<JsonTreeItem> item)
+{
+    if (!item)
+        return nullptr;
+
+    JsonTreeItem *node = adoptSubtree(item.release());
+    node->assignKey(key);
+
+    syncIndex();
+    const int pos = indexOf(key);
+    if (pos < 0) {
+        insertChild(node);
+    } else {
+        // The node takes the position of the replaced one, so the index stays valid
+        QVector<JsonTreeItem *> &children = asType<Object>();
+        destroyItem(children.at(pos));
+        children[pos] = node;
+        node->m_parent = this;
+        bumpGeneration();
+    }
+
+    // The fragments of the previous tree do not match the output of this one
+    node->m_flags |= ChangedFlags;
+    markDirty();
+    return node;
+}
+
+void JsonTreeItem::takeElements(JsonTreeItemData::ElementSink &sink)
+{
+    if (m_type != Object && m_type != Array)
+        return;
+
+    if (m_flags & LazyNode) {
+        const JsonTreeItemData::LazyRange range = m_data.range;
+        JsonPhaseTimer timer(this, JsonTreeStats::Parse, range.end - range.begin);
+
+        // The range has been validated, when the document was loaded
+        JsonParser parser(range.begin, range.end - range.begin);
+        parser.parseElements(sink);
+
+        m_flags &= ~LazyNode;
+        new (&m_data) QVector<JsonTreeItem *>;
+    } else {
+        QVector<JsonTreeItem *> &children = m_data.children;
+        for (JsonTreeItem *child : qAsConst(children)) {
+            sink.addValue(m_type == Object ? child->m_key : QString(),
+                          child->m_type == Value ? child->m_data.value : QVariant());
+            destroyItem(child);
+        }
+        children.clear();
+        dropIndex();
+        bumpGeneration();
+    }
+
+    markDirty();
+}
+
+void JsonTreeItem::destroyItem(JsonTreeItem *item)
+{
+    // The memory of arena nodes is released together with the arena
+    if (item->m_flags & ArenaNode)
+        item->~JsonTreeItem();
+    else
+        delete item;
+}
+
+void JsonTreeItem::setKey(const QString &key)
+{
+    // The index of the parent object becomes invalid with the new key, it is rebuilt on the next lookup
+    if (m_parent) {
+        if (m_parent->m_index)
+            m_parent->dropIndex();
+        m_parent->bumpGeneration();
+        m_parent->markDirty();
+    }
+    assignKey(key);
+}
+
+void JsonTreeItem::assignKey(const QString &key)
+{
+    JsonKeyPool *pool = m_tree ? m_tree->keys : nullptr;
+    m_keyId = pool ? pool->intern(key) : 0;
+    m_key = m_keyId ? pool->key(m_keyId) : key;
+}
+
+quint16 JsonTreeItem::keyId(const QString &key) const
+{
+    return m_tree && m_tree->keys ? m_tree->keys->id(key) : 0;
+}
+
+void JsonTreeItem::internKeys(JsonKeyPool *pool)
+{
+    if ((m_type != Object && m_type != Array) || (m_flags & LazyNode))
+        return;
+
+    for (JsonTreeItem *child : qAsConst(m_data.children)) {
+        // Nodes, which have been created before the root had a state, look up keys in the pool too
+        child->m_tree = m_tree;
+        if (m_type == Object) {
+            child->m_keyId = pool ? pool->intern(child->m_key) : 0;
+            if (child->m_keyId)
+                child->m_key = pool->key(child->m_keyId);
+        }
+        child->internKeys(pool);
+    }
+}
+
+bool JsonTreeItem::contains(const QString &objPath, const QString &key) const
+{
+    const JsonTreeItem *ct = objectAt(objPath);
+    if (!ct)
+        return false;
+    return ct->find(key) != nullptr;
+}
+
+bool JsonTreeItem::contains(const JsonPath &path) const
+{
+    const JsonTreeItem *ct = objectAt(path.segments(), path.objectDepth());
+    if (!ct)
+        return false;
+    return ct->find(path.key()) != nullptr;
+}
+
+void JsonTreeItem::removeItem(const QString &objPath, const QString &key)
+{
+    JsonTreeItem *ct = objectAt(objPath);
+    ct->syncIndex();
+    const int pos = ct->indexOf(key);
+    if (pos >= 0)
+        ct->removeChildAt(pos);
+}
+
+std::unique_ptr<JsonTreeItem> JsonTreeItem::takeItem(const QString &objPath, const QString &key)
+{
+    JsonTreeItem *ct = objectAt(objPath);
+    ct->syncIndex();
+    const int pos = ct->indexOf(key);
+    if (pos < 0)
+        return nullptr;
+    return std::unique_ptr<JsonTreeItem>(detachSubtree(ct->takeChildAt(pos)));
+}
+
+std::unique_ptr<JsonTreeItem> JsonTreeItem::takeItem(const JsonPath &path)
+{
+    JsonTreeItem *ct = objectAt(path.segments(), path.objectDepth());
+    ct->syncIndex();
+    const int pos = ct->indexOf(path.key());
+    if (pos < 0)
+        return nullptr;
+    return std::unique_ptr<JsonTreeItem>(detachSubtree(ct->takeChildAt(pos)));
+}
+
+JsonTreeItem *JsonTreeItem::insertItem(const QString &objPath, const QString &key, std::unique_ptr<JsonTreeItem> item)
+{
+    return objectAt(objPath)->insertTree(key, std::move(item));
+}
+
+JsonTreeItem *JsonTreeItem::insertItem(const JsonPath &path, std::unique_ptr<JsonTreeItem> item)
+{
+    return objectAt(path.segments(), path.objectDepth())->insertTree(path.key(), std::move(item));
+}
+
+JsonTreeItem *JsonTreeItem::itemAt(const QString &objPath, const QString &key)
+{
+    JsonTreeItem *obj = objectAt(objPath);
+    JsonTreeItem *item = obj->find(key);
+    if (!item) {
+        item = newItem();
+        item->assignKey(key);
+        obj->insertChild(item);
+        countCreated(false);
+    }
+    return item;
+}
+
+JsonTreeItem *JsonTreeItem::itemAt(const JsonPath &path)
+{
+    JsonTreeItem *obj = objectAt(path.segments(), path.objectDepth());
+    const QString key = path.key();
+    JsonTreeItem *item = obj->find(key);
+    if (!item) {
+        item = newItem();
+        item->assignKey(key);
+        obj->insertChild(item);
+        countCreated(false);
+    }
+    return item;
+}
+
+const JsonTreeItem *JsonTreeItem::itemAt(const QString &objPath, const QString &key) const
+{
+    const JsonTreeItem *obj = objectAt(objPath);
+    return obj ? obj->find(key) : nullptr;
+}
+
+const JsonTreeItem *JsonTreeItem::itemAt(const JsonPath &path) const
+{
+    const JsonTreeItem *obj = objectAt(path.segments(), path.objectDepth());
+    return obj ? obj->find(path.key()) : nullptr;
+}
+
+QVariant JsonTreeItem::value(const QString &objPath, const QString &key) const
 {
+    const JsonTreeItem *item = itemAt(objPath, key);
+    return item ? item->value() : QVariant();
 }
 
-JsonTreeItem::~JsonTreeItem()
+QVariant JsonTreeItem::value(const JsonPath &path) const
 {
-    clear();
+    const JsonTreeItem *item = itemAt(path);
+    return item ? item->value() : QVariant();
 }
 
-void JsonTreeItem::loadFromFile(const QString &filename)
+JsonTreeItem *JsonTreeItem::clone() const
 {
-    if (!QFile::exists(filename))
-        return;
-
-    QFile file(filename);
-    file.open(QFile::ReadOnly);
-    loadFromJson(file.readAll());
-    file.close();
+    JsonTreeItem *root = newRoot();
+    if (isArenaEnabled())
+        root->setArenaEnabled(true);
+    if (isKeyInterningEnabled())
+        root->setKeyInterningEnabled(true);
+    root->m_key = m_key;
+    root->copyFrom(this);
+#ifdef JSONCONFIG_STATS
+    // Copies are often read by several threads, whose lookups must not create the state
+    root->ensureStatsCounters();
+#endif
+    return root;
 }
 
-void JsonTreeItem::saveToFile(const QString &filename)
+void JsonTreeItem::copyFrom(const JsonTreeItem *source)
 {
-    QFile file(filename);
-    file.open(QFile::WriteOnly);
-    file.write(saveToJson());
-    file.close();
+    switch (source->m_type) {
+    case Value:
+        allocData<Value>();
+        asType<Value>() = source->asType<Value>();
+        break;
+    case Object:
+    case Array: {
+        const QVector<JsonTreeItem *> &children = source->m_type == Object ? source->asType<Object>()
+                                                                            : source->asType<Array>();
+        if (source->m_type == Object)
+            allocData<Object>();
+        else
+            allocData<Array>();
+
+        QVector<JsonTreeItem *> &copies = m_data.children;
+        copies.reserve(children.size());
+        for (const JsonTreeItem *child : children) {
+            JsonTreeItem *copy = newItem();
+            copy->assignKey(child->m_key);
+            copy->m_parent = this;
+            copy->copyFrom(child);
+            copies.push_back(copy);
+        }
+
+        // Wide objects get their index right away, so that const lookups in the copy can use it
+        if (m_type == Object)
+            syncIndex();
+        break;
+    }
+    default:
+        break;
+    }
+
+    copyExtended(source);
 }
 
-void JsonTreeItem::loadFromJson(const QByteArray &json)
+template<typename _ChildSnapshot>
+JsonSnapshotData *JsonTreeItem::createSnapshotData(_ChildSnapshot childSnapshot) const
 {
-    reset();
+    // Receiver, which turns the elements of the data of derived classes into snapshot nodes
+    struct ElementSnapshots : public JsonTreeItemData::ElementSink
+    {
+        JsonSnapshotData *data;
 
-    QJsonDocument doc = QJsonDocument::fromJson(json);
+        void addValue(const QString &key, const QVariant &value) override
+        {
+            if (data->type == JsonTreeItem::Value) {
+                data->value = value;
+                return;
+            }
 
-    if (!doc.isObject() && !doc.isArray())
-        return;
+            JsonSnapshotData *element = new JsonSnapshotData;
+            element->type = JsonTreeItem::Value;
+            element->value = value;
+            data->children.push_back(JsonSnapshot(element));
+            if (data->type == JsonTreeItem::Object)
+                data->keys.push_back(key);
+        }
+    };
+
+    JsonSnapshotData *data = new JsonSnapshotData;
+    data->type = m_type;
+
+    // The data of derived classes takes the place of the value or the child nodes
+    ElementSnapshots elements;
+    elements.data = data;
+
+    switch (m_type) {
+    case Value:
+        if (!exportExtended(elements))
+            data->value = asType<Value>();
+        break;
+    case Object:
+    case Array: {
+        if (exportExtended(elements))
+            break;
+
+        const QVector<JsonTreeItem *> &children = m_type == Object ? asType<Object>() : asType<Array>();
+        data->children.reserve(children.size());
+
+        // The keys and the index of the previous snapshot are shared, as long as the keys have not
+        // changed. Comparing them is cheap, as they share their data with the keys of the nodes.
+        const JsonSnapshotData *previous = m_snapshot.d && m_snapshot.d->type == Object ? m_snapshot.d.data() : nullptr;
+        bool sameKeys = m_type == Object && previous && previous->keys.size() == children.size();
 
-    if (doc.isObject())
-        import(doc.object());
-    else if (doc.isArray())
-        import(doc.array());
+        for (int pos = 0; pos < children.size(); ++pos) {
+            JsonTreeItem *child = children.at(pos);
+            data->children.push_back(childSnapshot(child));
+            if (sameKeys && previous->keys.at(pos) != child->m_key)
+                sameKeys = false;
+        }
+
+        if (m_type != Object)
+            break;
+
+        if (sameKeys) {
+            data->keys = previous->keys;
+            data->index = previous->index;
+            break;
+        }
+
+        data->keys.reserve(children.size());
+        for (const JsonTreeItem *child : children)
+            data->keys.push_back(child->m_key);
+
+        // Duplicate keys resolve to the first child node, like in the index of the tree
+        if (children.size() >= IndexThreshold) {
+            data->index.reserve(children.size());
+            for (int pos = 0; pos < data->keys.size(); ++pos) {
+                if (!data->index.contains(data->keys.at(pos)))
+                    data->index.insert(data->keys.at(pos), pos);
+            }
+        }
+        break;
+    }
+    default:
+        break;
+    }
+
+    return data;
 }
 
-QByteArray JsonTreeItem::saveToJson()
+JsonSnapshot JsonTreeItem::snapshot()
 {
-    if (m_type != Object && m_type != Array)
-        return QByteArray();
+    if (m_snapshot.d && !(m_flags & (StaleSnapshot | ExposedFlags)))
+        return m_snapshot;
 
-    QJsonDocument doc;
+    m_flags &= ~ExposedChildren;
+    const JsonSnapshot current(createSnapshotData([this](JsonTreeItem *child) {
+        const JsonSnapshot snapshot = child->snapshot();
+        if (child->m_flags & ExposedFlags)
+            m_flags |= ExposedChildren;
+        return snapshot;
+    }));
 
-    if (m_type == Object)
-        doc.setObject(exportObject());
-    else if (m_type == Array)
-        doc.setArray(exportArray());
+    // Exposed nodes, which have not been changed through the accessors, keep their last snapshot, if
+    // it is still the same, so that it stays shared with the previous snapshots of their ancestors
+    if (!m_snapshot.d || (m_flags & StaleSnapshot) || !sameContent(current, m_snapshot))
+        m_snapshot = current;
+    m_flags &= ~StaleSnapshot;
+    return m_snapshot;
+}
+
+JsonSnapshot JsonTreeItem::temporarySnapshot() const
+{
+    // The kept snapshots are only read, like the nodes by the other const functions
+    if (m_snapshot.d && !(m_flags & (StaleSnapshot | ExposedFlags)))
+        return m_snapshot;
 
-    return doc.toJson();
+    return JsonSnapshot(createSnapshotData([](const JsonTreeItem *child) { return child->temporarySnapshot(); }));
 }
 
-void JsonTreeItem::appendJson(const QByteArray &json)
+bool JsonTreeItem::sameContent(const JsonSnapshot &snapshot, const JsonSnapshot &other)
 {
-    QJsonDocument doc = QJsonDocument::fromJson(json);
+    if (snapshot.isSharedWith(other))
+        return true;
+    if (snapshot.type() != other.type() || snapshot.size() != other.size())
+        return false;
 
-    if (!doc.isObject() && !doc.isArray())
-        return;
+    // Equal values of other types are written differently, e.g. 1 and 1.0
+    if (snapshot.type() == Value) {
+        const QVariant value = snapshot.value();
+        const QVariant otherValue = other.value();
+        return value.userType() == otherValue.userType() && value == otherValue;
+    }
 
-    if (doc.isObject())
-        append(doc.object());
-    else if (doc.isArray())
-        append(doc.array());
+    for (int pos = 0; pos < snapshot.size(); ++pos) {
+        if (snapshot.keyAt(pos) != other.keyAt(pos) || !sameContent(snapshot.at(pos), other.at(pos)))
+            return false;
+    }
+    return true;
 }
 
-void JsonTreeItem::clear()
+void JsonTreeItem::restore(const JsonSnapshot &snapshot)
 {
-    switch (m_type)
-    {
+    // The node has not changed since the snapshot was taken, exposed nodes may have been changed
+    // through a reference
+    if (m_snapshot.d == snapshot.d && !(m_flags & (StaleSnapshot | ExposedFlags)))
+        return;
+
+    // The snapshot contains the data of derived classes in the form of the tree
+    clearExtended();
+
+    switch (snapshot.type()) {
     case Value:
-        // m_data is a pointer to a QVariant object
-        freeData<Value>();
+        forceAsType<Value>() = snapshot.d->value;
         break;
     case Object:
-        // Delete all child nodes, before deleting the QVector pointer
-        qDeleteAll(asType<Object>());
-        // m_data is a pointer to a QVector<ConfigTree *> object
-        freeData<Object>();
-        break;
     case Array:
-        // Delete all child nodes, before deleting the QVector pointer
-        qDeleteAll(asType<Array>());
-        // m_data is a pointer to a QVector<ConfigTree *> object
-        freeData<Array>();
+        restoreChildren(snapshot.d.data());
         break;
     default:
+        clear();
         break;
     }
 
-    m_type = None;
-    m_data = nullptr;
+    // The content is equal to the snapshot again, so it can be returned by snapshot()
+    m_snapshot = snapshot;
+    m_flags &= ~StaleSnapshot;
 }
 
-bool JsonTreeItem::contains(const QString &objPath, const QString &key) const
+void JsonTreeItem::restoreChildren(const JsonSnapshotData *data)
 {
-    const JsonTreeItem *ct = objectAt(objPath);
-    if (!ct)
+    if (m_type != data->type) {
+        if (data->type == Object)
+            allocData<Object>();
+        else
+            allocData<Array>();
+    }
+
+    // The current child nodes are matched by key in objects and by position in arrays
+    QVector<JsonTreeItem *> previous = data->type == Object ? asType<Object>() : asType<Array>();
+    QHash<QString, int> positions;
+    if (data->type == Object) {
+        positions.reserve(previous.size());
+        for (int pos = previous.size() - 1; pos >= 0; --pos)
+            positions.insert(previous.at(pos)->m_key, pos);
+    }
+
+    dropIndex();
+    QVector<JsonTreeItem *> &children = m_data.children;
+    children.clear();
+    children.reserve(data->children.size());
+
+    for (int pos = 0; pos < data->children.size(); ++pos) {
+        int previousPos = -1;
+        if (data->type == Array) {
+            previousPos = pos < previous.size() ? pos : -1;
+        } else {
+            auto it = positions.find(data->keys.at(pos));
+            if (it != positions.end()) {
+                previousPos = it.value();
+                positions.erase(it);
+            }
+        }
+
+        JsonTreeItem *child;
+        if (previousPos >= 0) {
+            child = previous.at(previousPos);
+            previous[previousPos] = nullptr;
+        } else {
+            child = newItem();
+            child->m_parent = this;
+            if (data->type == Object)
+                child->assignKey(data->keys.at(pos));
+        }
+
+        children.push_back(child);
+        child->restore(data->children.at(pos));
+    }
+
+    // Child nodes, which are not in the snapshot, are deleted
+    bool removed = false;
+    for (JsonTreeItem *item : qAsConst(previous)) {
+        if (item) {
+            destroyItem(item);
+            removed = true;
+        }
+    }
+    if (removed)
+        bumpGeneration();
+
+    markDirty();
+}
+
+bool JsonTreeItem::update(JsonTreeItem &source, QVector<JsonPath> *changedPaths)
+{
+    QStringList path;
+    return updateNode(nullptr, &source, path, changedPaths);
+}
+
+bool JsonTreeItem::update(JsonTreeItem &previous, JsonTreeItem &next, QVector<JsonPath> *changedPaths)
+{
+    QStringList path;
+    return updateNode(&previous, &next, path, changedPaths);
+}
+
+QByteArray JsonTreeItem::diff(const JsonTreeItem &other, JsonFormat format)
+{
+    return diff(snapshot(), other.temporarySnapshot(), format);
+}
+
+QByteArray JsonTreeItem::diff(const JsonSnapshot &from, const JsonSnapshot &to, JsonFormat format)
+{
+    JsonTreeItem patch;
+    patch.setType<Array>();
+    JsonPatch::diff(from, to, &patch);
+    return patch.saveToJson(format);
+}
+
+bool JsonTreeItem::applyPatch(const QByteArray &patch)
+{
+    JsonTreeItem operations;
+    if (!operations.loadFromJson(patch))
         return false;
-    return ct->find(key) != nullptr;
+
+    // Taking the snapshot only creates the snapshot nodes of the paths, which have changed since the
+    // last one, and restoring it only touches the paths, which the patch has changed
+    const JsonSnapshot previous = snapshot();
+    if (JsonPatch::apply(this, &operations))
+        return true;
+
+    restore(previous);
+    return false;
 }
 
-void JsonTreeItem::removeItem(const QString &objPath, const QString &key)
+bool JsonTreeItem::updateNode(JsonTreeItem *previous, JsonTreeItem *next, QStringList &path, QVector<JsonPath> *changedPaths)
 {
-    JsonTreeItem *ct = objectAt(objPath);
-    JsonTreeItem *ctKey = ct->find(key);
-    if (ctKey) {
-        ct->asType<Object>().removeOne(ctKey);
-        delete ctKey;
+    // Subtrees, which have not been parsed in both versions, are compared by their text
+    if (previous && previous->m_type == next->m_type && (previous->m_flags & next->m_flags & LazyNode)) {
+        const JsonTreeItemData::LazyRange &range = previous->m_data.range;
+        const JsonTreeItemData::LazyRange &nextRange = next->m_data.range;
+        if (range.end - range.begin == nextRange.end - nextRange.begin &&
+            memcmp(range.begin, nextRange.begin, static_cast<size_t>(range.end - range.begin)) == 0)
+            return false;
+    }
+
+    switch (m_type == next->m_type ? m_type : None) {
+    case Value: {
+        // The data of derived classes is updated as a whole, e.g. an encoded array
+        if (hasExtended()) {
+            if (!updateExtended(next->snapshot()))
+                return false;
+            break;
+        }
+
+        // Values of another type are different, even if QVariant could convert them into each other
+        const QVariant &value = next->asType<Value>();
+        const QVariant &current = asType<Value>();
+        if (current.userType() == value.userType() && current == value)
+            return false;
+
+        forceAsType<Value>() = value;
+        break;
+    }
+    case Object:
+    case Array:
+        // The data of derived classes is updated as a whole
+        if (hasExtended()) {
+            if (!updateExtended(next->snapshot()))
+                return false;
+            break;
+        }
+        return m_type == Object ? updateObject(previous, next, path, changedPaths)
+                                : updateArray(previous, next, path, changedPaths);
+    default:
+        // Both nodes are null
+        if (m_type == None && next->m_type == None)
+            return false;
+
+        // The type has changed, the nodes are reused where possible
+        restore(next->snapshot());
+        break;
     }
+
+    if (changedPaths)
+        changedPaths->push_back(JsonPath(path));
+    return true;
 }
 
-JsonTreeItem *JsonTreeItem::itemAt(const QString &objPath, const QString &key)
+bool JsonTreeItem::updateObject(JsonTreeItem *previous, JsonTreeItem *next, QStringList &path, QVector<JsonPath> *changedPaths)
 {
-    JsonTreeItem *obj = objectAt(objPath);
-    JsonTreeItem *item = obj->find(key);
-    if (!item) {
-        item = newItem();
-        item->m_key = key;
-        obj->object().push_back(item);
+    QVector<JsonTreeItem *> &children = asType<Object>();
+    const QVector<JsonTreeItem *> &nextChildren = next->asType<Object>();
+
+    // The previous version is only of use, if it is an object as well
+    if (previous && previous->m_type != Object)
+        previous = nullptr;
+
+    // Child node of the previous version with the key, which is usually at the same position
+    auto previousChild = [previous](int pos, const QString &key) -> JsonTreeItem * {
+        if (!previous)
+            return nullptr;
+        const QVector<JsonTreeItem *> &previousChildren = previous->asType<Object>();
+        if (pos < previousChildren.size() && previousChildren.at(pos)->m_key == key)
+            return previousChildren.at(pos);
+        return previous->find(key);
+    };
+
+    // Usually the keys of a new version are the same and only some of the values have changed
+    bool sameKeys = children.size() == nextChildren.size();
+    for (int pos = 0; sameKeys && pos < children.size(); ++pos)
+        sameKeys = children.at(pos)->m_key == nextChildren.at(pos)->m_key;
+
+    bool changed = false;
+    if (sameKeys) {
+        for (int pos = 0; pos < children.size(); ++pos) {
+            JsonTreeItem *nextChild = nextChildren.at(pos);
+            path.push_back(nextChild->m_key);
+            changed |= children.at(pos)->updateNode(previousChild(pos, nextChild->m_key), nextChild, path, changedPaths);
+            path.pop_back();
+        }
+        return changed;
     }
-    return item;
+
+    // Otherwise the child nodes are matched by key like in restoreChildren()
+    QVector<JsonTreeItem *> current = children;
+    QHash<QString, int> positions;
+    positions.reserve(current.size());
+    for (int pos = current.size() - 1; pos >= 0; --pos)
+        positions.insert(current.at(pos)->m_key, pos);
+
+    QVector<JsonTreeItem *> updated;
+    updated.reserve(nextChildren.size());
+
+    for (int pos = 0; pos < nextChildren.size(); ++pos) {
+        JsonTreeItem *nextChild = nextChildren.at(pos);
+        path.push_back(nextChild->m_key);
+
+        JsonTreeItem *child;
+        auto it = positions.find(nextChild->m_key);
+        if (it != positions.end()) {
+            child = current.at(it.value());
+            current[it.value()] = nullptr;
+            positions.erase(it);
+            child->updateNode(previousChild(pos, nextChild->m_key), nextChild, path, changedPaths);
+        } else {
+            child = newItem();
+            child->m_parent = this;
+            child->assignKey(nextChild->m_key);
+            child->restore(nextChild->snapshot());
+            if (changedPaths)
+                changedPaths->push_back(JsonPath(path));
+        }
+
+        updated.push_back(child);
+        path.pop_back();
+    }
+
+    // Child nodes, which are not in the new version, are deleted
+    bool removed = false;
+    for (JsonTreeItem *item : qAsConst(current)) {
+        if (!item)
+            continue;
+
+        if (changedPaths) {
+            path.push_back(item->m_key);
+            changedPaths->push_back(JsonPath(path));
+            path.pop_back();
+        }
+        destroyItem(item);
+        removed = true;
+    }
+    if (removed)
+        bumpGeneration();
+
+    dropIndex();
+    children = updated;
+    markDirty();
+    return true;
+}
+
+bool JsonTreeItem::updateArray(JsonTreeItem *previous, JsonTreeItem *next, QStringList &path, QVector<JsonPath> *changedPaths)
+{
+    QVector<JsonTreeItem *> &children = asType<Array>();
+    const QVector<JsonTreeItem *> &nextChildren = next->asType<Array>();
+    const int size = nextChildren.size();
+
+    // The elements are matched by position, which only corresponds to the previous version, if the
+    // array has not been resized in this tree since
+    const QVector<JsonTreeItem *> *previousChildren = nullptr;
+    if (previous && previous->m_type == Array && previous->asType<Array>().size() == children.size())
+        previousChildren = &previous->asType<Array>();
+
+    bool changed = false;
+    for (int pos = 0; pos < qMin(children.size(), size); ++pos) {
+        path.push_back(QString::number(pos));
+        changed |= children.at(pos)->updateNode(previousChildren ? previousChildren->at(pos) : nullptr,
+                                                nextChildren.at(pos), path, changedPaths);
+        path.pop_back();
+    }
+
+    for (int pos = children.size(); pos < size; ++pos) {
+        JsonTreeItem *child = newItem();
+        insertChild(child);
+        child->restore(nextChildren.at(pos)->snapshot());
+        if (changedPaths) {
+            path.push_back(QString::number(pos));
+            changedPaths->push_back(JsonPath(path));
+            path.pop_back();
+        }
+        changed = true;
+    }
+
+    if (children.size() > size) {
+        for (int pos = size; pos < children.size(); ++pos) {
+            if (changedPaths) {
+                path.push_back(QString::number(pos));
+                changedPaths->push_back(JsonPath(path));
+                path.pop_back();
+            }
+            destroyItem(children.at(pos));
+        }
+        children.resize(size);
+        bumpGeneration();
+        markDirty();
+        changed = true;
+    }
+
+    return changed;
 }
 
 JsonTreeItem *JsonTreeItem::objectAt(const QString &objPath)
+{
+    const QStringList dirs = objPath.split("/", Qt::SkipEmptyParts);
+    return objectAt(dirs, dirs.size());
+}
+
+const JsonTreeItem *JsonTreeItem::objectAt(const QString &objPath) const
+{
+    const QStringList dirs = objPath.split("/", Qt::SkipEmptyParts);
+    return objectAt(dirs, dirs.size());
+}
+
+JsonTreeItem *JsonTreeItem::objectAt(const QStringList &segments, int depth)
 {
     if (m_type != Object)
         reset();
 
-    if (objPath.isEmpty())
-        return this;
+    JsonTreeItem *obj = this;
+    for (int i = 0; i < depth; ++i)
+        obj = obj->forceKeyAsType<Object>(segments.at(i));
 
-    QStringList dirs = objPath.split("/", Qt::SkipEmptyParts);
-    const QString key0 = dirs[0];
-    dirs.removeAt(0);
-    QString restPath;
-    if (dirs.size() > 0)
-        restPath = dirs.join("/");
-
-    return forceKeyAsType<Object>(key0)->objectAt(restPath);
+    return obj;
 }
 
-const JsonTreeItem *JsonTreeItem::objectAt(const QString &objPath) const
+const JsonTreeItem *JsonTreeItem::objectAt(const QStringList &segments, int depth) const
 {
     if (m_type != Object)
         return nullptr;
 
-    if (objPath.isEmpty())
-        return this;
+    const JsonTreeItem *obj = this;
+    for (int i = 0; i < depth; ++i) {
+        obj = obj->find(segments.at(i));
+        if (!obj || obj->m_type != Object)
+            return nullptr;
+    }
 
-    QStringList dirs = objPath.split("/", Qt::SkipEmptyParts);
-    const QString key0 = dirs[0];
-    dirs.removeAt(0);
-    QString restPath;
-    if (dirs.size() > 0)
-        restPath = dirs.join("/");
+    return obj;
+}
 
-    const JsonTreeItem *child = find(key0);
-    if (!child)
-        return nullptr;
-    return child->objectAt(restPath);
+void JsonTreeItem::bumpGeneration()
+{
+    for (JsonTreeItem *item = this; item; item = item->m_parent)
+        ++item->m_generation;
 }
 
 JsonTreeItem *JsonTreeItem::find(const QString &key)
@@ -181,12 +1319,10 @@ JsonTreeItem *JsonTreeItem::find(const QString &key)
     if (m_type != Object)
         return nullptr;
 
-    for (JsonTreeItem *ct : qAsConst(asType<Object>())) {
-        if (ct->m_key == key)
-            return ct;
-    }
+    syncIndex();
 
-    return nullptr;
+    const int pos = indexOf(key);
+    return pos >= 0 ? asType<Object>().at(pos) : nullptr;
 }
 
 const JsonTreeItem *JsonTreeItem::find(const QString &key) const
@@ -194,162 +1330,340 @@ const JsonTreeItem *JsonTreeItem::find(const QString &key) const
     if (m_type != Object)
         return nullptr;
 
-    for (const JsonTreeItem *ct : qAsConst(asType<Object>())) {
-        if (ct->m_key == key)
-            return ct;
+    const int pos = indexOf(key);
+    return pos >= 0 ? asType<Object>().at(pos) : nullptr;
+}
+
+int JsonTreeItem::indexOf(const QString &key) const
+{
+    const QVector<JsonTreeItem *> &children = asType<Object>();
+
+    if (m_index && m_index->count == children.size()) {
+        // The vector of an exposed object may have been changed in place without changing its size,
+        // so a key, which is missing in its index, is searched for in the child nodes
+        auto it = m_index->positions.constFind(key);
+        if (it == m_index->positions.constEnd() && !(m_flags & ExposedNode)) {
+            countLookup(true, 0);
+            return -1;
+        }
+        // Verify the position, in case the child nodes have been rearranged in place
+        const int pos = it != m_index->positions.constEnd() ? it.value() : -1;
+        if (pos >= 0 && pos < children.size() && children.at(pos)->m_key == key) {
+            countLookup(true, 0);
+            return pos;
+        }
+    }
+
+    // Interned keys are compared by their ids, a key, which is not in the pool, can only match keys,
+    // which are not interned either
+    const quint16 id = keyId(key);
+    for (int pos = 0; pos < children.size(); ++pos) {
+        const JsonTreeItem *child = children.at(pos);
+        if (child->m_keyId ? child->m_keyId == id : child->m_key == key) {
+            countLookup(false, pos + 1);
+            return pos;
+        }
     }
 
-    return nullptr;
+    countLookup(false, children.size());
+    return -1;
 }
 
-void JsonTreeItem::import(const QJsonObject &obj)
+void JsonTreeItem::syncIndex()
 {
-    allocData<Object>();
+    const QVector<JsonTreeItem *> &children = asType<Object>();
+
+    if (children.size() < IndexThreshold) {
+        dropIndex();
+        return;
+    }
+
+    if (m_index && m_index->count == children.size())
+        return;
+
+    if (!m_index)
+        m_index = new JsonTreeItemData::ChildIndex;
 
-    const QStringList objKeys = obj.keys();
-    for (const QString &key : objKeys) {
-        JsonTreeItem *ct = newItem();
-        ct->m_key = key;
-        ct->import(obj[key]);
-        asType<Object>().push_back(ct);
+    m_index->positions.clear();
+    m_index->positions.reserve(children.size());
+    for (int pos = 0; pos < children.size(); ++pos) {
+        // Child nodes, which have been appended to the vector directly, get their parent, so that
+        // setKey() invalidates the index from now on
+        JsonTreeItem *child = children.at(pos);
+        adoptChild(child);
+
+        // Duplicate keys resolve to the first child node, like in a linear scan
+        if (!m_index->positions.contains(child->m_key))
+            m_index->positions.insert(child->m_key, pos);
     }
+    m_index->count = children.size();
+}
+
+void JsonTreeItem::dropIndex()
+{
+    delete m_index;
+    m_index = nullptr;
 }
 
-void JsonTreeItem::import(const QJsonArray &arr)
+void JsonTreeItem::insertChild(JsonTreeItem *item)
 {
-    allocData<Array>();
+    item->m_parent = this;
+    markDirty();
+
+    if (m_type == Array) {
+        asType<Array>().push_back(item);
+        return;
+    }
 
-    for (const QJsonValue &val : arr) {
-        JsonTreeItem *ct = newItem();
-        ct->m_key = QString();
-        ct->import(val);
-        asType<Array>().push_back(ct);
+    QVector<JsonTreeItem *> &children = asType<Object>();
+    if (m_index && m_index->count == children.size()) {
+        if (!m_index->positions.contains(item->m_key))
+            m_index->positions.insert(item->m_key, children.size());
+        ++m_index->count;
     }
+    children.push_back(item);
 }
 
-void JsonTreeItem::import(const QJsonValue &val)
+void JsonTreeItem::insertChildAt(int pos, JsonTreeItem *item)
 {
-    if (val.isString() || val.isDouble() || val.isBool() || val.isNull() || val.isUndefined()) {
-        allocData<Value>();
-        if (val.isString() || val.isDouble() || val.isBool())
-            asType<Value>() = val.toVariant();
-    } else {
-        if (val.isObject())
-            import(val.toObject());
-        else if (val.isArray())
-            import(val.toArray());
+    QVector<JsonTreeItem *> &children = m_type == Object ? asType<Object>() : asType<Array>();
+    if (pos == children.size()) {
+        insertChild(item);
+        return;
     }
+
+    // The positions in the index behind the node would have to be shifted
+    dropIndex();
+    item->m_parent = this;
+    children.insert(pos, item);
+    markDirty();
 }
 
-void JsonTreeItem::append(const QJsonObject &obj)
+void JsonTreeItem::removeChildAt(int pos)
 {
-    if (m_type != Object)
-        // If the element alreadys exists with a different type, overwrite it
-        allocData<Object>();
-
-    const QStringList objKeys = obj.keys();
-    for (const QString &key : objKeys) {
-        // Check, if the key already exists
-        JsonTreeItem *ct = find(key);
-        if (!ct) {
-            // If the key doesn't exists, create a new one
-            ct = newItem();
-            ct->m_key = key;
-            asType<Object>().push_back(ct);
+    destroyItem(takeChildAt(pos));
+}
+
+JsonTreeItem *JsonTreeItem::takeChildAt(int pos)
+{
+    QVector<JsonTreeItem *> &children = m_type == Object ? asType<Object>() : asType<Array>();
+    JsonTreeItem *item = children.at(pos);
+
+    // Removing the last child node keeps the index, otherwise the positions behind it would have to
+    // be shifted, so it is rebuilt on the next lookup instead
+    if (m_index) {
+        if (pos == children.size() - 1 && m_index->count == children.size()) {
+            m_index->positions.remove(item->m_key);
+            --m_index->count;
+        } else {
+            dropIndex();
         }
-        ct->append(obj[key]);
     }
+
+    children.remove(pos);
+    bumpGeneration();
+    markDirty();
+
+    // A duplicate of the removed key has to be indexed again
+    if (m_index && m_index->positions.size() != m_index->count)
+        dropIndex();
+
+    return item;
 }
 
-void JsonTreeItem::append(const QJsonArray &arr)
+#ifdef JSONCONFIG_STATS
+
+namespace {
+
+// Approximate heap memory of the data of implicitly shared Qt containers in Qt 5
+constexpr qint64 ArrayDataBytes = 24;
+// Approximate memory of an entry of the hash index with its node
+constexpr qint64 IndexEntryBytes = 40;
+
+qint64 stringBytes(const QString &str)
 {
-    if (m_type != Array)
-        // If the element alreadys exists with a different type, overwrite it
-        allocData<Array>();
+    return str.isNull() ? 0 : ArrayDataBytes + (str.capacity() + 1) * 2;
+}
 
-    for (const QJsonValue &val : arr) {
-        JsonTreeItem *ct = newItem();
-        ct->m_key = QString();
-        ct->import(val);
-        asType<Array>().push_back(ct);
+qint64 variantBytes(const QVariant &value)
+{
+    switch (value.userType()) {
+    case QMetaType::QString:
+        return stringBytes(value.toString());
+    case QMetaType::QByteArray:
+        return ArrayDataBytes + value.toByteArray().capacity() + 1;
+    case QMetaType::QStringList: {
+        const QStringList list = value.toStringList();
+        qint64 bytes = ArrayDataBytes + list.size() * sizeof(void *);
+        for (const QString &str : list)
+            bytes += stringBytes(str);
+        return bytes;
+    }
+    case QMetaType::QVariantList: {
+        const QVariantList list = value.toList();
+        qint64 bytes = ArrayDataBytes + list.size() * sizeof(void *);
+        for (const QVariant &item : list)
+            bytes += sizeof(QVariant) + variantBytes(item);
+        return bytes;
     }
+    default:
+        return 0;
+    }
+}
+
 }
 
-void JsonTreeItem::append(const QJsonValue &val)
+JsonTreeStats JsonTreeItem::stats() const
 {
-    if (val.isString() || val.isDouble() || val.isBool() || val.isNull() || val.isUndefined()) {
-        // Overwrite value, if already exists
-        allocData<Value>();
-        if (val.isString() || val.isDouble() || val.isBool())
-            asType<Value>() = val.toVariant();
-    } else {
-        if (val.isObject())
-            append(val.toObject());
-        else if (val.isArray())
-            append(val.toArray());
+    JsonTreeStats stats;
+    countNode(stats, 0);
+
+    // The sizes of the child subtrees are the differences of the totals before and after them
+    if ((m_type == Object || m_type == Array) && !(m_flags & LazyNode)) {
+        QVector<JsonTreeStats::Subtree> subtrees;
+        subtrees.reserve(m_data.children.size());
+        for (int pos = 0; pos < m_data.children.size(); ++pos) {
+            const JsonTreeItem *child = m_data.children.at(pos);
+            const qint64 nodes = stats.nodes();
+            const qint64 bytes = stats.bytes;
+            child->collectStats(stats, 1);
+
+            JsonTreeStats::Subtree subtree;
+            subtree.key = m_type == Object ? child->m_key : QString::number(pos);
+            subtree.nodes = stats.nodes() - nodes;
+            subtree.bytes = stats.bytes - bytes;
+            subtrees.push_back(subtree);
+        }
+
+        const int count = std::min<int>(subtrees.size(), JsonTreeStats::MaxSubtrees);
+        std::partial_sort(subtrees.begin(), subtrees.begin() + count, subtrees.end(),
+                          [](const JsonTreeStats::Subtree &a, const JsonTreeStats::Subtree &b) { return a.bytes > b.bytes; });
+        subtrees.resize(count);
+        stats.largestSubtrees = subtrees;
+    }
+
+    // Without a state no event has been recorded in the tree of this node
+    if (m_tree) {
+        const JsonTreeItemData::StatsCounters &counters = m_tree->stats;
+        stats.lookups = counters.lookups.loadRelaxed();
+        stats.indexedLookups = counters.indexedLookups.loadRelaxed();
+        stats.scannedNodes = counters.scannedNodes.loadRelaxed();
+        stats.createdNodes = counters.createdNodes.loadRelaxed();
+        stats.retypedNodes = counters.retypedNodes.loadRelaxed();
+        for (int phase = 0; phase < JsonTreeStats::PhaseCount; ++phase) {
+            stats.phases[phase].count = counters.phases[phase].count.loadRelaxed();
+            stats.phases[phase].nsecs = counters.phases[phase].nsecs.loadRelaxed();
+            stats.phases[phase].bytes = counters.phases[phase].bytes.loadRelaxed();
+        }
     }
+
+    return stats;
 }
 
-QJsonObject JsonTreeItem::exportObject()
+void JsonTreeItem::resetStats()
 {
-    finalizeForExport();
+    JsonTreeItemData::StatsCounters &counters = ensureStatsCounters();
+    counters.lookups.storeRelaxed(0);
+    counters.indexedLookups.storeRelaxed(0);
+    counters.scannedNodes.storeRelaxed(0);
+    counters.createdNodes.storeRelaxed(0);
+    counters.retypedNodes.storeRelaxed(0);
+    for (JsonTreeItemData::StatsCounters::Phase &phase : counters.phases) {
+        phase.count.storeRelaxed(0);
+        phase.nsecs.storeRelaxed(0);
+        phase.bytes.storeRelaxed(0);
+    }
+}
 
-    if (m_type != Object)
-        return QJsonObject();
+void JsonTreeItem::countLookup(bool indexed, int scanned) const
+{
+    // Lookups are const, so they do not create the state of the tree
+    JsonTreeItemData::StatsCounters *counters = statsCounters();
+    if (!counters)
+        return;
 
-    QJsonObject obj;
-    for (JsonTreeItem *item : qAsConst(asType<Object>())) {
-        switch (item->m_type) {
-        case Value:
-            obj.insert(item->m_key, item->exportValue());
-            break;
-        case Object:
-            obj.insert(item->m_key, item->exportObject());
-            break;
-        case Array:
-            obj.insert(item->m_key, item->exportArray());
-            break;
-        default:
-            break;
-        }
+    counters->lookups.fetchAndAddRelaxed(1);
+    if (indexed)
+        counters->indexedLookups.fetchAndAddRelaxed(1);
+    else
+        counters->scannedNodes.fetchAndAddRelaxed(scanned);
+}
+
+void JsonTreeItem::countCreated(bool retyped)
+{
+    JsonTreeItemData::StatsCounters &counters = ensureStatsCounters();
+    if (retyped)
+        counters.retypedNodes.fetchAndAddRelaxed(1);
+    else
+        counters.createdNodes.fetchAndAddRelaxed(1);
+}
+
+JsonTreeItemData::StatsCounters &JsonTreeItem::ensureStatsCounters()
+{
+    if (!m_tree) {
+        // Nodes, which have been created before the root had a state, take over the one of the root
+        JsonTreeItem *root = this;
+        while (root->m_parent)
+            root = root->m_parent;
+        root->adoptTree(root->ensureTree());
     }
+    return m_tree->stats;
+}
 
-    return obj;
+void JsonTreeItem::adoptTree(JsonTreeItemData::Tree *tree)
+{
+    m_tree = tree;
+    if ((m_type != Object && m_type != Array) || (m_flags & LazyNode))
+        return;
+
+    for (JsonTreeItem *child : qAsConst(m_data.children))
+        child->adoptTree(tree);
 }
 
-QJsonArray JsonTreeItem::exportArray()
+void JsonTreeItem::countNode(JsonTreeStats &stats, int depth) const
 {
-    finalizeForExport();
+    stats.maxDepth = std::max(stats.maxDepth, depth);
 
-    if (m_type != Array)
-        return QJsonArray();
+    // Interned keys are held by the pool of the tree
+    qint64 bytes = sizeof(JsonTreeItem);
+    if (!m_keyId)
+        bytes += stringBytes(m_key);
+    if (m_index)
+        bytes += sizeof(JsonTreeItemData::ChildIndex) + m_index->positions.size() * IndexEntryBytes;
 
-    QJsonArray arr;
-    for (JsonTreeItem *item : qAsConst(asType<Array>())) {
-        switch (item->m_type) {
+    if (m_flags & LazyNode) {
+        ++stats.lazyNodes;
+        stats.lazySourceBytes += m_data.range.end - m_data.range.begin;
+    } else {
+        switch (m_type) {
+        case None:
+            ++stats.noneNodes;
+            break;
         case Value:
-            arr.append(item->exportValue());
+            ++stats.valueNodes;
+            bytes += variantBytes(m_data.value);
             break;
         case Object:
-            arr.append(item->exportObject());
-            break;
         case Array:
-            arr.append(item->exportArray());
-            break;
-        default:
+            ++(m_type == Object ? stats.objectNodes : stats.arrayNodes);
+            bytes += ArrayDataBytes + m_data.children.capacity() * sizeof(JsonTreeItem *);
+            stats.maxFanOut = std::max(stats.maxFanOut, m_data.children.size());
             break;
         }
     }
 
-    return arr;
+    stats.bytes += bytes;
 }
 
-QJsonValue JsonTreeItem::exportValue()
+void JsonTreeItem::collectStats(JsonTreeStats &stats, int depth) const
 {
-    finalizeForExport();
+    countNode(stats, depth);
 
-    if (m_type != Value)
-        return QJsonValue();
+    if ((m_type != Object && m_type != Array) || (m_flags & LazyNode))
+        return;
 
-    return QJsonValue::fromVariant(asType<Value>());
+    for (const JsonTreeItem *child : m_data.children)
+        child->collectStats(stats, depth + 1);
 }
+
+#endif
@@ -1,18 +1,29 @@
 #ifndef JSONTREEITEM_H
 #define JSONTREEITEM_H
 
+#include <QFuture>
+#include <QHash>
 #include <QString>
 #include <QVariant>
 
-class QJsonArray;
-class QJsonObject;
-class QJsonValue;
+#include <memory>
+#include <new>
+
+#include "jsonsnapshot.h"
+#include "jsontreearena.h"
+#include "jsontreestats.h"
+
+class QFile;
+class QIODevice;
+class JsonKeyPool;
+class JsonPath;
 class JsonTreeItem;
+struct JsonParseError;
 
 namespace JsonTreeItemData {
 
 // Define available key datatypes
-enum Type {
+enum Type : quint8 {
     None,
     Value,
     Object,
@@ -27,6 +38,91 @@ template<> struct TypeTraits<Value>  { using Type = QVariant; };
 template<> struct TypeTraits<Object> { using Type = QVector<JsonTreeItem *>; };
 template<> struct TypeTraits<Array>  { using Type = QVector<JsonTreeItem *>; };
 
+// Position of a lazy node in the source document, from the opening to behind the closing bracket
+struct LazyRange
+{
+    const char *begin;
+    const char *end;
+};
+
+// State of a tree, which is shared by its nodes and owned by the root
+struct Tree
+{
+    // Arena, from which the nodes are allocated, if it is enabled
+    JsonTreeArena *arena = nullptr;
+
+    // Interned keys of the nodes, if key interning is enabled
+    JsonKeyPool *keys = nullptr;
+
+    // Source document, which is referenced by lazy nodes, either as byte array or as mapped file
+    QByteArray source;
+    QFile *sourceFile = nullptr;
+
+    // Sources of lazy nodes, which have been inserted from other trees by insertItem()
+    QVector<QByteArray> graftedSources;
+
+    // Output of the last save at the root, which contains the fragments of the clean nodes
+    QByteArray saveCache;
+    int saveFormat = 0;
+    bool saveCacheValid = false;
+
+#ifdef JSONCONFIG_STATS
+    // Counters of lookups and of the load and save phases (see JsonTreeStats)
+    StatsCounters stats;
+#endif
+};
+
+// Receiver of the elements of an object or an array, which are passed without creating nodes
+// Derived classes of JsonTreeItem use it to export the data, which they keep apart from the tree, and
+// to load their data directly from the document. The keys of array elements are null. Strings and
+// numbers are passed to addValue(), unless the typed functions are overridden.
+class ElementSink
+{
+public:
+    virtual ~ElementSink() {}
+
+    virtual void addValue(const QString &key, const QVariant &value) = 0;
+    virtual void addString(const QString &key, const QString &str) { addValue(key, str); }
+    virtual void addInteger(const QString &key, qint64 number) { addValue(key, number); }
+    virtual void addDouble(const QString &key, double number) { addValue(key, number); }
+    virtual void addFloat(const QString &key, float number) { addValue(key, number); }
+};
+
+// Read-only view of the child nodes of an object or an array, which the const accessors return, so
+// that the child nodes cannot be changed through a const node
+// Like a reference to the vector, it is invalid after child nodes have been added or removed.
+class ConstChildren
+{
+public:
+    using const_iterator = const JsonTreeItem *const *;
+
+    ConstChildren() : m_begin(nullptr), m_size(0) {}
+    explicit ConstChildren(const QVector<JsonTreeItem *> &children)
+        : m_begin(children.constData()), m_size(children.size()) {}
+
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    const JsonTreeItem *at(int pos) const { Q_ASSERT(pos >= 0 && pos < m_size); return m_begin[pos]; }
+    const JsonTreeItem *operator[](int pos) const { return at(pos); }
+    const JsonTreeItem *first() const { return at(0); }
+    const JsonTreeItem *last() const { return at(m_size - 1); }
+
+    const_iterator begin() const { return m_begin; }
+    const_iterator end() const { return m_begin + m_size; }
+
+private:
+    const JsonTreeItem *const *m_begin;
+    int m_size;
+};
+
+// Auxiliary lookup table of a wide object, which maps the keys to their positions in the child vector
+struct ChildIndex
+{
+    QHash<QString, int> positions;
+    int count; // Number of child nodes the index is in sync with
+};
+
 }
 
 class JsonTreeItem
@@ -37,25 +133,154 @@ public:
     template<DataType _T>
     using ValueType = typename JsonTreeItemData::TypeTraits<_T>::Type;
 
+    using ConstChildren = JsonTreeItemData::ConstChildren;
+
     static constexpr DataType None   = JsonTreeItemData::None;
     static constexpr DataType Value  = JsonTreeItemData::Value;
     static constexpr DataType Object = JsonTreeItemData::Object;
     static constexpr DataType Array  = JsonTreeItemData::Array;
 
+    // Output formats of the serialization
+    enum JsonFormat {
+        Indented,
+        Compact
+    };
+
+    // Modes for loading a document
+    enum LoadMode {
+        // Create all nodes while loading
+        Eager,
+        // Validate the document, but parse the children of an object or an array only on their first
+        // access. The source is kept until the tree is cleared, subtrees, which have not been accessed,
+        // are written without parsing them. Lazy loading is only supported by the root.
+        Lazy,
+        // Create all nodes while loading, the subtrees of large documents are parsed on the threads
+        // of QThreadPool::globalInstance() (see JsonParallelLoader). The tree is the same as with
+        // Eager. Parallel loading is only supported by the root, appendJson() always uses Eager.
+        Parallel
+    };
+
+    // Objects with at least this number of keys get a hash index for their lookups
+    static constexpr int IndexThreshold = 16;
+
     JsonTreeItem();
     virtual ~JsonTreeItem();
 
     // Serialization and deserialization to a file
-    void loadFromFile(const QString &filename);
-    void saveToFile(const QString &filename);
+    // The file is memory-mapped and parsed directly from the mapping, without copying it first.
+    // If the file cannot be read, the tree is unchanged. If the document is invalid, the tree is empty.
+    // In both cases the error is reported, if error is not a nullptr.
+    // With lazy loading, the file stays mapped until the tree is cleared, so it must not be truncated
+    // in the meantime. Replacing it, like saveToFile() does, is safe.
+    bool loadFromFile(const QString &filename, JsonParseError *error = nullptr, LoadMode mode = Eager);
+    // The file is replaced atomically, if the save fails, the previous file is left unchanged.
+    bool saveToFile(const QString &filename, JsonFormat format = Indented);
+
+    // Save to a file without blocking on the file system
+    // The document is serialized on the calling thread, which at the root only serializes the changed
+    // subtrees again, and written atomically on a worker thread. Saves are written in the order they
+    // are requested. A save, which is requested while the previous one of the same file is still
+    // waiting, replaces it and both futures return the result of the single write.
+    // The future returns whether the file has been written.
+    QFuture<bool> saveToFileAsync(const QString &filename, JsonFormat format = Indented);
 
     // Serialization and deserializiation to a JSON byte array
-    void loadFromJson(const QByteArray &json);
-    QByteArray saveToJson();
+    bool loadFromJson(const QByteArray &json, JsonParseError *error = nullptr, LoadMode mode = Eager);
+    QByteArray saveToJson(JsonFormat format = Indented);
+
+    // Serialization and deserialization to a binary snapshot (see JsonBinaryWriter)
+    // The snapshot is loaded much faster than JSON and keeps the types of the values. It is meant as
+    // a cache of a JSON document, whose format may change with the version of this library. If the
+    // snapshot is invalid or of another version, the tree is empty and the error is reported.
+    // Saving a snapshot materializes lazy nodes.
+    bool loadFromBinary(const QByteArray &data, JsonParseError *error = nullptr);
+    QByteArray saveToBinary();
+
+    // The snapshot file is replaced atomically like in saveToFile()
+    bool loadFromBinaryFile(const QString &filename, JsonParseError *error = nullptr);
+    bool saveToBinaryFile(const QString &filename);
+
+    // Serialization into a reusable buffer, which is cleared first but keeps its capacity
+    // At the root, the buffer shares the output with the cache for incremental saving instead.
+    bool saveToJson(QByteArray &buffer, JsonFormat format = Indented);
+
+    // Serialization into an open device
+    // Below the root, the document is streamed. At the root, it is written through the cache.
+    bool saveToDevice(QIODevice *device, JsonFormat format = Indented);
+
+    // Saving at the root keeps the output and reuses the fragments of clean subtrees on the next save
+    // in the same format, so after a small change only the changed path is serialized again.
+    // Nodes are marked dirty together with their ancestors by every non-const function, which may
+    // change them. A node, to whose data value(), array(), object() or the accessors of derived
+    // classes have returned a reference, may still be changed through it after the save. So it is
+    // serialized again on every save, until its data is released, and only the subtrees of the other
+    // nodes are reused. setValue() changes a value without returning a reference. Changes through
+    // references, which have been kept, are not reported by isDirty().
+    bool isDirty() const { return m_flags & DirtyNode; }
+
+    // Immutable snapshot of this node and its subtree (see JsonSnapshot)
+    // The snapshot of a node is kept and returned again, until the node changes. So taking a snapshot
+    // only creates the snapshot nodes on the paths, which have changed since the last one, and is
+    // O(1) without changes. Each of these nodes gets a new vector of the snapshots of its children,
+    // so the cost is proportional to the summed width of the objects and arrays along the changed
+    // paths. The keys and the index of an object are shared with its last snapshot, while its keys
+    // stay the same. Nodes, to whose data a reference has been returned like for incremental saving,
+    // are compared with their last snapshot instead, which is returned again, if it has the same
+    // content. Lazy nodes are materialized.
+    JsonSnapshot snapshot();
+
+    // Restore the content of this node from a snapshot, e.g. of this node for undo
+    // Subtrees, which are unchanged since the snapshot, are kept with their nodes. Other nodes are
+    // reused for the same keys or positions, so pointers into the tree stay valid where possible.
+    void restore(const JsonSnapshot &snapshot);
+
+    // Bring the content of this node to that of the source, e.g. of a reloaded document
+    // Unlike restore(), nodes, whose content is equal to the source, are not touched at all, so they
+    // are not marked dirty and references returned by value() and the accessors of derived classes
+    // stay valid. Values, which differ, are assigned in place. The paths of the changed values and of
+    // the added, removed or retyped nodes relative to this node are appended to changedPaths, array
+    // elements by their position. Returns whether anything has changed. The source is materialized,
+    // where it is compared.
+    bool update(JsonTreeItem &source, QVector<JsonPath> *changedPaths = nullptr);
+
+    // Apply the changes between two versions of a document, which this node has been loaded from
+    // Subtrees, which have not been accessed in either version since they were loaded lazily, are
+    // compared by their text and skipped, if it is the same. So with lazily loaded versions, the cost
+    // is proportional to the changes apart from validating the next version. Nodes of this tree, whose
+    // text has not changed between the versions, are not compared, so changes of this tree in those
+    // subtrees are kept. Otherwise this works like update().
+    bool update(JsonTreeItem &previous, JsonTreeItem &next, QVector<JsonPath> *changedPaths = nullptr);
+
+    // Changes, which turn this node into the other one, as JSON Patch document (RFC 6902)
+    // Both nodes are compared through their snapshots, whose nodes keep the hashes of their subtrees
+    // (see JsonSnapshot::hash()). Subtrees with equal hashes are skipped without walking them. The
+    // patch consists of add, remove and replace operations, the members of objects are matched by key
+    // and the elements of arrays by position, after skipping the elements, which are equal at their
+    // head and at their tail. It is an empty array, if both nodes have the same content.
+    // The snapshot of this node is kept for the next diff. The other node is only read like by the
+    // const lookups, so several threads may diff against the same published tree. Its snapshot is
+    // built for the diff from the snapshots, which are kept in it, and then released, so unless
+    // snapshot() has been taken of it, each diff walks the whole other node. For repeated diffs of
+    // two trees, which change, the static diff() of their snapshots is proportional to the changes.
+    QByteArray diff(const JsonTreeItem &other, JsonFormat format = Compact);
+
+    // Changes between two snapshots, e.g. between the last one, which has been sent to a replica, and
+    // the current one of the same tree, whose unchanged subtrees are shared between them
+    static QByteArray diff(const JsonSnapshot &from, const JsonSnapshot &to, JsonFormat format = Compact);
+
+    // Apply a JSON Patch document (RFC 6902) with the operations add, remove, replace, move, copy and
+    // test to this node, the paths are JSON Pointers relative to it
+    // The patch is applied as a whole: if it is invalid or one of the operations fails, the node is
+    // restored from its snapshot before the patch and false is returned. Unchanged subtrees keep their
+    // nodes, so like diff() this is proportional to the changes, once the node has a snapshot. Paths,
+    // which lead into the data of derived classes, turn it into child nodes, which the accessors
+    // convert back.
+    bool applyPatch(const QByteArray &patch);
 
     // Append the structure in the byte array to the current tree
     // The structures of the two trees are being merged!
-    void appendJson(const QByteArray &json);
+    // If the document contains an error, the part before the error position has been merged.
+    bool appendJson(const QByteArray &json, JsonParseError *error = nullptr);
 
     // Delete all nodes recursively
     void clear();
@@ -63,40 +288,91 @@ public:
     // Delete everything and reset type to Object
     void reset() { allocData<Object>(); }
 
+    // Allocate the nodes of this tree from an arena, which is released at once, when the root is
+    // cleared, reset or destroyed. Nodes removed from the tree are reclaimed only then.
+    // This can only be set on the root and clears the tree. Nodes of an arena tree must not be
+    // deleted directly or moved into another tree.
+    void setArenaEnabled(bool enabled);
+    bool isArenaEnabled() const { return m_tree && m_tree->arena; }
+
+    // Share the keys of the objects in this tree through a pool (see JsonKeyPool)
+    // Each distinct key is stored once, lookups hash each path segment once and compare the ids of
+    // the keys instead of the strings. This pays off for arrays of many objects with the same keys.
+    // This can only be set on the root, the keys of the current nodes are interned or released.
+    // With interning, child nodes must not be moved into the vectors of another tree.
+    void setKeyInterningEnabled(bool enabled);
+    bool isKeyInterningEnabled() const { return m_tree && m_tree->keys; }
+
     bool contains(const QString &key) const { return contains(QString(), key); }
     bool contains(const QString &objPath, const QString &key) const;
+    bool contains(const JsonPath &path) const;
 
     // Remove key from tree
     void removeItem(const QString &key) { removeItem(QString(), key); }
     void removeItem(const QString &objPath, const QString &key);
 
+    // Detach the node at the path from the tree and hand over its subtree, nullptr if there is none
+    // The nodes are not copied, the subtree becomes a tree of its own, which keeps the source of its
+    // lazy nodes. Only nodes from an arena are copied to the heap, as the arena is released with the
+    // tree, and lazy nodes of a mapped file are materialized, as the mapping is released with it.
+    std::unique_ptr<JsonTreeItem> takeItem(const QString &key) { return takeItem(QString(), key); }
+    std::unique_ptr<JsonTreeItem> takeItem(const QString &objPath, const QString &key);
+    std::unique_ptr<JsonTreeItem> takeItem(const JsonPath &path);
+
+    // Insert a tree at the path, which replaces a node with the same key, and return its new root
+    // The nodes are spliced in without copying them, they only take over the state of this tree
+    // (key pool, source of lazy nodes), which walks the materialized nodes once. Nodes from an arena
+    // and lazy nodes of a mapped file are handled like by takeItem(). The tree has to consist of the
+    // nodes of this tree's class, e.g. returned by takeItem(), clone() or newRoot() of such a tree.
+    JsonTreeItem *insertItem(const QString &key, std::unique_ptr<JsonTreeItem> item) { return insertItem(QString(), key, std::move(item)); }
+    JsonTreeItem *insertItem(const QString &objPath, const QString &key, std::unique_ptr<JsonTreeItem> item);
+    JsonTreeItem *insertItem(const JsonPath &path, std::unique_ptr<JsonTreeItem> item);
+
     // Access functions
     const QString &key() const { return m_key; }
-    void setKey(const QString &key) { m_key = key; }
+    void setKey(const QString &key);
 
     DataType type() const { return m_type; }
 
+    // The generation is incremented each time nodes are deleted or retyped or keys are renamed in the
+    // subtree of this node, which invalidates pointers into the tree
+    uint generation() const { return m_generation; }
+
     bool isNull() const { return m_type == None; }
 
+    // Whether the child nodes have been created, which is false for objects and arrays, which have
+    // been loaded lazily and not been accessed yet
+    bool isMaterialized() const { return !(m_flags & LazyNode); }
+
     template<DataType _T>
     void setType()
     { if (m_type != _T) allocData<_T>(); }
 
     // Load and / or manipulate QVariant variable
-    QVariant &value() { return forceAsType<Value>(); }
-    QVariant &value(const QString &key) { return itemAt(key)->forceAsType<Value>(); }
-    QVariant &value(const QString &objPath, const QString &key) { return itemAt(objPath, key)->forceAsType<Value>(); }
+    QVariant &value() { return exposeAsType<Value>(); }
+    QVariant &value(const QString &key) { return itemAt(key)->exposeAsType<Value>(); }
+    QVariant &value(const QString &objPath, const QString &key) { return itemAt(objPath, key)->exposeAsType<Value>(); }
+    QVariant &value(const JsonPath &path) { return itemAt(path)->exposeAsType<Value>(); }
+
+    // Assign a value without returning a reference to it, so saving and snapshot() can keep skipping
+    // the node, while it is not changed again (see isDirty())
+    void setValue(const QVariant &value) { forceAsType<Value>() = value; }
+    void setValue(const QString &key, const QVariant &value) { itemAt(key)->setValue(value); }
+    void setValue(const QString &objPath, const QString &key, const QVariant &value) { itemAt(objPath, key)->setValue(value); }
+    void setValue(const JsonPath &path, const QVariant &value) { itemAt(path)->setValue(value); }
 
     // Load and / or manipulate Array/Object with child nodes
-    QVector<JsonTreeItem *> &array() { return forceAsType<Array>(); }
-    QVector<JsonTreeItem *> &array(const QString &key) { return itemAt(key)->forceAsType<Array>(); }
-    QVector<JsonTreeItem *> &array(const QString &objPath, const QString &key) { return itemAt(objPath, key)->forceAsType<Array>(); }
+    QVector<JsonTreeItem *> &array() { return exposeAsType<Array>(); }
+    QVector<JsonTreeItem *> &array(const QString &key) { return itemAt(key)->exposeAsType<Array>(); }
+    QVector<JsonTreeItem *> &array(const QString &objPath, const QString &key) { return itemAt(objPath, key)->exposeAsType<Array>(); }
+    QVector<JsonTreeItem *> &array(const JsonPath &path) { return itemAt(path)->exposeAsType<Array>(); }
 
-    QVector<JsonTreeItem *> &object() { return forceAsType<Object>(); }
-    QVector<JsonTreeItem *> &object(const QString &key) { return itemAt(key)->forceAsType<Object>(); }
-    QVector<JsonTreeItem *> &object(const QString &objPath, const QString &key) { return itemAt(objPath, key)->forceAsType<Object>(); }
+    QVector<JsonTreeItem *> &object() { return exposeAsType<Object>(); }
+    QVector<JsonTreeItem *> &object(const QString &key) { return itemAt(key)->exposeAsType<Object>(); }
+    QVector<JsonTreeItem *> &object(const QString &objPath, const QString &key) { return itemAt(objPath, key)->exposeAsType<Object>(); }
+    QVector<JsonTreeItem *> &object(const JsonPath &path) { return itemAt(path)->exposeAsType<Object>(); }
 
-    // The recursive function objectAt walks the nodes in the tree to find / or create an object with the
+    // The function objectAt walks the nodes in the tree to find / or create an object with the
     // given path, while "/" is interpreted as a separator.
     // If an object does not exist with the specified path, one is created. That applies even if
     // a key of another type exists at the specified path (except if you call the const function).
@@ -104,73 +380,378 @@ public:
     JsonTreeItem *objectAt(const QString &objPath);
     const JsonTreeItem *objectAt(const QString &objPath) const;
 
-    // The recursive function itemAt walks the nodes and returns whatever tree node is at the specified path.
+    // The function itemAt walks the nodes and returns whatever tree node is at the specified path.
     // If an object path is specified, which does not exist, it is created.
     JsonTreeItem *itemAt(const QString &key) { return itemAt(QString(), key); }
     JsonTreeItem *itemAt(const QString &objPath, const QString &key);
+    JsonTreeItem *itemAt(const JsonPath &path);
+
+    // The const lookups never create or retype nodes. They return a nullptr, an invalid QVariant or an
+    // empty view, if the path does not exist or the node has another type.
+    // Several threads may use them at the same time on a tree, which is not modified meanwhile and
+    // has no lazy nodes, like the snapshots of JsonTreePublisher.
+    const JsonTreeItem *itemAt(const QString &key) const { return itemAt(QString(), key); }
+    const JsonTreeItem *itemAt(const QString &objPath, const QString &key) const;
+    const JsonTreeItem *itemAt(const JsonPath &path) const;
+
+    QVariant value() const { return m_type == Value ? asType<Value>() : QVariant(); }
+    QVariant value(const QString &key) const { return value(QString(), key); }
+    QVariant value(const QString &objPath, const QString &key) const;
+    QVariant value(const JsonPath &path) const;
+
+    ConstChildren array() const { return m_type == Array ? ConstChildren(asType<Array>()) : ConstChildren(); }
+    ConstChildren object() const { return m_type == Object ? ConstChildren(asType<Object>()) : ConstChildren(); }
+
+#ifdef JSONCONFIG_STATS
+    // Size of this subtree and the counters of the whole tree (see JsonTreeStats)
+    // Lazy nodes are not materialized, their source text is counted apart. Data of derived classes,
+    // which is kept apart from the tree, is not included.
+    JsonTreeStats stats() const;
+
+    // Reset the counters of the tree
+    // The root gets the state of the tree with the first event, which is not recorded by a const
+    // lookup, if it has none yet. Loading and clone() give it a state right away.
+    void resetStats();
+#endif
+
+    // Create a deep copy of this node and its subtree as a new root with the same type of nodes
+    // Lazy nodes are materialized for this, the copy has none. It uses an arena, if this tree does.
+    JsonTreeItem *clone() const;
 
 protected:
-    virtual JsonTreeItem *newItem() const { return new JsonTreeItem; }
+    virtual JsonTreeItem *newItem() const { return createItem<JsonTreeItem>(); }
+
+    // Create a node for this tree, derived classes should use this in their implementation of newItem()
+    template<typename _Item>
+    _Item *createItem() const
+    {
+        if (!m_tree)
+            return new _Item;
+
+        JsonTreeArena *arena = m_tree->arena;
+        _Item *item = arena ? new (arena->allocate(sizeof(_Item), alignof(_Item))) _Item : new _Item;
+        JsonTreeItem *node = item;
+        node->m_tree = m_tree;
+        if (arena)
+            node->m_flags |= ArenaNode;
+        return item;
+    }
 
-    virtual void finalizeForExport() {}
+    // Pass the elements of the data of a derived class, which is kept apart from the tree, to the
+    // sink in place of the child nodes for saving and snapshots. Objects and arrays pass their
+    // elements, a Value node passes a single element with a null key, which replaces its value.
+    // Returns whether the node holds such data.
+    virtual bool exportExtended(JsonTreeItemData::ElementSink &sink) const { Q_UNUSED(sink) return false; }
+
+    // Pass the values of the child nodes of this object or array to the sink and remove them, e.g.
+    // to move them into a container of a derived class. Lazy nodes are parsed directly into the
+    // sink without creating child nodes. Nested objects and arrays are passed as invalid values.
+    void takeElements(JsonTreeItemData::ElementSink &sink);
+
+    // Release the data of a derived class, which is kept apart from the tree, when the node is
+    // cleared or changes its type and before restore()
+    virtual void clearExtended() {}
+
+    // Whether the node holds data of a derived class, which is kept apart from the tree
+    virtual bool hasExtended() const { return false; }
+
+    // Update the data of a derived class in place from the snapshot in update(), the snapshot has the
+    // type of the node. Returns whether the data has changed.
+    virtual bool updateExtended(const JsonSnapshot &snapshot) { Q_UNUSED(snapshot) return false; }
+
+    // Create a root node of the derived class for clone()
+    virtual JsonTreeItem *newRoot() const { return new JsonTreeItem; }
+
+    // Copy the data of a derived class in clone(), the source is a node of the same class
+    virtual void copyExtended(const JsonTreeItem *source) { Q_UNUSED(source) }
 
     template<DataType _T>
     ValueType<_T> &forceAsType()
     {
         if (m_type != _T)
             allocData<_T>();
+        markDirty();
         return asType<_T>();
     }
 
+    // Like forceAsType() for returning the reference from a public accessor (see markExposed())
+    template<DataType _T>
+    ValueType<_T> &exposeAsType()
+    {
+        ValueType<_T> &data = forceAsType<_T>();
+        markExposed();
+        return data;
+    }
+
+    // Mark the node and its ancestors as changed since the last save and the last snapshot
+    // As the ancestors of a dirty node are dirty as well, the propagation stops at the first one.
+    void markDirty()
+    {
+        for (JsonTreeItem *item = this; item && (item->m_flags & ChangedFlags) != ChangedFlags; item = item->m_parent)
+            item->m_flags |= ChangedFlags;
+    }
+
+    // Mark the node as dirty and exposed, before a reference to its data is returned, through which
+    // it may be changed at any time. Saving and snapshot() never reuse the output of an exposed node
+    // and walk the paths to them, until the data is released.
+    void markExposed()
+    {
+        markDirty();
+        m_flags |= ExposedNode;
+        for (JsonTreeItem *item = m_parent; item && !(item->m_flags & ExposedChildren); item = item->m_parent)
+            item->m_flags |= ExposedChildren;
+    }
+
 private:
+    friend class JsonBinaryReader;
+    friend class JsonBinaryWriter;
+    friend class JsonParallelLoader;
+    friend class JsonParser;
+    friend class JsonPatch;
+    friend class JsonPhaseTimer;
+    friend class JsonWriter;
+
+    enum Flag : quint8 {
+        // The node itself is allocated from the arena of the tree
+        ArenaNode = 0x1,
+        // The node is the root, which owns m_tree
+        OwnsTree = 0x2,
+        // The node is an object or an array, whose content is still in the source document
+        LazyNode = 0x4,
+        // The node has changed since the last save at the root
+        DirtyNode = 0x8,
+        // The node has changed since its last snapshot
+        StaleSnapshot = 0x10,
+        ChangedFlags = DirtyNode | StaleSnapshot,
+        // A reference to the data of the node has been returned
+        ExposedNode = 0x20,
+        // The subtree of the node contains exposed nodes, the writer and snapshot() update this flag
+        // for the nodes, which they walk
+        ExposedChildren = 0x40,
+        ExposedFlags = ExposedNode | ExposedChildren
+    };
+
+    // Storage of the node data, the active member is selected by m_type
+    // Values and child vectors are held inline, so reading a value takes a single pointer hop from
+    // the parent. With Qt 5 on a 64 bit platform a node takes 80 bytes (vtable, key, type / flags /
+    // key id / generation, 16 bytes of data, parent, index, tree, the fragment position and the snapshot),
+    // while the layout with a void pointer took 64 bytes plus a separate heap block of 16 bytes for a
+    // QVariant or 8 bytes for a QVector.
+    union Data
+    {
+        Data() {}
+        ~Data() {}
+
+        QVariant value;
+        QVector<JsonTreeItem *> children;
+        JsonTreeItemData::LazyRange range;
+    };
+
     QString m_key;
     DataType m_type;
-    void *m_data;
+    quint8 m_flags;
+    // Id of the key in the pool of the tree, 0 if it is not interned
+    quint16 m_keyId;
+    uint m_generation;
+    Data m_data;
+    JsonTreeItem *m_parent;
+    JsonTreeItemData::ChildIndex *m_index;
+    // State of the tree, which is inherited by new child nodes
+    JsonTreeItemData::Tree *m_tree;
+    // Position of the node in the last output relative to its parent, the size is 0 without output
+    quint32 m_fragmentOffset;
+    quint32 m_fragmentSize;
+    // Last snapshot of the node, which is reused as long as the node is not stale
+    JsonSnapshot m_snapshot;
+
+    // Serialize the tree, at the root the fragments of clean nodes are reused from the last output
+    bool serialize(QByteArray &output, JsonFormat format);
+
+    // Replace the tree with the document in the data, which has to stay valid while parsing
+    // With lazy loading, the data has to be kept in the state of the tree by the caller.
+    bool loadFromData(const char *data, qint64 size, JsonParseError *error, LoadMode mode = Eager);
+
+    // Replace the tree with the binary snapshot in the data, which has to stay valid while reading
+    bool loadFromBinaryData(const char *data, qint64 size, JsonParseError *error);
+
+    // Create the state of the tree at the root, if it does not exist yet
+    JsonTreeItemData::Tree *ensureTree();
+
+    // Release the source document and the nodes in the arena of the tree
+    void releaseTree();
+
+    // Release and delete the state of the tree, which this root owns
+    void deleteTree();
+
+    // Turn the node into a lazy object or array, whose content is given by the range
+    void setLazy(DataType type, const char *begin, const char *end);
+
+    // Parse the content of a lazy node, its objects and arrays become lazy nodes themselves
+    void materialize();
+
+    // Whether the subtree contains lazy nodes, and materialize all of them
+    bool hasLazyNodes() const;
+    void materializeAll();
+
+    // Turn a detached node into a root with a state of its own or prepare a root for insertItem()
+    // with the state of this tree. Both return the node or its copy, if it has been allocated from
+    // an arena.
+    static JsonTreeItem *detachSubtree(JsonTreeItem *item);
+    JsonTreeItem *adoptSubtree(JsonTreeItem *item);
+
+    // Insert a tree as child node with the key, which replaces a node with the same key
+    JsonTreeItem *insertTree(const QString &key, std::unique_ptr<JsonTreeItem> item);
+
+    // Turn the child nodes into those of the snapshot node, matching child nodes are reused
+    void restoreChildren(const JsonSnapshotData *data);
+
+    // Snapshot, which reuses the snapshots kept in the subtree, but does not keep the new ones, so
+    // that it can be taken from a const tree
+    JsonSnapshot temporarySnapshot() const;
+
+    // Create the snapshot node of this node, whose child nodes are turned into snapshots by the
+    // function childSnapshot
+    template<typename _ChildSnapshot>
+    JsonSnapshotData *createSnapshotData(_ChildSnapshot childSnapshot) const;
+
+    // Whether two snapshots have the same content with the same types of values, which is decided
+    // without hashing them, as unchanged subtrees are shared
+    static bool sameContent(const JsonSnapshot &snapshot, const JsonSnapshot &other);
+
+    // Functions for update(), the previous version is a nullptr, if it is unknown or does not correspond
+    // to this node. The path holds the segments of this node relative to the updated node.
+    bool updateNode(JsonTreeItem *previous, JsonTreeItem *next, QStringList &path, QVector<JsonPath> *changedPaths);
+    bool updateObject(JsonTreeItem *previous, JsonTreeItem *next, QStringList &path, QVector<JsonPath> *changedPaths);
+    bool updateArray(JsonTreeItem *previous, JsonTreeItem *next, QStringList &path, QVector<JsonPath> *changedPaths);
+
+    // Copy the content of the source node and its subtree into this node, which is empty
+    void copyFrom(const JsonTreeItem *source);
+
+    // Destroy a child node, which has been created with createItem()
+    static void destroyItem(JsonTreeItem *item);
+
+    // Walk the object path, which is given by the first depth segments
+    JsonTreeItem *objectAt(const QStringList &segments, int depth);
+    const JsonTreeItem *objectAt(const QStringList &segments, int depth) const;
+
+    // Increment the generation of this node and all of its ancestors
+    void bumpGeneration();
+
+    // Make this node the parent of a child node, which has been added to the vector directly
+    // The fragment of a node, which has been moved there from another parent, is dropped, as its
+    // position is relative to the previous parent.
+    void adoptChild(JsonTreeItem *child)
+    {
+        if (child->m_parent != this) {
+            child->m_parent = this;
+            child->m_fragmentSize = 0;
+        }
+    }
+
+    // Delete the data of the current node without notifying its ancestors
+    void releaseData();
+
+    // Set the key, which is interned, if the tree has a key pool
+    void assignKey(const QString &key);
+
+    // Id of the key in the pool of the tree without interning it, 0 if it is not in there
+    quint16 keyId(const QString &key) const;
+
+    // Intern the keys of the materialized nodes in the subtree, or release them without a pool
+    // The nodes take over the state of this tree.
+    void internKeys(JsonKeyPool *pool);
 
     // Find element with a specified key
+    // The non-const function builds or refreshes the hash index of wide objects, the const function
+    // uses the index only if it is in sync and scans the child nodes otherwise.
+    // Modifying the vector returned by object() is detected through its size. Keys, which are missing
+    // in the index of such an object, are searched for in the child nodes, in case they have been
+    // replaced in place.
     JsonTreeItem *find(const QString &key);
     const JsonTreeItem *find(const QString &key) const;
 
-    // Functions for importing from JSON
-    void import(const QJsonObject &obj);
-    void import(const QJsonArray &arr);
-    void import(const QJsonValue &val);
+    // Position of the child node with the specified key, -1 if there is none
+    int indexOf(const QString &key) const;
+
+    // Record lookups and the nodes created by them in the counters of the tree
+    // Without JSONCONFIG_STATS these do nothing and are removed by the compiler.
+#ifdef JSONCONFIG_STATS
+    void countLookup(bool indexed, int scanned) const;
+    void countCreated(bool retyped);
+
+    // Counters of the tree, a nullptr, if the node has no state
+    // The const lookups only record events in trees, which have a state, so that several threads
+    // can use them at the same time. Loading and clone() give the root a state.
+    JsonTreeItemData::StatsCounters *statsCounters() const { return m_tree ? &m_tree->stats : nullptr; }
+
+    // Counters of the tree, which give the root a state first, if it has none
+    JsonTreeItemData::StatsCounters &ensureStatsCounters();
+
+    // Set the state of the tree in the materialized nodes of the subtree
+    void adoptTree(JsonTreeItemData::Tree *tree);
+
+    // Add this node to the statistics, collectStats() adds its subtree as well
+    void countNode(JsonTreeStats &stats, int depth) const;
+    void collectStats(JsonTreeStats &stats, int depth) const;
+#else
+    void countLookup(bool indexed, int scanned) const { Q_UNUSED(indexed) Q_UNUSED(scanned) }
+    void countCreated(bool retyped) { Q_UNUSED(retyped) }
+#endif
 
-    // Functions for appending and merging with JSON-format
-    void append(const QJsonObject &obj);
-    void append(const QJsonArray &arr);
-    void append(const QJsonValue &val);
+    // Functions for maintaining the hash index of an object
+    void syncIndex();
+    void dropIndex();
 
-    // Functions for exporting to JSON-format
-    QJsonObject exportObject();
-    QJsonArray exportArray();
-    QJsonValue exportValue();
+    // Append a child node to the current Object or Array and keep the index up to date
+    void insertChild(JsonTreeItem *item);
+
+    // Insert a child node into the current Object or Array at the specified position
+    void insertChildAt(int pos, JsonTreeItem *item);
+
+    // Remove the child node at the specified position from the current Object or Array and delete it
+    void removeChildAt(int pos);
+
+    // Remove the child node at the specified position from the current Object or Array and return it
+    JsonTreeItem *takeChildAt(int pos);
 
     // Function for control of values in the current node
     // The template parameter _T must be the current DataType! Otherwise the program might crash
+    // Lazy objects and arrays are materialized on the first access, also through the const function.
     template<DataType _T>
     ValueType<_T> &asType()
-    { return *static_cast<ValueType<_T> *>(m_data); }
+    {
+        if (_T != Value && (m_flags & LazyNode))
+            materialize();
+        return *reinterpret_cast<ValueType<_T> *>(&m_data);
+    }
 
     template<DataType _T>
     const ValueType<_T> &asType() const
-    { return *static_cast<const ValueType<_T> *>(m_data); }
+    {
+        if (_T != Value && (m_flags & LazyNode))
+            const_cast<JsonTreeItem *>(this)->materialize();
+        return *reinterpret_cast<const ValueType<_T> *>(&m_data);
+    }
 
-    // Allocate datafield with specified type
+    // Construct datafield with specified type
     template<DataType _T>
     void allocData()
     {
         if (m_type != None)
             clear();
+        new (&m_data) ValueType<_T>;
         m_type = _T;
-        m_data = new ValueType<_T>;
+        markDirty();
     }
 
-    // Delete data of specified type
+    // Destruct data of specified type
     // The template parameter _T must be the current DataType! Otherwise the program might crash
     template<DataType _T>
     void freeData()
-    { delete static_cast<ValueType<_T> *>(m_data); }
+    {
+        using DataValueType = ValueType<_T>;
+        asType<_T>().~DataValueType();
+    }
 
     // Find item with a specific key and type and create the item, if it is not available with the
     // desired type
@@ -180,11 +761,14 @@ private:
         JsonTreeItem *ct = find(key);
         if (!ct) {
             ct = newItem();
-            ct->m_key = key;
+            ct->assignKey(key);
             ct->allocData<_T>();
-            asType<Object>().push_back(ct);
-        } else if (ct->m_type != _T)
+            insertChild(ct);
+            countCreated(false);
+        } else if (ct->m_type != _T) {
             ct->allocData<_T>();
+            countCreated(true);
+        }
         return ct;
     }
 };
@@ -0,0 +1,58 @@
+#include <QMutexLocker>
+
+#include "jsontreepublisher.h"
+
+JsonTreePublisher::JsonTreePublisher()
+    : m_version(0)
+{
+    JsonTreeItem *empty = new JsonTreeItem;
+    empty->reset();
+    m_snapshot = QSharedPointer<const JsonTreeItem>(empty);
+}
+
+void JsonTreePublisher::publish(const JsonTreeItem &tree)
+{
+    publish(tree.clone());
+}
+
+void JsonTreePublisher::publish(JsonTreeItem *snapshot)
+{
+    // The previous snapshot ends up in the local pointer, so that it is released outside of the lock,
+    // if no reader holds it anymore
+    QSharedPointer<const JsonTreeItem> published(snapshot);
+
+    QMutexLocker locker(&m_mutex);
+    m_snapshot.swap(published);
+    m_version.storeRelease(m_version.loadRelaxed() + 1);
+}
+
+QSharedPointer<const JsonTreeItem> JsonTreePublisher::snapshot() const
+{
+    quint64 version;
+    return snapshot(version);
+}
+
+QSharedPointer<const JsonTreeItem> JsonTreePublisher::snapshot(quint64 &version) const
+{
+    QMutexLocker locker(&m_mutex);
+    version = m_version.loadRelaxed();
+    return m_snapshot;
+}
+
+JsonTreeReader::JsonTreeReader(const JsonTreePublisher *publisher)
+    : m_publisher(publisher),
+      m_version(0)
+{
+}
+
+const JsonTreeItem *JsonTreeReader::snapshot()
+{
+    if (!m_snapshot || m_publisher->version() != m_version)
+        m_snapshot = m_publisher->snapshot(m_version);
+    return m_snapshot.data();
+}
+
+void JsonTreeReader::release()
+{
+    m_snapshot.reset();
+}
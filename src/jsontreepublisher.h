@@ -0,0 +1,66 @@
+#ifndef JSONTREEPUBLISHER_H
+#define JSONTREEPUBLISHER_H
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include "jsontreeitem.h"
+
+// Publishes immutable snapshots of a tree for concurrent readers (read-copy-update)
+// A single writer modifies its own tree and publishes a copy of it. Readers look up values in the
+// current snapshot with the const API of JsonTreeItem, without any lock. A snapshot stays valid as
+// long as a reader holds it, the old snapshot is released by the last reader, which moves on.
+class JsonTreePublisher
+{
+public:
+    JsonTreePublisher();
+
+    JsonTreePublisher(const JsonTreePublisher &) = delete;
+    JsonTreePublisher &operator=(const JsonTreePublisher &) = delete;
+
+    // Publish a copy of the tree as the new snapshot, the tree may be modified again afterwards
+    // The copy is created on the calling thread, readers are not blocked meanwhile.
+    void publish(const JsonTreeItem &tree);
+
+    // Publish a root, which must not be modified anymore and has no lazy nodes, and take ownership
+    void publish(JsonTreeItem *snapshot);
+
+    // The current snapshot, it is an empty object before the first publish()
+    QSharedPointer<const JsonTreeItem> snapshot() const;
+
+    // The version is incremented by each publish()
+    quint64 version() const { return m_version.loadAcquire(); }
+
+private:
+    friend class JsonTreeReader;
+
+    // The mutex only guards the exchange of the shared pointer, not the lookups in the snapshot
+    mutable QMutex m_mutex;
+    QSharedPointer<const JsonTreeItem> m_snapshot;
+    QAtomicInteger<quint64> m_version;
+
+    QSharedPointer<const JsonTreeItem> snapshot(quint64 &version) const;
+};
+
+// Access to the snapshots of a publisher for a single reader thread
+// The snapshot is only fetched again after a new one has been published. Otherwise snapshot() just
+// compares the version, so readers do not contend with each other for the lookups.
+class JsonTreeReader
+{
+public:
+    explicit JsonTreeReader(const JsonTreePublisher *publisher);
+
+    // The current snapshot, the pointer stays valid until the next call
+    const JsonTreeItem *snapshot();
+
+    // Release the snapshot, so that it can be freed before the next call of snapshot()
+    void release();
+
+private:
+    const JsonTreePublisher *m_publisher;
+    QSharedPointer<const JsonTreeItem> m_snapshot;
+    quint64 m_version;
+};
+
+#endif // JSONTREEPUBLISHER_H
@@ -0,0 +1,71 @@
+#include "jsontreeitem.h"
+#include "jsontreestats.h"
+
+namespace {
+
+const char *const PhaseNames[JsonTreeStats::PhaseCount] = {"parse", "import", "export", "write"};
+
+}
+
+QByteArray JsonTreeStats::toJson() const
+{
+    JsonTreeItem report;
+
+    report.value("nodes", "none") = noneNodes;
+    report.value("nodes", "value") = valueNodes;
+    report.value("nodes", "object") = objectNodes;
+    report.value("nodes", "array") = arrayNodes;
+    report.value("nodes", "lazy") = lazyNodes;
+    report.value("nodes", "total") = nodes();
+
+    report.value("memory", "bytes") = bytes;
+    report.value("memory", "lazySourceBytes") = lazySourceBytes;
+
+    report.value("shape", "maxDepth") = maxDepth;
+    report.value("shape", "maxFanOut") = maxFanOut;
+
+    QVector<JsonTreeItem *> &subtrees = report.array("largestSubtrees");
+    for (const Subtree &subtree : largestSubtrees) {
+        JsonTreeItem *item = new JsonTreeItem;
+        item->value("key") = subtree.key;
+        item->value("nodes") = subtree.nodes;
+        item->value("bytes") = subtree.bytes;
+        subtrees.push_back(item);
+    }
+
+    report.value("lookups", "count") = lookups;
+    report.value("lookups", "indexed") = indexedLookups;
+    report.value("lookups", "scannedNodes") = scannedNodes;
+    report.value("lookups", "averageScanLength") = averageScanLength();
+    report.value("lookups", "createdNodes") = createdNodes;
+    report.value("lookups", "retypedNodes") = retypedNodes;
+
+    for (int phase = 0; phase < PhaseCount; ++phase) {
+        const QString path = QString("phases/") + PhaseNames[phase];
+        report.value(path, "count") = phases[phase].count;
+        report.value(path, "msecs") = phases[phase].nsecs / 1e6;
+        report.value(path, "bytes") = phases[phase].bytes;
+    }
+
+    return report.saveToJson();
+}
+
+#ifdef JSONCONFIG_STATS
+
+JsonPhaseTimer::JsonPhaseTimer(JsonTreeItem *item, JsonTreeStats::Phase phase, qint64 bytes)
+    : m_item(item),
+      m_phase(phase),
+      m_bytes(bytes)
+{
+    m_timer.start();
+}
+
+JsonPhaseTimer::~JsonPhaseTimer()
+{
+    JsonTreeItemData::StatsCounters::Phase &phase = m_item->ensureStatsCounters().phases[m_phase];
+    phase.count.fetchAndAddRelaxed(1);
+    phase.nsecs.fetchAndAddRelaxed(m_timer.nsecsElapsed());
+    phase.bytes.fetchAndAddRelaxed(m_bytes);
+}
+
+#endif
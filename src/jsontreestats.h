@@ -0,0 +1,145 @@
+#ifndef JSONTREESTATS_H
+#define JSONTREESTATS_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#ifdef JSONCONFIG_STATS
+#include <QAtomicInteger>
+#include <QElapsedTimer>
+#endif
+
+class JsonTreeItem;
+
+// Report of the size of a subtree and of the counters of its tree (see JsonTreeItem::stats())
+// The counters are only recorded in builds with JSONCONFIG_STATS defined, e.g. with
+// "qmake CONFIG+=stats". Without it, JsonTreeItem has no statistics functions and no overhead.
+struct JsonTreeStats
+{
+    // Phases of loading and saving
+    enum Phase {
+        // Parsing JSON text into nodes, including appendJson() and the materialization of lazy nodes
+        Parse,
+        // Reading binary snapshots into nodes
+        Import,
+        // Serializing nodes into JSON text or binary snapshots in memory
+        Export,
+        // Writing the serialized document to a file or a device
+        Write,
+        PhaseCount
+    };
+
+    struct PhaseTime
+    {
+        qint64 count = 0;
+        qint64 nsecs = 0;
+        qint64 bytes = 0;
+    };
+
+    struct Subtree
+    {
+        QString key;
+        qint64 nodes = 0;
+        qint64 bytes = 0;
+    };
+
+    // Number of nodes by type, lazy objects and arrays are counted apart from the materialized ones
+    qint64 noneNodes = 0;
+    qint64 valueNodes = 0;
+    qint64 objectNodes = 0;
+    qint64 arrayNodes = 0;
+    qint64 lazyNodes = 0;
+
+    // Approximate heap memory of the nodes, their keys, values, child vectors and indexes
+    // Interned keys and the source text of lazy nodes are shared, so they are not included.
+    qint64 bytes = 0;
+    qint64 lazySourceBytes = 0;
+
+    // Depth of the deepest node below the subtree root (0 for a node without children) and the
+    // largest number of child nodes of a single node
+    int maxDepth = 0;
+    int maxFanOut = 0;
+
+    // Largest child subtrees of the subtree root by their bytes, at most MaxSubtrees
+    static constexpr int MaxSubtrees = 10;
+    QVector<Subtree> largestSubtrees;
+
+    // Lookups of keys in objects since the counters have been reset, the scanned nodes are those
+    // compared by lookups without a hash index
+    qint64 lookups = 0;
+    qint64 indexedLookups = 0;
+    qint64 scannedNodes = 0;
+
+    // Nodes created or retyped by itemAt(), objectAt() and the accessors based on them, because the
+    // path did not exist with the requested type
+    qint64 createdNodes = 0;
+    qint64 retypedNodes = 0;
+
+    PhaseTime phases[PhaseCount];
+
+    qint64 nodes() const { return noneNodes + valueNodes + objectNodes + arrayNodes + lazyNodes; }
+
+    // Average number of nodes, which a lookup has compared with the key
+    double averageScanLength() const { return lookups ? double(scannedNodes) / lookups : 0.; }
+
+    // Indented JSON document with all of the above
+    QByteArray toJson() const;
+};
+
+#ifdef JSONCONFIG_STATS
+
+namespace JsonTreeItemData {
+
+// Counters of a tree, which is kept in its state
+// The counters are atomic, as the const lookups may run on several threads at the same time.
+struct StatsCounters
+{
+    QAtomicInteger<qint64> lookups;
+    QAtomicInteger<qint64> indexedLookups;
+    QAtomicInteger<qint64> scannedNodes;
+    QAtomicInteger<qint64> createdNodes;
+    QAtomicInteger<qint64> retypedNodes;
+
+    struct Phase
+    {
+        QAtomicInteger<qint64> count;
+        QAtomicInteger<qint64> nsecs;
+        QAtomicInteger<qint64> bytes;
+    } phases[JsonTreeStats::PhaseCount];
+};
+
+}
+
+// Measure the time of a phase from its construction to its destruction and add it to the counters
+// of the tree of the node
+class JsonPhaseTimer
+{
+public:
+    JsonPhaseTimer(JsonTreeItem *item, JsonTreeStats::Phase phase, qint64 bytes = 0);
+    ~JsonPhaseTimer();
+
+    // Set the bytes, which are only known at the end of the phase
+    void setBytes(qint64 bytes) { m_bytes = bytes; }
+
+private:
+    JsonTreeItem *m_item;
+    JsonTreeStats::Phase m_phase;
+    qint64 m_bytes;
+    QElapsedTimer m_timer;
+};
+
+#else
+
+// Without statistics the timer is empty and removed by the compiler
+class JsonPhaseTimer
+{
+public:
+    JsonPhaseTimer(JsonTreeItem *, JsonTreeStats::Phase, qint64 = 0) {}
+
+    void setBytes(qint64) {}
+};
+
+#endif
+
+#endif // JSONTREESTATS_H
@@ -0,0 +1,619 @@
+#include <QIODevice>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QLocale>
+#include <QStringList>
+#include <QVariant>
+
+#include <cmath>
+
+#if __has_include(<charconv>)
+#include <charconv>
+#endif
+
+#include "jsonwriter.h"
+
+JsonWriter::JsonWriter(QIODevice *device, JsonFormat format)
+    : m_device(device),
+      m_out(&m_chunk),
+      m_format(format),
+      m_afterKey(false),
+      m_error(false),
+      m_previous(nullptr),
+      m_track(false)
+{
+    m_chunk.reserve(ChunkSize + 1024);
+}
+
+JsonWriter::JsonWriter(QByteArray *buffer, JsonFormat format)
+    : m_device(nullptr),
+      m_out(buffer),
+      m_format(format),
+      m_afterKey(false),
+      m_error(false),
+      m_previous(nullptr),
+      m_track(false)
+{
+}
+
+JsonWriter::~JsonWriter()
+{
+    flush();
+}
+
+bool JsonWriter::write(JsonTreeItem *root)
+{
+    if (root->m_type != JsonTreeItem::Object && root->m_type != JsonTreeItem::Array)
+        return false;
+
+    writeNode(root);
+    if (m_format == JsonTreeItem::Indented)
+        append('\n');
+
+    return flush() && !m_error;
+}
+
+bool JsonWriter::writeIncremental(JsonTreeItem *root, const QByteArray *previous)
+{
+    // Fragment positions refer to the byte array, so they cannot be recorded with a device
+    if (m_device)
+        return write(root);
+
+    if (root->m_type != JsonTreeItem::Object && root->m_type != JsonTreeItem::Array)
+        return false;
+
+    if (previous && !(root->m_flags & (JsonTreeItem::DirtyNode | JsonTreeItem::ExposedFlags))) {
+        m_out->append(*previous);
+        return true;
+    }
+
+    m_previous = previous;
+    m_track = true;
+
+    writeNode(root, previous ? 0 : -1);
+    if (m_format == JsonTreeItem::Indented)
+        append('\n');
+
+    m_previous = nullptr;
+    m_track = false;
+
+    root->m_flags &= ~JsonTreeItem::DirtyNode;
+    return !m_error;
+}
+
+void JsonWriter::beginObject()
+{
+    beginContainer('{');
+}
+
+void JsonWriter::endObject()
+{
+    endContainer('}');
+}
+
+void JsonWriter::beginArray()
+{
+    beginContainer('[');
+}
+
+void JsonWriter::endArray()
+{
+    endContainer(']');
+}
+
+void JsonWriter::writeKey(const QString &key)
+{
+    prepareElement();
+    writeString(key);
+    writeKeySeparator();
+}
+
+void JsonWriter::writeValue(const QVariant &value)
+{
+    // The QJson types are written like the variants they hold, as QJsonValue::fromVariant() did
+    switch (value.userType()) {
+    case QMetaType::QJsonValue:
+        writeValue(value.toJsonValue().toVariant());
+        return;
+    case QMetaType::QJsonObject:
+        writeValue(value.toJsonObject().toVariantMap());
+        return;
+    case QMetaType::QJsonArray:
+        writeValue(value.toJsonArray().toVariantList());
+        return;
+    case QMetaType::QJsonDocument: {
+        const QJsonDocument document = value.toJsonDocument();
+        if (document.isArray())
+            writeValue(document.array().toVariantList());
+        else
+            writeValue(document.object().toVariantMap());
+        return;
+    }
+    default:
+        break;
+    }
+
+    prepareValue();
+
+    switch (static_cast<int>(value.type())) {
+    case QVariant::Invalid:
+        append("null", 4);
+        break;
+    case QVariant::Bool:
+        if (value.toBool())
+            append("true", 4);
+        else
+            append("false", 5);
+        break;
+    case QVariant::Int:
+    case QVariant::LongLong:
+        writeInteger(value.toLongLong());
+        break;
+    case QVariant::UInt:
+    case QVariant::ULongLong: {
+        const QByteArray number = QByteArray::number(value.toULongLong());
+        append(number.constData(), number.size());
+        break;
+    }
+    case QVariant::Double:
+        writeDouble(value.toDouble());
+        break;
+    case QMetaType::Float:
+        writeFloat(value.toFloat());
+        break;
+    case QVariant::StringList:
+    case QVariant::List: {
+        const QVariantList list = value.toList();
+        m_afterKey = true;
+        beginArray();
+        for (const QVariant &element : list)
+            writeValue(element);
+        endArray();
+        break;
+    }
+    case QVariant::Map: {
+        const QVariantMap map = value.toMap();
+        m_afterKey = true;
+        beginObject();
+        for (auto it = map.constBegin(); it != map.constEnd(); ++it) {
+            writeKey(it.key());
+            writeValue(it.value());
+        }
+        endObject();
+        break;
+    }
+    case QVariant::Hash: {
+        const QVariantHash hash = value.toHash();
+        m_afterKey = true;
+        beginObject();
+        for (auto it = hash.constBegin(); it != hash.constEnd(); ++it) {
+            writeKey(it.key());
+            writeValue(it.value());
+        }
+        endObject();
+        break;
+    }
+    default:
+        // Strings and all other types, which can be converted to a string
+        if (value.canConvert<QString>()) {
+            writeString(value.toString());
+        } else {
+            // There is no JSON representation, so the document is incomplete
+            m_error = true;
+            append("null", 4);
+        }
+        break;
+    }
+}
+
+void JsonWriter::writeItem(JsonTreeItem *item)
+{
+    writeNode(item);
+}
+
+void JsonWriter::writeNode(JsonTreeItem *item, qint64 oldStart)
+{
+    const qint64 start = m_out->size();
+
+    // The flag is set again by writeChild() for the exposed child nodes, which are still there
+    item->m_flags &= ~JsonTreeItem::ExposedChildren;
+
+    // Subtrees, which have not been accessed since lazy loading, are written without parsing them
+    if (item->m_flags & JsonTreeItem::LazyNode) {
+        writeRange(item->m_data.range.begin, item->m_data.range.end);
+        return;
+    }
+
+    switch (item->m_type) {
+    case JsonTreeItem::Value:
+        if (!item->exportExtended(*this))
+            writeValue(item->asType<JsonTreeItem::Value>());
+        break;
+    case JsonTreeItem::Object:
+        beginObject();
+        // The data of derived classes is written in place of the child nodes
+        if (!item->exportExtended(*this)) {
+            for (JsonTreeItem *child : qAsConst(item->asType<JsonTreeItem::Object>())) {
+                // Keys without a type are not exported
+                if (child->m_type == JsonTreeItem::None) {
+                    child->m_flags &= ~JsonTreeItem::DirtyNode;
+                    continue;
+                }
+                writeKey(child->m_key);
+                writeChild(item, child, oldStart, start);
+            }
+        }
+        endObject();
+        break;
+    case JsonTreeItem::Array:
+        beginArray();
+        if (!item->exportExtended(*this)) {
+            for (JsonTreeItem *child : qAsConst(item->asType<JsonTreeItem::Array>())) {
+                if (child->m_type == JsonTreeItem::None) {
+                    child->m_flags &= ~JsonTreeItem::DirtyNode;
+                    continue;
+                }
+                writeChild(item, child, oldStart, start);
+            }
+        }
+        endArray();
+        break;
+    default:
+        break;
+    }
+}
+
+void JsonWriter::writeChild(JsonTreeItem *parent, JsonTreeItem *child, qint64 parentOldStart, qint64 parentStart)
+{
+    // Nodes, which have been added to the vectors directly, get their parent, so that later changes
+    // are propagated to it
+    parent->adoptChild(child);
+
+    // The separator and the indentation are written first, so that the fragment starts at the value
+    prepareValue();
+    const qint64 start = m_out->size();
+
+    const bool hasFragment = parentOldStart >= 0 && child->m_fragmentSize > 0;
+    const qint64 oldStart = hasFragment ? parentOldStart + child->m_fragmentOffset : -1;
+
+    // Exposed nodes may have been changed through a reference without being marked dirty
+    if (hasFragment && !(child->m_flags & (JsonTreeItem::DirtyNode | JsonTreeItem::ExposedFlags))) {
+        append(m_previous->constData() + oldStart, static_cast<int>(child->m_fragmentSize));
+    } else {
+        m_afterKey = true;
+        writeNode(child, oldStart);
+        if (child->m_flags & JsonTreeItem::ExposedFlags)
+            parent->m_flags |= JsonTreeItem::ExposedChildren;
+    }
+
+    if (m_track) {
+        child->m_fragmentOffset = static_cast<quint32>(start - parentStart);
+        child->m_fragmentSize = static_cast<quint32>(m_out->size() - start);
+        child->m_flags &= ~JsonTreeItem::DirtyNode;
+    }
+}
+
+void JsonWriter::writeRange(const char *pos, const char *end)
+{
+    while (pos != end) {
+        switch (*pos) {
+        case ' ':
+        case '\n':
+        case '\r':
+        case '\t':
+        case ',':
+        case ':':
+            // Separators and indentation are written by the functions for the elements
+            ++pos;
+            break;
+        case '{':
+            beginObject();
+            ++pos;
+            break;
+        case '}':
+            endObject();
+            ++pos;
+            break;
+        case '[':
+            beginArray();
+            ++pos;
+            break;
+        case ']':
+            endArray();
+            ++pos;
+            break;
+        case '"': {
+            const char *start = pos++;
+            while (pos != end && *pos != '"') {
+                if (*pos == '\\' && pos + 1 != end)
+                    ++pos;
+                ++pos;
+            }
+            if (pos != end)
+                ++pos;
+
+            // A string is a key, if it is followed by a colon
+            const char *next = pos;
+            while (next != end && (*next == ' ' || *next == '\n' || *next == '\r' || *next == '\t'))
+                ++next;
+
+            if (next != end && *next == ':') {
+                prepareElement();
+                append(start, static_cast<int>(pos - start));
+                writeKeySeparator();
+            } else {
+                prepareValue();
+                append(start, static_cast<int>(pos - start));
+            }
+            break;
+        }
+        default: {
+            // Numbers and literals
+            const char *start = pos;
+            while (pos != end && *pos != ',' && *pos != '}' && *pos != ']' && *pos != ' '
+                   && *pos != '\n' && *pos != '\r' && *pos != '\t')
+                ++pos;
+            prepareValue();
+            append(start, static_cast<int>(pos - start));
+            break;
+        }
+        }
+    }
+}
+
+bool JsonWriter::flush()
+{
+    if (!m_device || m_chunk.isEmpty())
+        return !m_error;
+
+    if (m_device->write(m_chunk) != m_chunk.size())
+        m_error = true;
+
+    // Keep the reserved capacity of the chunk
+    m_chunk.resize(0);
+    return !m_error;
+}
+
+void JsonWriter::beginContainer(char open)
+{
+    prepareValue();
+    append(open);
+    m_empty.push_back(true);
+}
+
+void JsonWriter::endContainer(char close)
+{
+    const bool empty = m_empty.takeLast();
+    if (!empty && m_format == JsonTreeItem::Indented)
+        writeIndentation(m_empty.size());
+    append(close);
+}
+
+void JsonWriter::prepareElement()
+{
+    if (m_empty.isEmpty())
+        return;
+
+    if (!m_empty.last())
+        append(',');
+    m_empty.last() = false;
+
+    if (m_format == JsonTreeItem::Indented)
+        writeIndentation(m_empty.size());
+}
+
+void JsonWriter::prepareValue()
+{
+    // The value of an object member follows its key directly
+    if (m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+    prepareElement();
+}
+
+void JsonWriter::writeIndentation(int depth)
+{
+    static const char spaces[] = "                                ";
+    const int spaceCount = sizeof(spaces) - 1;
+
+    append('\n');
+    for (int indent = 4 * depth; indent > 0; indent -= spaceCount)
+        append(spaces, qMin(indent, spaceCount));
+}
+
+void JsonWriter::writeKeySeparator()
+{
+    if (m_format == JsonTreeItem::Indented)
+        append(": ", 2);
+    else
+        append(':');
+    m_afterKey = true;
+}
+
+void JsonWriter::writeString(const QString &str)
+{
+    static const char hexDigits[] = "0123456789abcdef";
+
+    // Encode into a small local buffer, which is appended in blocks
+    char buffer[256];
+    int size = 0;
+
+    buffer[size++] = '"';
+
+    const ushort *c = str.utf16();
+    const ushort *end = c + str.size();
+    for (; c != end; ++c) {
+        if (size > static_cast<int>(sizeof(buffer)) - 8) {
+            append(buffer, size);
+            size = 0;
+        }
+
+        uint u = *c;
+        if (u >= 0x20 && u < 0x80 && u != '"' && u != '\\') {
+            buffer[size++] = static_cast<char>(u);
+            continue;
+        }
+
+        if (u < 0x80) {
+            buffer[size++] = '\\';
+            switch (u) {
+            case '"':  buffer[size++] = '"'; break;
+            case '\\': buffer[size++] = '\\'; break;
+            case '\b': buffer[size++] = 'b'; break;
+            case '\f': buffer[size++] = 'f'; break;
+            case '\n': buffer[size++] = 'n'; break;
+            case '\r': buffer[size++] = 'r'; break;
+            case '\t': buffer[size++] = 't'; break;
+            default:
+                buffer[size++] = 'u';
+                buffer[size++] = '0';
+                buffer[size++] = '0';
+                buffer[size++] = hexDigits[u >> 4];
+                buffer[size++] = hexDigits[u & 0xf];
+                break;
+            }
+            continue;
+        }
+
+        // Combine surrogate pairs, lone surrogates are replaced
+        if (u >= 0xd800 && u < 0xe000) {
+            if (u < 0xdc00 && c + 1 != end && c[1] >= 0xdc00 && c[1] < 0xe000) {
+                u = 0x10000 + ((u - 0xd800) << 10) + (c[1] - 0xdc00);
+                ++c;
+            } else {
+                u = 0xfffd;
+            }
+        }
+
+        if (u < 0x800) {
+            buffer[size++] = static_cast<char>(0xc0 | (u >> 6));
+            buffer[size++] = static_cast<char>(0x80 | (u & 0x3f));
+        } else if (u < 0x10000) {
+            buffer[size++] = static_cast<char>(0xe0 | (u >> 12));
+            buffer[size++] = static_cast<char>(0x80 | ((u >> 6) & 0x3f));
+            buffer[size++] = static_cast<char>(0x80 | (u & 0x3f));
+        } else {
+            buffer[size++] = static_cast<char>(0xf0 | (u >> 18));
+            buffer[size++] = static_cast<char>(0x80 | ((u >> 12) & 0x3f));
+            buffer[size++] = static_cast<char>(0x80 | ((u >> 6) & 0x3f));
+            buffer[size++] = static_cast<char>(0x80 | (u & 0x3f));
+        }
+    }
+
+    buffer[size++] = '"';
+    append(buffer, size);
+}
+
+void JsonWriter::writeDouble(double number)
+{
+    // JSON has no representation for infinity and NaN
+    if (!std::isfinite(number)) {
+        append("null", 4);
+        return;
+    }
+
+    // Integral values are written without exponent, as long as they are exact
+    if (number == std::floor(number) && std::fabs(number) < 9007199254740992.0) {
+        writeInteger(static_cast<qint64>(number));
+        return;
+    }
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // Shortest representation, which reads back exactly, without allocating and independent of the
+    // locale
+    char buffer[32];
+    const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    append(buffer, static_cast<int>(result.ptr - buffer));
+#else
+    const QByteArray text = QByteArray::number(number, 'g', QLocale::FloatingPointShortest);
+    append(text.constData(), text.size());
+#endif
+}
+
+void JsonWriter::writeFloat(float number)
+{
+    if (!std::isfinite(number)) {
+        append("null", 4);
+        return;
+    }
+
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    // The shortest representation of the float, e.g. 0.1 instead of the digits of the double
+    char buffer[32];
+    const std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), number);
+    append(buffer, static_cast<int>(result.ptr - buffer));
+#else
+    // Enough digits to read back the float exactly
+    const QByteArray text = QByteArray::number(static_cast<double>(number), 'g', 9);
+    append(text.constData(), text.size());
+#endif
+}
+
+void JsonWriter::writeInteger(qint64 number)
+{
+    // The digits are written from the back of a local buffer, which fits every 64 bit integer
+    char buffer[24];
+    char *end = buffer + sizeof(buffer);
+    char *pos = end;
+
+    quint64 magnitude = number < 0 ? 0 - static_cast<quint64>(number) : static_cast<quint64>(number);
+    do {
+        *--pos = static_cast<char>('0' + magnitude % 10);
+        magnitude /= 10;
+    } while (magnitude);
+
+    if (number < 0)
+        *--pos = '-';
+
+    append(pos, static_cast<int>(end - pos));
+}
+
+void JsonWriter::addValue(const QString &key, const QVariant &value)
+{
+    if (!key.isNull())
+        writeKey(key);
+    writeValue(value);
+}
+
+void JsonWriter::addString(const QString &key, const QString &str)
+{
+    if (!key.isNull())
+        writeKey(key);
+    prepareValue();
+    writeString(str);
+}
+
+void JsonWriter::addInteger(const QString &key, qint64 number)
+{
+    if (!key.isNull())
+        writeKey(key);
+    prepareValue();
+    writeInteger(number);
+}
+
+void JsonWriter::addDouble(const QString &key, double number)
+{
+    if (!key.isNull())
+        writeKey(key);
+    prepareValue();
+    writeDouble(number);
+}
+
+void JsonWriter::addFloat(const QString &key, float number)
+{
+    if (!key.isNull())
+        writeKey(key);
+    prepareValue();
+    writeFloat(number);
+}
+
+void JsonWriter::append(const char *data, int size)
+{
+    m_out->append(data, size);
+
+    if (m_device && m_chunk.size() >= ChunkSize)
+        flush();
+}
@@ -0,0 +1,104 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include "jsontreeitem.h"
+
+class QIODevice;
+
+// Serializer, which walks the tree once and streams UTF-8 into a device or a byte array
+// Apart from the recursion, only a chunk of ChunkSize bytes is buffered, when writing to a device.
+// The output can also be composed with the functions for single elements, which take care of the
+// separators and the indentation.
+class JsonWriter : private JsonTreeItemData::ElementSink
+{
+public:
+    using JsonFormat = JsonTreeItem::JsonFormat;
+
+    // Size of the chunks, which are written to the device at once
+    static constexpr int ChunkSize = 64 * 1024;
+
+    JsonWriter(QIODevice *device, JsonFormat format = JsonTreeItem::Indented);
+
+    // The output is appended to the buffer, so that its capacity can be reused
+    JsonWriter(QByteArray *buffer, JsonFormat format = JsonTreeItem::Indented);
+
+    ~JsonWriter() override;
+
+    // Write the tree as a document, the root has to be an Object or an Array
+    bool write(JsonTreeItem *root);
+
+    // Write the tree as a document into the byte array and record the fragment of each node
+    // The fragments of clean nodes are copied from the previous output, if it is not a nullptr. It
+    // has to be the output of the last call for this tree in the same format. All nodes are clean
+    // afterwards.
+    bool writeIncremental(JsonTreeItem *root, const QByteArray *previous);
+
+    // Functions for writing single elements
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+    void writeKey(const QString &key);
+    // Types, which can neither be converted to JSON nor to a string, are written as null and set the error
+    void writeValue(const QVariant &value);
+    void writeItem(JsonTreeItem *item);
+
+    // Write the buffered chunk to the device
+    bool flush();
+
+    bool hasError() const { return m_error; }
+
+private:
+    QIODevice *m_device;
+    QByteArray *m_out;
+    QByteArray m_chunk;
+    JsonFormat m_format;
+
+    // For each open container, whether no element has been written to it yet
+    QVector<bool> m_empty;
+    bool m_afterKey;
+    bool m_error;
+
+    // Output of the last save for incremental writing, and whether fragments are recorded
+    const QByteArray *m_previous;
+    bool m_track;
+
+    // Write a node and its subtree
+    // The previous fragment of the node starts at oldStart, or oldStart is -1, if there is none.
+    void writeNode(JsonTreeItem *item, qint64 oldStart = -1);
+
+    // Write a child node behind its key or separator and record its fragment relative to the parent
+    void writeChild(JsonTreeItem *parent, JsonTreeItem *child, qint64 parentOldStart, qint64 parentStart);
+
+    // Write the range of a lazy node, the tokens are copied and only the whitespace is rewritten
+    void writeRange(const char *pos, const char *end);
+
+    void beginContainer(char open);
+    void endContainer(char close);
+
+    // Write separator and indentation in front of the next element
+    void prepareElement();
+    void prepareValue();
+    void writeIndentation(int depth);
+    void writeKeySeparator();
+
+    void writeString(const QString &str);
+    void writeInteger(qint64 number);
+    void writeDouble(double number);
+    void writeFloat(float number);
+
+    // Elements of the data of derived classes, which are written in place of the child nodes
+    void addValue(const QString &key, const QVariant &value) override;
+    void addString(const QString &key, const QString &str) override;
+    void addInteger(const QString &key, qint64 number) override;
+    void addDouble(const QString &key, double number) override;
+    void addFloat(const QString &key, float number) override;
+
+    void append(const char *data, int size);
+    void append(char c) { append(&c, 1); }
+};
+
+#endif // JSONWRITER_H
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "test_configitem.h"
+#include "test_jsontreeitem.h"
 
 int main(int argc, char **argv)
 {
@@ -9,17 +9,53 @@ SRC_DIR = $$ROOT_DIR/src
 GTEST_SRCDIR = $$ROOT_DIR/googletest/googletest
 GMOCK_SRCDIR = $$ROOT_DIR/googletest/googlemock
 
+# The statistics of the trees are tested as well
+DEFINES += JSONCONFIG_STATS
+
 SOURCES += \
     main.cpp \
+    $$SRC_DIR/configbinding.cpp \
     $$SRC_DIR/configitem.cpp \
+    $$SRC_DIR/jsonbinary.cpp \
+    $$SRC_DIR/jsonfilewatcher.cpp \
+    $$SRC_DIR/jsonkeypool.cpp \
+    $$SRC_DIR/jsonparallelloader.cpp \
+    $$SRC_DIR/jsonparser.cpp \
+    $$SRC_DIR/jsonpatch.cpp \
+    $$SRC_DIR/jsonpath.cpp \
+    $$SRC_DIR/jsonquery.cpp \
+    $$SRC_DIR/jsonsavequeue.cpp \
+    $$SRC_DIR/jsonsimd.cpp \
+    $$SRC_DIR/jsonsnapshot.cpp \
+    $$SRC_DIR/jsontreearena.cpp \
     $$SRC_DIR/jsontreeitem.cpp \
+    $$SRC_DIR/jsontreepublisher.cpp \
+    $$SRC_DIR/jsontreestats.cpp \
+    $$SRC_DIR/jsonwriter.cpp \
     $$GTEST_SRCDIR/src/gtest-all.cc \
     $$GMOCK_SRCDIR/src/gmock-all.cc
 
 HEADERS += \
     test_configitem.h \
+    test_jsontreeitem.h \
+    $$SRC_DIR/configbinding.h \
     $$SRC_DIR/configitem.h \
-    $$SRC_DIR/jsontreeitem.h
+    $$SRC_DIR/jsonbinary.h \
+    $$SRC_DIR/jsonfilewatcher.h \
+    $$SRC_DIR/jsonkeypool.h \
+    $$SRC_DIR/jsonparallelloader.h \
+    $$SRC_DIR/jsonparser.h \
+    $$SRC_DIR/jsonpatch.h \
+    $$SRC_DIR/jsonpath.h \
+    $$SRC_DIR/jsonquery.h \
+    $$SRC_DIR/jsonsavequeue.h \
+    $$SRC_DIR/jsonsimd.h \
+    $$SRC_DIR/jsonsnapshot.h \
+    $$SRC_DIR/jsontreearena.h \
+    $$SRC_DIR/jsontreeitem.h \
+    $$SRC_DIR/jsontreepublisher.h \
+    $$SRC_DIR/jsontreestats.h \
+    $$SRC_DIR/jsonwriter.h
 
 INCLUDEPATH += \
     $$SRC_DIR \
@@ -5,6 +5,7 @@
 #include <QFile>
 
 #include <gtest/gtest.h>
+#include <configbinding.h>
 #include <configitem.h>
 
 TEST(ConfigItem, RemoveItem)
@@ -106,4 +107,378 @@ TEST(ConfigItem, SaveAndLoad)
     EXPECT_TRUE(config.stringList(objPath, key).size() == filterListNew.size());
 }
 
+TEST(ConfigItem, ArenaAllocation)
+{
+    ConfigItem config;
+    config.setArenaEnabled(true);
+
+    config.stringList("Components", "Search filter") = QStringList{"Capacitor", "100nF"};
+    config.value("Components", "Search Active") = true;
+
+    // Child nodes are created as ConfigItem from the arena
+    QByteArray json = config.saveToJson();
+    ASSERT_TRUE(config.loadFromJson(json));
+    EXPECT_EQ(config.stringList("Components", "Search filter"), QStringList({"Capacitor", "100nF"}));
+    EXPECT_TRUE(config.value("Components", "Search Active").toBool());
+}
+
+TEST(ConfigItem, IncrementalSave)
+{
+    ConfigItem config;
+    config.stringList("Components", "Search filter") = QStringList{"Capacitor", "100nF"};
+    config.value("Other", "Visible") = true;
+    const QByteArray first = config.saveToJson();
+
+    // Changes through the accessors of the extended types are saved
+    config.stringList("Components", "Search filter").push_back("0603");
+    const QByteArray second = config.saveToJson();
+    EXPECT_NE(first, second);
+
+    // Also through references, which are kept across a save
+    QStringList &filter = config.stringList("Components", "Search filter");
+    EXPECT_EQ(config.saveToJson(), second);
+    filter.push_back("X7R");
+    EXPECT_TRUE(config.saveToJson().contains("X7R"));
+    EXPECT_EQ(config.snapshot().itemAt("Components", "Search filter").size(), 4);
+    filter.removeLast();
+    EXPECT_EQ(config.saveToJson(), second);
+
+    ConfigItem copy;
+    ASSERT_TRUE(copy.loadFromJson(second));
+    EXPECT_EQ(copy.stringList("Components", "Search filter").size(), 3);
+    EXPECT_TRUE(copy.value("Other", "Visible").toBool());
+}
+
+TEST(ConfigItem, LazyLoad)
+{
+    ConfigItem config;
+    ASSERT_TRUE(config.loadFromJson("{\"Components\": {\"Search filter\": [\"Capacitor\", \"100nF\"]}}",
+                                    nullptr, ConfigItem::Lazy));
+
+    // Child nodes of lazy nodes are created as ConfigItem
+    EXPECT_EQ(config.stringList("Components", "Search filter"), QStringList({"Capacitor", "100nF"}));
+}
+
+TEST(ConfigItem, BinarySnapshot)
+{
+    ConfigItem config;
+    config.stringMap("Components", "Aliases") = QMap<QString, QString>{{"C", "Capacitor"}, {"R", "Resistor"}};
+    config.stringList("Components", "Search filter") = QStringList{"Capacitor", "100nF"};
+    config.intList("Components", "Columns") = QList<int>{3, 1, 2};
+
+    ConfigItem copy;
+    ASSERT_TRUE(copy.loadFromBinary(config.saveToBinary()));
+
+    // The extended types are restored without loss
+    EXPECT_EQ(copy.stringMap("Components", "Aliases"), config.stringMap("Components", "Aliases"));
+    EXPECT_EQ(copy.stringList("Components", "Search filter"), config.stringList("Components", "Search filter"));
+    EXPECT_EQ(copy.intList("Components", "Columns"), config.intList("Components", "Columns"));
+}
+
+TEST(ConfigItem, Snapshot)
+{
+    ConfigItem config;
+    config.stringList("Components", "Search filter") = QStringList{"Capacitor", "100nF"};
+    const JsonSnapshot snapshot = config.snapshot();
+
+    config.stringList("Components", "Search filter").push_back("0603");
+    EXPECT_EQ(config.snapshot().itemAt("Components", "Search filter").size(), 3);
+
+    // The extended data is restored from the snapshot
+    config.restore(snapshot);
+    EXPECT_EQ(config.stringList("Components", "Search filter"), QStringList({"Capacitor", "100nF"}));
+}
+
+TEST(ConfigItem, Update)
+{
+    ConfigItem config;
+    QStringList &filter = config.stringList("Components", "Search filter");
+    filter = QStringList{"Capacitor", "100nF"};
+    QList<int> &columns = config.intList("Components", "Columns");
+    columns = QList<int>{3, 1, 2};
+
+    JsonTreeItem reloaded;
+    ASSERT_TRUE(reloaded.loadFromJson("{\"Components\": {\"Search filter\": [\"Capacitor\", \"0603\"], \"Columns\": [3, 1, 2]}}"));
+
+    // The extended data is updated in place
+    QVector<JsonPath> changedPaths;
+    EXPECT_TRUE(config.update(reloaded, &changedPaths));
+    EXPECT_EQ(changedPaths, QVector<JsonPath>({JsonPath("Components/Search filter")}));
+    EXPECT_EQ(&config.stringList("Components", "Search filter"), &filter);
+    EXPECT_EQ(filter, QStringList({"Capacitor", "0603"}));
+    EXPECT_EQ(&config.intList("Components", "Columns"), &columns);
+}
+
+// ConfigItem, which counts its living nodes
+class CountedConfigItem : public ConfigItem
+{
+public:
+    static inline int count = 0;
+
+    CountedConfigItem() { ++count; }
+    ~CountedConfigItem() override { --count; }
+
+protected:
+    CountedConfigItem *newItem() const override { return createItem<CountedConfigItem>(); }
+};
+
+TEST(ConfigItem, DirectSerialization)
+{
+    QByteArray json = "{\"list\": [";
+    for (int i = 0; i < 1000; ++i)
+        json += (i > 0 ? ", \"entry" : "\"entry") + QByteArray::number(i) + "\"";
+    json += "], \"columns\": [3, 1, 2], \"map\": {\"b\": \"2\", \"a\": \"1\"}}";
+
+    {
+        CountedConfigItem config;
+        ASSERT_TRUE(config.loadFromJson(json));
+        EXPECT_EQ(CountedConfigItem::count, 1 + 3 + 1000 + 3 + 2);
+
+        // The child nodes are deleted, when they are converted
+        QStringList &list = config.stringList("list");
+        ASSERT_EQ(list.size(), 1000);
+        EXPECT_EQ(list.at(999), "entry999");
+        EXPECT_EQ(config.intList("columns"), QList<int>({3, 1, 2}));
+        EXPECT_EQ(config.stringMap("map").value("b"), "2");
+        EXPECT_EQ(CountedConfigItem::count, 1 + 3);
+
+        // Saving and snapshots write the containers without creating nodes
+        list[0] = "first";
+        const QByteArray saved = config.saveToJson(JsonTreeItem::Compact);
+        config.stringList("list").push_back("last");
+        config.saveToJson();
+        config.saveToBinary();
+        const JsonSnapshot snapshot = config.snapshot();
+        EXPECT_EQ(CountedConfigItem::count, 1 + 3);
+        EXPECT_EQ(snapshot.itemAt("list").at(1000).value().toString(), "last");
+        EXPECT_EQ(snapshot.itemAt("map").keyAt(0), "a");
+
+        ConfigItem reloaded;
+        ASSERT_TRUE(reloaded.loadFromJson(saved));
+        EXPECT_EQ(reloaded.stringList("list").first(), "first");
+        EXPECT_EQ(reloaded.intList("columns"), QList<int>({3, 1, 2}));
+        EXPECT_EQ(reloaded.stringMap("map").value("a"), "1");
+        EXPECT_TRUE(reloaded.saveToJson(JsonTreeItem::Compact) == saved);
+    }
+    EXPECT_EQ(CountedConfigItem::count, 0);
+
+    // Lazy nodes are parsed into the containers without creating their child nodes
+    {
+        CountedConfigItem config;
+        ASSERT_TRUE(config.loadFromJson(json, nullptr, JsonTreeItem::Lazy));
+        EXPECT_EQ(config.stringList("list").size(), 1000);
+        EXPECT_EQ(config.intList("columns"), QList<int>({3, 1, 2}));
+        EXPECT_EQ(CountedConfigItem::count, 1 + 3);
+    }
+    EXPECT_EQ(CountedConfigItem::count, 0);
+}
+
+TEST(ConfigItem, MixedAccessors)
+{
+    // Retyping a node through the accessors of the tree releases the containers
+    ConfigItem config;
+    config.stringList("a") = QStringList({"x", "y"});
+    config.value("a") = 5;
+    config.stringMap("b").insert("key", "value");
+    config.array("b");
+    config.doubleArray("c") = QVector<double>({1, 2});
+    config.itemAt("c")->setBase64Encoded(true);
+    config.object("c");
+
+    EXPECT_EQ(config.saveToJson(JsonTreeItem::Compact), QByteArray("{\"a\":5,\"b\":[],\"c\":{}}"));
+    EXPECT_EQ(config.snapshot().child("a").value().toInt(), 5);
+    EXPECT_EQ(config.snapshot().child("b").size(), 0);
+
+    // The containers are converted from the new content
+    EXPECT_EQ(config.value("a").toInt(), 5);
+    EXPECT_TRUE(config.stringMap("b").isEmpty());
+    EXPECT_TRUE(config.doubleArray("c").isEmpty());
+
+    config.intList("a") = QList<int>({1});
+    config.clear();
+    config.value("d") = true;
+    EXPECT_EQ(config.saveToJson(JsonTreeItem::Compact), QByteArray("{\"d\":true}"));
+}
+
+TEST(ConfigItem, PackedArrays)
+{
+    const QByteArray json = "{\"doubles\": [0.1, 2, -1.5e300], \"int64s\": [4503599627370497, -2, 3.0], "
+                            "\"floats\": [0.1, 1], \"bytes\": [1, 255, \"7\"]}";
+
+    ConfigItem config;
+    ASSERT_TRUE(config.loadFromJson(json));
+
+    EXPECT_EQ(config.doubleArray("doubles"), QVector<double>({0.1, 2., -1.5e300}));
+    EXPECT_EQ(config.int64Array("int64s"), QVector<qint64>({4503599627370497LL, -2, 3}));
+    EXPECT_EQ(config.floatArray("floats"), QVector<float>({0.1f, 1.f}));
+    EXPECT_EQ(config.uint8Array("bytes"), QVector<quint8>({1, 255, 7}));
+
+    // The numbers are written in their shortest form, which is read back without loss
+    const QByteArray saved = config.saveToJson(JsonTreeItem::Compact);
+    EXPECT_EQ(saved, "{\"doubles\":[0.1,2,-1.5e+300],\"int64s\":[4503599627370497,-2,3],"
+                     "\"floats\":[0.1,1],\"bytes\":[1,255,7]}");
+
+    ConfigItem lazy;
+    ASSERT_TRUE(lazy.loadFromJson(saved, nullptr, JsonTreeItem::Lazy));
+    EXPECT_EQ(lazy.doubleArray("doubles"), config.doubleArray("doubles"));
+    EXPECT_EQ(lazy.int64Array("int64s"), config.int64Array("int64s"));
+
+    // Lazy nodes are parsed into integers, which are exact beyond the precision of double
+    ASSERT_TRUE(lazy.loadFromJson("{\"int64s\": [9007199254740993]}", nullptr, JsonTreeItem::Lazy));
+    EXPECT_EQ(lazy.int64Array("int64s"), QVector<qint64>({9007199254740993LL}));
+
+    ConfigItem copy;
+    ASSERT_TRUE(copy.loadFromBinary(config.saveToBinary()));
+    EXPECT_EQ(copy.doubleArray("doubles"), config.doubleArray("doubles"));
+    EXPECT_EQ(copy.floatArray("floats"), config.floatArray("floats"));
+    EXPECT_EQ(copy.uint8Array("bytes"), config.uint8Array("bytes"));
+
+    // Base64 encoded arrays are saved as strings of their bytes in little endian order
+    config.itemAt("bytes")->setBase64Encoded(true);
+    config.itemAt("doubles")->setBase64Encoded(true);
+    const QByteArray encoded = config.saveToJson(JsonTreeItem::Compact);
+    EXPECT_TRUE(encoded.contains("\"bytes\":\"Af8H\""));
+
+    ConfigItem decoded;
+    ASSERT_TRUE(decoded.loadFromJson(encoded));
+    EXPECT_EQ(decoded.doubleArray("doubles"), config.doubleArray("doubles"));
+    EXPECT_EQ(decoded.uint8Array("bytes"), QVector<quint8>({1, 255, 7}));
+    EXPECT_TRUE(decoded.itemAt("bytes")->isBase64Encoded());
+    EXPECT_TRUE(decoded.saveToJson(JsonTreeItem::Compact) == encoded);
+
+    // Snapshots hold the encoded string
+    const JsonSnapshot snapshot = decoded.snapshot();
+    decoded.uint8Array("bytes").push_back(0);
+    decoded.restore(snapshot);
+    EXPECT_EQ(decoded.uint8Array("bytes"), QVector<quint8>({1, 255, 7}));
+
+    decoded.itemAt("bytes")->setBase64Encoded(false);
+    EXPECT_EQ(decoded.itemAt("bytes")->type(), JsonTreeItem::Array);
+    EXPECT_TRUE(decoded.saveToJson(JsonTreeItem::Compact).contains("\"bytes\":[1,255,7]"));
+
+    // Strings with invalid characters or a partial number result in empty arrays, but are kept
+    const QByteArray invalidJson = "{\"bytes\":\"Af8!\",\"doubles\":\"AAAA\"}";
+    ConfigItem invalid;
+    ASSERT_TRUE(invalid.loadFromJson(invalidJson));
+    EXPECT_TRUE(invalid.uint8Array("bytes").isEmpty());
+    EXPECT_TRUE(invalid.doubleArray("doubles").isEmpty());
+    EXPECT_EQ(invalid.saveToJson(JsonTreeItem::Compact), invalidJson);
+    EXPECT_EQ(invalid.snapshot().child("doubles").value().toString(), "AAAA");
+
+    invalid.uint8Array("bytes").push_back(1);
+    EXPECT_EQ(invalid.saveToJson(JsonTreeItem::Compact), QByteArray("{\"bytes\":\"AQ==\",\"doubles\":\"AAAA\"}"));
+
+    // Updates keep them as well
+    ASSERT_TRUE(decoded.loadFromJson(encoded));
+    QVector<quint8> &bytes = decoded.uint8Array("bytes");
+    ConfigItem source;
+    ASSERT_TRUE(source.loadFromJson(invalidJson));
+    ASSERT_TRUE(decoded.update(source));
+    EXPECT_EQ(&decoded.uint8Array("bytes"), &bytes);
+    EXPECT_TRUE(bytes.isEmpty());
+    EXPECT_EQ(decoded.saveToJson(JsonTreeItem::Compact), invalidJson);
+
+    // A valid encoding replaces the string again, the array stays the same container
+    ASSERT_TRUE(source.loadFromJson("{\"bytes\":\"AQ==\",\"doubles\":\"AAAA\"}"));
+    ASSERT_TRUE(decoded.update(source));
+    EXPECT_EQ(&decoded.uint8Array("bytes"), &bytes);
+    EXPECT_EQ(bytes, QVector<quint8>({1}));
+    EXPECT_EQ(decoded.saveToJson(JsonTreeItem::Compact), QByteArray("{\"bytes\":\"AQ==\",\"doubles\":\"AAAA\"}"));
+    EXPECT_FALSE(decoded.update(source));
+}
+
+struct BoundSettings
+{
+    bool showHints = true;
+    int recentCount = 5;
+    QString theme = "light";
+    QStringList recentFiles;
+    QVector<double> curve;
+
+    static constexpr auto configFields()
+    {
+        return std::make_tuple(ConfigField("General Settings/Show Hints on Startup", &BoundSettings::showHints),
+                               ConfigField("General Settings/Recent Count", &BoundSettings::recentCount),
+                               ConfigField("General Settings/Recent Files", &BoundSettings::recentFiles),
+                               ConfigField("Appearance/Theme", &BoundSettings::theme),
+                               ConfigField("Calibration/Curve", &BoundSettings::curve));
+    }
+};
+
+TEST(ConfigItem, Binding)
+{
+    static_assert(ConfigBindingData::pathsOverlap("a/b", "a"), "");
+    static_assert(!ConfigBindingData::pathsOverlap("a/b", "a/bc"), "");
+    static_assert(!ConfigBindingData::isValidPath("a//b"), "");
+
+    ConfigItem config;
+    ASSERT_TRUE(config.loadFromJson("{\"General Settings\": {\"Show Hints on Startup\": false, \"Recent Count\": 3, "
+                                    "\"Recent Files\": [\"a.json\", \"b.json\"]}, \"Calibration\": {\"Curve\": [0.5, 1]}}"));
+
+    // Fields without a node keep their value and no nodes are created for them
+    BoundSettings settings;
+    ConfigBinding<BoundSettings>::load(config, settings);
+    EXPECT_FALSE(settings.showHints);
+    EXPECT_EQ(settings.recentCount, 3);
+    EXPECT_EQ(settings.recentFiles, QStringList({"a.json", "b.json"}));
+    EXPECT_EQ(settings.curve, QVector<double>({0.5, 1.}));
+    EXPECT_EQ(settings.theme, "light");
+    EXPECT_EQ(static_cast<const JsonTreeItem &>(config).itemAt("Appearance"), nullptr);
+
+    // Saving creates the missing nodes and only marks changed ones
+    ConfigBinding<BoundSettings>::save(config, settings);
+    EXPECT_EQ(config.value("Appearance", "Theme").toString(), "light");
+
+    config.saveToJson();
+    settings.recentCount = 4;
+    ConfigBinding<BoundSettings>::save(config, settings);
+    EXPECT_TRUE(config.itemAt("General Settings")->isDirty());
+    EXPECT_FALSE(static_cast<const JsonTreeItem &>(config).itemAt("Appearance")->isDirty());
+
+    BoundSettings reloaded;
+    ConfigBinding<BoundSettings>::load(config, reloaded);
+    EXPECT_EQ(reloaded.recentCount, 4);
+    EXPECT_EQ(reloaded.theme, "light");
+    EXPECT_EQ(reloaded.recentFiles, settings.recentFiles);
+}
+
+TEST(ConfigItem, MoveItems)
+{
+    ConfigItem source;
+    QStringList &filter = source.stringList("Components", "Search filter");
+    filter = QStringList{"Capacitor", "100nF"};
+
+    // The extended data moves together with its node
+    ConfigItem target;
+    target.insertItem("Filter", source.takeItem("Components", "Search filter"));
+    EXPECT_EQ(&target.stringList("Filter"), &filter);
+    EXPECT_EQ(target.saveToJson(JsonTreeItem::Compact), "{\"Filter\":[\"Capacitor\",\"100nF\"]}");
+
+    // Containers are moved in through the references of the accessors
+    QVector<double> curve(1000, 0.5);
+    const double *data = curve.constData();
+    target.doubleArray("Curve") = std::move(curve);
+    EXPECT_EQ(target.doubleArray("Curve").constData(), data);
+}
+
+TEST(ConfigItem, Patch)
+{
+    ConfigItem config;
+    config.stringList("Components", "Search filter") = QStringList{"Capacitor", "100nF"};
+    config.intList("Components", "Columns") = QList<int>{3, 1, 2};
+
+    // The extended data is compared element by element like child nodes
+    ConfigItem other;
+    other.stringList("Components", "Search filter") = QStringList{"Capacitor", "0603"};
+    other.intList("Components", "Columns") = QList<int>{3, 1, 2};
+    const QByteArray patch = config.diff(other);
+    EXPECT_EQ(patch, "[{\"op\":\"replace\",\"path\":\"/Components/Search filter/1\",\"value\":\"0603\"}]");
+
+    // A path into the extended data turns it into child nodes, which the accessors convert back
+    ASSERT_TRUE(config.applyPatch(patch));
+    EXPECT_EQ(config.stringList("Components", "Search filter"), QStringList({"Capacitor", "0603"}));
+    EXPECT_EQ(config.intList("Components", "Columns"), QList<int>({3, 1, 2}));
+    EXPECT_EQ(config.diff(other), "[]");
+}
+
 #endif // TEST_CONFIGITEM_H
\ No newline at end of file
@@ -0,0 +1,1215 @@
+#ifndef TEST_JSONTREEITEM_H
+#define TEST_JSONTREEITEM_H
+
+#include <QAtomicInt>
+#include <QFile>
+#include <QPoint>
+#include <QThreadPool>
+
+#include <thread>
+
+#include <gtest/gtest.h>
+#include <jsonfilewatcher.h>
+#include <jsonparallelloader.h>
+#include <jsonparser.h>
+#include <jsonpath.h>
+#include <jsonquery.h>
+#include <jsonsimd.h>
+#include <jsonsnapshot.h>
+#include <jsontreeitem.h>
+#include <jsontreepublisher.h>
+#include <jsonwriter.h>
+
+TEST(JsonTreeItem, WideObject)
+{
+    JsonTreeItem root;
+
+    const int keyCount = 4 * JsonTreeItem::IndexThreshold;
+
+    // Fill the object beyond the index threshold
+    for (int i = 0; i < keyCount; ++i)
+        root.value("Wide", QString("key%1").arg(i)) = i;
+
+    // The insertion order is preserved
+    const QVector<JsonTreeItem *> &children = root.object("Wide");
+    ASSERT_EQ(children.size(), keyCount);
+    for (int i = 0; i < keyCount; ++i)
+        EXPECT_EQ(children.at(i)->key(), QString("key%1").arg(i));
+
+    // Remove every other key
+    for (int i = 0; i < keyCount; i += 2)
+        root.removeItem("Wide", QString("key%1").arg(i));
+
+    for (int i = 0; i < keyCount; ++i)
+        EXPECT_EQ(root.contains("Wide", QString("key%1").arg(i)), i % 2 == 1);
+    EXPECT_EQ(root.value("Wide", "key33").toInt(), 33);
+
+    // Renaming a child node is reflected by the lookup
+    root.itemAt("Wide", "key33")->setKey("renamed");
+    EXPECT_FALSE(root.contains("Wide", "key33"));
+    EXPECT_TRUE(root.contains("Wide", "renamed"));
+    EXPECT_EQ(root.value("Wide", "renamed").toInt(), 33);
+
+    // Child nodes, which are appended to the vector directly, are found and can be renamed
+    JsonTreeItem *appended = new JsonTreeItem;
+    appended->setKey("appended");
+    appended->value() = 1;
+    root.object("Wide").push_back(appended);
+    EXPECT_EQ(root.itemAt("Wide", "appended"), appended);
+    appended->setKey("appended again");
+    EXPECT_FALSE(root.contains("Wide", "appended"));
+    EXPECT_EQ(root.value("Wide", "appended again").toInt(), 1);
+
+    // Removing child nodes in front of others keeps the lookup of the others intact
+    root.removeItem("Wide", "key1");
+    EXPECT_EQ(root.value("Wide", "key3").toInt(), 3);
+    EXPECT_FALSE(root.contains("Wide", "key1"));
+
+    // Replacing a child node through the vector keeps the size, but the new key is found
+    QVector<JsonTreeItem *> &members = root.object("Wide");
+    EXPECT_EQ(root.value("Wide", "key5").toInt(), 5);
+    const int size = members.size();
+    delete members.takeLast();
+    JsonTreeItem *replacement = new JsonTreeItem;
+    replacement->setKey("new");
+    replacement->value() = 42;
+    members.push_back(replacement);
+    ASSERT_EQ(members.size(), size);
+    EXPECT_TRUE(root.contains("Wide", "new"));
+    root.value("Wide", "new") = 7;
+    EXPECT_EQ(root.object("Wide").size(), size);
+    EXPECT_EQ(replacement->value().toInt(), 7);
+    EXPECT_FALSE(root.contains("Wide", "appended again"));
+}
+
+TEST(JsonTreeItem, JsonPath)
+{
+    JsonTreeItem root;
+
+    const JsonPath path("Components/View/Navigation/Visible");
+    EXPECT_EQ(path.objectDepth(), 3);
+    EXPECT_EQ(path.key(), QString("Visible"));
+
+    // The key of the two-argument constructor is not split
+    EXPECT_EQ(JsonPath("Components/View", "Width/Height").key(), QString("Width/Height"));
+
+    EXPECT_FALSE(root.contains(path));
+    root.value(path) = true;
+    EXPECT_TRUE(root.contains(path));
+    EXPECT_TRUE(root.contains("Components/View/Navigation", "Visible"));
+    EXPECT_TRUE(root.value("Components/View/Navigation", "Visible").toBool());
+
+    // The handle resolves the node once and again after structural changes
+    JsonItemHandle handle(&root, path);
+    JsonTreeItem *item = handle.item();
+    EXPECT_EQ(item, root.itemAt(path));
+    EXPECT_TRUE(handle.value().toBool());
+
+    const uint generation = root.generation();
+    root.removeItem("Components/View/Navigation", "Visible");
+    EXPECT_NE(root.generation(), generation);
+    EXPECT_FALSE(root.contains(path));
+
+    handle.value() = false;
+    EXPECT_TRUE(root.contains(path));
+    EXPECT_FALSE(root.value(path).toBool());
+}
+
+TEST(JsonTreeItem, LoadFromJson)
+{
+    JsonTreeItem root;
+
+    const QByteArray json = "{\n"
+                            "    \"b\": 1.5,\n"
+                            "    \"a\": [true, false, null, -12],\n"
+                            "    \"c\": {\"text\": \"line\\n\\u00e4\\ud83d\\ude00\"}\n"
+                            "}\n";
+    ASSERT_TRUE(root.loadFromJson(json));
+
+    // The keys keep the order of the document
+    const QVector<JsonTreeItem *> &children = root.object();
+    ASSERT_EQ(children.size(), 3);
+    EXPECT_EQ(children.at(0)->key(), QString("b"));
+    EXPECT_EQ(children.at(1)->key(), QString("a"));
+    EXPECT_EQ(children.at(2)->key(), QString("c"));
+
+    EXPECT_EQ(root.value("b").toDouble(), 1.5);
+    const QVector<JsonTreeItem *> &array = root.array("a");
+    ASSERT_EQ(array.size(), 4);
+    EXPECT_TRUE(array.at(0)->value().toBool());
+    EXPECT_FALSE(array.at(1)->value().toBool());
+    EXPECT_TRUE(array.at(2)->value().isNull());
+    EXPECT_EQ(array.at(3)->value().toInt(), -12);
+    EXPECT_EQ(root.value("c", "text").toString(), QString::fromUtf8("line\n\xc3\xa4\xf0\x9f\x98\x80"));
+
+    // Merge a second document
+    ASSERT_TRUE(root.appendJson("{\"a\": [7], \"c\": {\"more\": 2}}"));
+    EXPECT_EQ(root.array("a").size(), 5);
+    EXPECT_EQ(root.value("c", "text").toString().left(4), QString("line"));
+    EXPECT_EQ(root.value("c", "more").toInt(), 2);
+}
+
+TEST(JsonTreeItem, ParseError)
+{
+    JsonTreeItem root;
+    JsonParseError error;
+
+    EXPECT_FALSE(root.loadFromJson("{\n  \"a\": 1,\n  \"b\" 2\n}", &error));
+    EXPECT_EQ(error.error, JsonParseError::UnexpectedCharacter);
+    EXPECT_EQ(error.line, 3);
+    EXPECT_EQ(error.column, 7);
+
+    // The tree is empty after an error
+    EXPECT_EQ(root.type(), JsonTreeItem::Object);
+    EXPECT_TRUE(root.object().isEmpty());
+
+    EXPECT_FALSE(root.loadFromJson("[1, 2", &error));
+    EXPECT_EQ(error.error, JsonParseError::UnexpectedEnd);
+
+    EXPECT_FALSE(root.loadFromJson("\"text\"", &error));
+    EXPECT_EQ(error.error, JsonParseError::MissingContainer);
+}
+
+TEST(JsonTreeItem, SaveToJson)
+{
+    JsonTreeItem root;
+
+    root.value("z") = "quote \" and backslash \\";
+    root.value("Numbers", "int") = 42;
+    root.value("Numbers", "double") = 0.5;
+    root.array("Empty");
+    root.value("a") = QVariant();
+
+    // Compact output keeps the insertion order of the keys
+    EXPECT_EQ(root.saveToJson(JsonTreeItem::Compact),
+              QByteArray("{\"z\":\"quote \\\" and backslash \\\\\","
+                         "\"Numbers\":{\"int\":42,\"double\":0.5},\"Empty\":[],\"a\":null}"));
+
+    EXPECT_EQ(root.saveToJson(JsonTreeItem::Indented),
+              QByteArray("{\n"
+                         "    \"z\": \"quote \\\" and backslash \\\\\",\n"
+                         "    \"Numbers\": {\n"
+                         "        \"int\": 42,\n"
+                         "        \"double\": 0.5\n"
+                         "    },\n"
+                         "    \"Empty\": [],\n"
+                         "    \"a\": null\n"
+                         "}\n"));
+
+    // The reusable buffer is overwritten
+    QByteArray buffer = "previous content";
+    ASSERT_TRUE(root.saveToJson(buffer, JsonTreeItem::Compact));
+    EXPECT_EQ(buffer, root.saveToJson(JsonTreeItem::Compact));
+
+    // Round trip through the parser
+    JsonTreeItem copy;
+    ASSERT_TRUE(copy.loadFromJson(buffer));
+    EXPECT_EQ(copy.saveToJson(), root.saveToJson());
+
+    // Hashes are written like maps
+    QVariantHash hash;
+    hash.insert("key", 1);
+    JsonTreeItem hashRoot;
+    hashRoot.value("hash") = hash;
+    EXPECT_EQ(hashRoot.saveToJson(JsonTreeItem::Compact), QByteArray("{\"hash\":{\"key\":1}}"));
+
+    // Types without a JSON or string representation fail the save instead of being written as ""
+    JsonTreeItem pointRoot;
+    pointRoot.value("point") = QPoint(1, 2);
+    EXPECT_FALSE(pointRoot.saveToJson(buffer, JsonTreeItem::Compact));
+    EXPECT_EQ(buffer, QByteArray("{\"point\":null}"));
+}
+
+TEST(JsonTreeItem, LoadFromFile)
+{
+    const QString filename = "test_load.json";
+
+    QFile file(filename);
+    ASSERT_TRUE(file.open(QFile::WriteOnly));
+    file.write("{\"Name\": \"Gr\xc3\xbc\xc3\x9f""e\", \"List\": [1, 2, 3]}\n");
+    file.close();
+
+    JsonTreeItem root;
+    JsonParseError error;
+    ASSERT_TRUE(root.loadFromFile(filename, &error));
+    EXPECT_EQ(error.error, JsonParseError::NoError);
+    EXPECT_EQ(root.value("Name").toString(), QString::fromUtf8("Gr\xc3\xbc\xc3\x9f""e"));
+    EXPECT_EQ(root.array("List").size(), 3);
+
+    // A missing file is reported and leaves the tree unchanged
+    EXPECT_FALSE(root.loadFromFile("does_not_exist.json", &error));
+    EXPECT_EQ(error.error, JsonParseError::FileError);
+    EXPECT_TRUE(root.contains("Name"));
+
+    // An empty file cannot be mapped and is read into a buffer
+    ASSERT_TRUE(file.open(QFile::WriteOnly));
+    file.close();
+    EXPECT_FALSE(root.loadFromFile(filename, &error));
+    EXPECT_EQ(error.error, JsonParseError::UnexpectedEnd);
+    EXPECT_TRUE(root.object().isEmpty());
+
+    QFile::remove(filename);
+}
+
+TEST(JsonTreeItem, LazyLoad)
+{
+    const QByteArray json = "{\n"
+                            "  \"Name\": \"lazy \\\" [{\",\n"
+                            "  \"Items\": [1, 2, {\"Nested\": [true, null, \"]\"]}],\n"
+                            "  \"Settings\": {\"Width\": 640, \"Height\": 480, \"Empty\": {}}\n"
+                            "}\n";
+
+    JsonTreeItem eager;
+    ASSERT_TRUE(eager.loadFromJson(json));
+
+    JsonTreeItem root;
+    ASSERT_TRUE(root.loadFromJson(json, nullptr, JsonTreeItem::Lazy));
+    EXPECT_EQ(root.type(), JsonTreeItem::Object);
+    EXPECT_FALSE(root.isMaterialized());
+
+    // Untouched subtrees are written in the requested format
+    EXPECT_EQ(root.saveToJson(JsonTreeItem::Compact), eager.saveToJson(JsonTreeItem::Compact));
+    EXPECT_EQ(root.saveToJson(JsonTreeItem::Indented), eager.saveToJson(JsonTreeItem::Indented));
+    EXPECT_FALSE(root.isMaterialized());
+
+    // Only the accessed part of the tree is parsed
+    EXPECT_EQ(root.value("Settings", "Width").toInt(), 640);
+    EXPECT_TRUE(root.isMaterialized());
+    EXPECT_TRUE(root.itemAt("Settings")->isMaterialized());
+    EXPECT_FALSE(root.itemAt("Items")->isMaterialized());
+    EXPECT_EQ(root.value("Name").toString(), QString("lazy \" [{"));
+
+    root.value("Settings", "Width") = 800;
+    eager.value("Settings", "Width") = 800;
+    EXPECT_EQ(root.saveToJson(), eager.saveToJson());
+
+    // Merging materializes the affected nodes
+    ASSERT_TRUE(root.appendJson("{\"Items\": [4]}"));
+    ASSERT_TRUE(eager.appendJson("{\"Items\": [4]}"));
+    EXPECT_EQ(root.array("Items").size(), 4);
+    EXPECT_EQ(root.saveToJson(), eager.saveToJson());
+
+    // Errors in nested subtrees are detected while loading
+    JsonParseError lazyError;
+    JsonParseError eagerError;
+    const QByteArray invalid = "{\"a\": 1, \"b\": [1, 2, {\"c\": tru}]}";
+    EXPECT_FALSE(root.loadFromJson(invalid, &lazyError, JsonTreeItem::Lazy));
+    EXPECT_FALSE(eager.loadFromJson(invalid, &eagerError));
+    EXPECT_EQ(lazyError.error, eagerError.error);
+    EXPECT_EQ(lazyError.offset, eagerError.offset);
+    EXPECT_TRUE(root.isMaterialized());
+    EXPECT_TRUE(root.object().isEmpty());
+
+    // Lazy loading from a mapped file
+    const QString filename = "test_lazy.json";
+    QFile file(filename);
+    ASSERT_TRUE(file.open(QFile::WriteOnly));
+    file.write(json);
+    file.close();
+
+    ASSERT_TRUE(root.loadFromFile(filename, nullptr, JsonTreeItem::Lazy));
+    EXPECT_FALSE(root.isMaterialized());
+    EXPECT_EQ(root.array("Items").size(), 3);
+    EXPECT_TRUE(root.contains("Settings", "Height"));
+    root.clear();
+    QFile::remove(filename);
+}
+
+// Serialize the whole tree without reusing fragments
+static QByteArray fullJson(JsonTreeItem *root, JsonTreeItem::JsonFormat format = JsonTreeItem::Indented)
+{
+    QByteArray json;
+    JsonWriter writer(&json, format);
+    writer.write(root);
+    return json;
+}
+
+TEST(JsonTreeItem, IncrementalSave)
+{
+    JsonTreeItem root;
+    for (int i = 0; i < 20; ++i) {
+        const QString path = QString("Section%1").arg(i);
+        root.value(path, "Enabled") = i % 2 == 0;
+        root.value(path, "Name") = QString("section %1").arg(i);
+        root.array(path, "Values");
+    }
+
+    EXPECT_TRUE(root.isDirty());
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    EXPECT_FALSE(root.isDirty());
+    EXPECT_FALSE(root.itemAt("Section3")->isDirty());
+
+    // A change marks the path up to the root, but not its siblings
+    root.value("Section3", "Enabled") = true;
+    EXPECT_TRUE(root.isDirty());
+    EXPECT_TRUE(root.itemAt("Section3")->isDirty());
+    EXPECT_FALSE(root.itemAt("Section4")->isDirty());
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+
+    // Additions, removals, renaming and retyping
+    root.value("Section5", "Added") = 1.5;
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    root.removeItem("Section6", "Name");
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    root.itemAt("Section7", "Name")->setKey("Title");
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    root.object("Section8", "Enabled");
+    root.value("Section8/Enabled", "Nested") = "value";
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    root.itemAt("Section9")->clear();
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+
+    // Nodes without a type become visible, once they get a value
+    root.itemAt("Section10", "Later");
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    root.value("Section10", "Later") = 10;
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+
+    // The fragments are kept per format
+    EXPECT_EQ(root.saveToJson(JsonTreeItem::Compact), fullJson(&root, JsonTreeItem::Compact));
+    root.value("Section11", "Name") = "compact";
+    EXPECT_EQ(root.saveToJson(JsonTreeItem::Compact), fullJson(&root, JsonTreeItem::Compact));
+    root.value("Section12", "Name") = "indented";
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+
+    // Without changes the previous output is returned
+    EXPECT_EQ(root.saveToJson(), root.saveToJson());
+
+    // References, which are kept across a save, still change the output
+    QVariant &name = root.value("Section15", "Name");
+    QVector<JsonTreeItem *> &members = root.object("Section16");
+    const QByteArray beforeReferences = root.saveToJson();
+    name = "reference";
+    EXPECT_FALSE(root.isDirty());
+    EXPECT_NE(root.saveToJson(), beforeReferences);
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    std::swap(members[0], members[1]);
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    EXPECT_TRUE(root.saveToJson().contains("\"Name\": \"section 16\",\n        \"Enabled\""));
+
+    // Values assigned by setValue() only change their path
+    root.setValue("Section17", "Name", "setter");
+    EXPECT_TRUE(root.isDirty());
+    EXPECT_FALSE(root.itemAt("Section18")->isDirty());
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    EXPECT_EQ(root.value("Section17", "Name").toString(), QString("setter"));
+
+    // Clean nodes, which are moved into another array or object through the vectors, are written
+    // again instead of using their fragment from the previous parent
+    JsonTreeItem moves;
+    ASSERT_TRUE(moves.loadFromJson("{\"a\": [{\"x\": 1, \"y\": [true, false]}], \"b\": [1, 2, 3, 4, 5, 6, 7, 8, 9, 10], "
+                                   "\"c\": {\"first\": \"a long string value\"}, \"d\": {\"k1\": 1, \"k2\": 2, \"k3\": 3}}"));
+    moves.saveToJson();
+    moves.array("b").push_back(moves.array("a").takeLast());
+    EXPECT_EQ(moves.saveToJson(), fullJson(&moves));
+    moves.object("d").push_back(moves.object("c").takeLast());
+    EXPECT_EQ(moves.saveToJson(), fullJson(&moves));
+    EXPECT_EQ(moves.saveToJson(JsonTreeItem::Compact),
+              QByteArray("{\"a\":[],\"b\":[1,2,3,4,5,6,7,8,9,10,{\"x\":1,\"y\":[true,false]}],\"c\":{},"
+                         "\"d\":{\"k1\":1,\"k2\":2,\"k3\":3,\"first\":\"a long string value\"}}"));
+
+    // Lazy subtrees are copied after the first save as well
+    ASSERT_TRUE(root.loadFromJson(fullJson(&root), nullptr, JsonTreeItem::Lazy));
+    const QByteArray lazy = root.saveToJson();
+    root.value("Section13", "Name") = "lazy";
+    EXPECT_FALSE(root.itemAt("Section14")->isMaterialized());
+    EXPECT_EQ(root.saveToJson(), fullJson(&root));
+    EXPECT_NE(root.saveToJson(), lazy);
+}
+
+TEST(JsonTreeItem, ArenaAllocation)
+{
+    const QByteArray json = "{\"Name\":\"arena\",\"Items\":[1,2,{\"Nested\":[true,null]}],"
+                            "\"Settings\":{\"Width\":640,\"Height\":480}}";
+
+    JsonTreeItem heap;
+    ASSERT_TRUE(heap.loadFromJson(json));
+
+    JsonTreeItem root;
+    root.setArenaEnabled(true);
+    ASSERT_TRUE(root.isArenaEnabled());
+    ASSERT_TRUE(root.loadFromJson(json));
+
+    // The tree behaves the same as with heap allocation
+    EXPECT_EQ(root.saveToJson(), heap.saveToJson());
+    EXPECT_TRUE(root.itemAt("Settings", "Width")->isArenaEnabled());
+
+    root.removeItem("Settings", "Width");
+    root.value("Settings", "Depth") = 24;
+    heap.removeItem("Settings", "Width");
+    heap.value("Settings", "Depth") = 24;
+    EXPECT_EQ(root.saveToJson(), heap.saveToJson());
+
+    // The tree can be filled again after the arena has been released
+    root.reset();
+    EXPECT_TRUE(root.object().isEmpty());
+    ASSERT_TRUE(root.loadFromJson(json));
+    EXPECT_EQ(root.value("Settings", "Height").toInt(), 480);
+
+    // Only the root decides on the allocation mode
+    root.itemAt("Settings", "Height")->setArenaEnabled(false);
+    EXPECT_TRUE(root.itemAt("Settings", "Height")->isArenaEnabled());
+
+    // Switching back to heap allocation clears the tree
+    root.setArenaEnabled(false);
+    EXPECT_FALSE(root.isArenaEnabled());
+    EXPECT_TRUE(root.isNull());
+}
+
+TEST(JsonTreeItem, SaveToFileAsync)
+{
+    const QString filename = "test_save_async.json";
+
+    JsonTreeItem root;
+    root.value("Settings", "Width") = 640;
+    QFuture<bool> first = root.saveToFileAsync(filename);
+
+    // Saves requested in a row are written in order, the last one is in the file
+    QFuture<bool> last;
+    for (int i = 0; i < 10; ++i) {
+        root.value("Settings", "Height") = i;
+        last = root.saveToFileAsync(filename, JsonTreeItem::Compact);
+    }
+    EXPECT_TRUE(first.result());
+    EXPECT_TRUE(last.result());
+
+    JsonTreeItem copy;
+    ASSERT_TRUE(copy.loadFromFile(filename));
+    EXPECT_EQ(copy.value("Settings", "Width").toInt(), 640);
+    EXPECT_EQ(copy.value("Settings", "Height").toInt(), 9);
+
+    // A failed save leaves the previous file in place
+    EXPECT_FALSE(root.saveToFileAsync("does_not_exist/test.json").result());
+    EXPECT_FALSE(root.saveToFile("does_not_exist/test.json"));
+    JsonTreeItem value;
+    value.value() = 1;
+    EXPECT_FALSE(value.saveToFileAsync(filename).result());
+    ASSERT_TRUE(copy.loadFromFile(filename));
+    EXPECT_EQ(copy.value("Settings", "Height").toInt(), 9);
+
+    QFile::remove(filename);
+}
+
+TEST(JsonTreeItem, BinarySnapshot)
+{
+    JsonTreeItem root;
+    root.value("Name") = QString::fromUtf8("Gr\xc3\xbc\xc3\x9f""e");
+    root.value("Settings", "Width") = 640;
+    root.value("Settings", "Scale") = 1.5;
+    root.value("Settings", "Id") = qlonglong(1) << 40;
+    root.value("Settings", "Visible") = true;
+    root.value("Settings", "Empty");
+    root.value("Settings", "Tags") = QStringList{"a", "b"};
+    root.itemAt("Unused");
+    for (int i = 0; i < 3; ++i)
+        root.value(QString("Records/Record%1").arg(i), "Name") = "record";
+
+    const QByteArray binary = root.saveToBinary();
+
+    JsonTreeItem copy;
+    JsonParseError error;
+    ASSERT_TRUE(copy.loadFromBinary(binary, &error));
+    EXPECT_EQ(error.error, JsonParseError::NoError);
+    EXPECT_EQ(copy.saveToJson(), root.saveToJson());
+
+    // The types of the values are kept, while JSON reads all numbers as double
+    EXPECT_EQ(copy.value("Settings", "Width").type(), QVariant::Int);
+    EXPECT_EQ(copy.value("Settings", "Id").toLongLong(), qlonglong(1) << 40);
+    EXPECT_EQ(copy.value("Settings", "Id").type(), QVariant::LongLong);
+    EXPECT_EQ(copy.value("Settings", "Tags").toStringList(), QStringList({"a", "b"}));
+    EXPECT_FALSE(copy.value("Settings", "Empty").isValid());
+
+    // The snapshot is written in the same way again
+    EXPECT_EQ(copy.saveToBinary(), binary);
+
+    // A truncated snapshot is reported and leaves an empty tree
+    EXPECT_FALSE(copy.loadFromBinary(binary.left(binary.size() - 1), &error));
+    EXPECT_EQ(error.error, JsonParseError::UnexpectedEnd);
+    EXPECT_TRUE(copy.object().isEmpty());
+
+    EXPECT_FALSE(copy.loadFromBinary(root.saveToJson(), &error));
+    EXPECT_EQ(error.error, JsonParseError::InvalidBinary);
+
+    QByteArray otherVersion = binary;
+    otherVersion[4] = 2;
+    EXPECT_FALSE(copy.loadFromBinary(otherVersion, &error));
+    EXPECT_EQ(error.error, JsonParseError::UnsupportedVersion);
+
+    // Round trip through a file
+    const QString filename = "test_snapshot.bin";
+    ASSERT_TRUE(root.saveToBinaryFile(filename));
+    ASSERT_TRUE(copy.loadFromBinaryFile(filename, &error));
+    EXPECT_EQ(copy.saveToJson(), root.saveToJson());
+    QFile::remove(filename);
+
+    EXPECT_FALSE(copy.loadFromBinaryFile(filename, &error));
+    EXPECT_EQ(error.error, JsonParseError::FileError);
+}
+
+TEST(JsonTreeItem, ConstLookup)
+{
+    JsonTreeItem root;
+    root.value("Settings", "Width") = 640;
+    root.value("Name") = "const";
+
+    const JsonTreeItem &tree = root;
+    EXPECT_EQ(tree.value("Settings", "Width").toInt(), 640);
+    EXPECT_EQ(tree.value(JsonPath("Settings/Width")).toInt(), 640);
+    EXPECT_EQ(tree.value("Name").toString(), QString("const"));
+    EXPECT_EQ(tree.object().size(), 2);
+    EXPECT_TRUE(tree.array().isEmpty());
+
+    // Missing paths and other types are not created
+    EXPECT_FALSE(tree.value("Settings", "Height").isValid());
+    EXPECT_FALSE(tree.value("Name", "Width").isValid());
+    EXPECT_FALSE(tree.value("Settings").isValid());
+    EXPECT_EQ(tree.itemAt("Missing", "Width"), nullptr);
+    EXPECT_FALSE(root.contains("Settings", "Height"));
+    EXPECT_FALSE(root.contains("Missing"));
+    EXPECT_EQ(root.itemAt("Name")->type(), JsonTreeItem::Value);
+}
+
+TEST(JsonTreeItem, Clone)
+{
+    JsonTreeItem root;
+    root.setArenaEnabled(true);
+    ASSERT_TRUE(root.loadFromJson("{\"Name\": \"clone\", \"List\": [1, {\"Nested\": true}]}", nullptr,
+                                  JsonTreeItem::Lazy));
+    for (int i = 0; i < JsonTreeItem::IndexThreshold; ++i)
+        root.value("Wide", QString("key%1").arg(i)) = i;
+
+    JsonTreeItem *copy = root.clone();
+    EXPECT_TRUE(copy->isArenaEnabled());
+    EXPECT_TRUE(copy->itemAt("List")->isMaterialized());
+    EXPECT_EQ(copy->saveToJson(), root.saveToJson());
+
+    // The copy is independent of the original
+    root.value("Name") = "original";
+    EXPECT_EQ(copy->value("Name").toString(), QString("clone"));
+
+    const JsonTreeItem *constCopy = copy;
+    EXPECT_EQ(constCopy->value("Wide", "key7").toInt(), 7);
+    delete copy;
+}
+
+TEST(JsonTreeItem, Publisher)
+{
+    JsonTreePublisher publisher;
+    EXPECT_EQ(publisher.version(), 0u);
+    EXPECT_EQ(publisher.snapshot()->type(), JsonTreeItem::Object);
+
+    JsonTreeItem tree;
+    tree.value("Counter") = 0;
+    publisher.publish(tree);
+
+    // Readers see consistent snapshots, while the writer keeps publishing
+    QAtomicInt failures = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&publisher, &failures]() {
+            JsonTreeReader reader(&publisher);
+            int last = 0;
+            for (int i = 0; i < 20000; ++i) {
+                const JsonTreeItem *snapshot = reader.snapshot();
+                const int counter = snapshot->value("Counter").toInt();
+                if (counter < last || snapshot->value("Copy", "Counter").toInt() != counter)
+                    failures.fetchAndAddRelaxed(1);
+                last = counter;
+            }
+        });
+    }
+
+    for (int i = 1; i <= 200; ++i) {
+        tree.value("Counter") = i;
+        tree.value("Copy", "Counter") = i;
+        publisher.publish(tree);
+    }
+
+    for (std::thread &reader : readers)
+        reader.join();
+
+    EXPECT_EQ(failures.loadRelaxed(), 0);
+    EXPECT_EQ(publisher.version(), 201u);
+    EXPECT_EQ(publisher.snapshot()->value("Counter").toInt(), 200);
+}
+
+TEST(JsonTreeItem, Snapshot)
+{
+    JsonTreeItem root;
+    root.value("Settings", "Width") = 640;
+    root.value("Settings", "Height") = 480;
+    root.array("Other", "List") = QVector<JsonTreeItem *>();
+    root.value("Name") = "first";
+
+    const JsonSnapshot first = root.snapshot();
+    EXPECT_TRUE(root.snapshot().isSharedWith(first));
+    EXPECT_EQ(first.value("Settings", "Width").toInt(), 640);
+    EXPECT_EQ(first.value(JsonPath("Name")).toString(), QString("first"));
+    EXPECT_EQ(first.itemAt("Other", "List").type(), JsonTreeItem::Array);
+    EXPECT_TRUE(first.itemAt("Missing", "Width").isNull());
+    EXPECT_EQ(first.size(), 3);
+    EXPECT_EQ(first.keyAt(2), QString("Name"));
+
+    // Only the changed path gets new snapshot nodes
+    root.value("Settings", "Width") = 800;
+    root.value("Settings", "Depth") = 24;
+    const JsonSnapshot second = root.snapshot();
+    EXPECT_FALSE(second.isSharedWith(first));
+    EXPECT_FALSE(second.child("Settings").isSharedWith(first.child("Settings")));
+    EXPECT_TRUE(second.child("Other").isSharedWith(first.child("Other")));
+    EXPECT_TRUE(second.itemAt("Settings", "Height").isSharedWith(first.itemAt("Settings", "Height")));
+    EXPECT_EQ(first.value("Settings", "Width").toInt(), 640);
+    EXPECT_EQ(second.value("Settings", "Width").toInt(), 800);
+
+    // Restoring keeps the nodes of unchanged subtrees and of the same keys
+    JsonTreeItem *other = root.itemAt("Other");
+    JsonTreeItem *width = root.itemAt("Settings", "Width");
+    root.value("Name") = QVariant();
+    root.removeItem("Other");
+    root.restore(first);
+    EXPECT_TRUE(root.snapshot().isSharedWith(first));
+    EXPECT_EQ(root.itemAt("Settings", "Width"), width);
+    EXPECT_NE(root.itemAt("Other"), other);
+    EXPECT_EQ(root.value("Settings", "Width").toInt(), 640);
+    EXPECT_FALSE(root.contains("Settings", "Depth"));
+    EXPECT_EQ(root.value("Name").toString(), QString("first"));
+
+    JsonTreeItem copy;
+    copy.restore(second);
+    EXPECT_EQ(copy.value("Settings", "Depth").toInt(), 24);
+    root.restore(second);
+    EXPECT_EQ(root.saveToJson(), copy.saveToJson());
+
+    // Wide objects keep looking up the keys of the changed snapshots, also after a key is renamed
+    JsonTreeItem wide;
+    for (int i = 0; i < 2 * JsonTreeItem::IndexThreshold; ++i)
+        wide.value(QString("key%1").arg(i)) = i;
+    wide.snapshot();
+    wide.value("key3") = -3;
+    EXPECT_EQ(wide.snapshot().value("key3").toInt(), -3);
+    EXPECT_EQ(wide.snapshot().value("key30").toInt(), 30);
+    wide.itemAt("key30")->setKey("renamed");
+    const JsonSnapshot renamed = wide.snapshot();
+    EXPECT_EQ(renamed.value("renamed").toInt(), 30);
+    EXPECT_TRUE(renamed.child("key30").isNull());
+    EXPECT_EQ(renamed.value("key3").toInt(), -3);
+
+    // References, which are kept across a snapshot, are compared with the last snapshot
+    QVariant &height = root.value("Settings", "Height");
+    const JsonSnapshot beforeReference = root.snapshot();
+    EXPECT_TRUE(root.snapshot().isSharedWith(beforeReference));
+    height = 1080;
+    const JsonSnapshot afterReference = root.snapshot();
+    EXPECT_EQ(afterReference.value("Settings", "Height").toInt(), 1080);
+    EXPECT_EQ(beforeReference.value("Settings", "Height").toInt(), 480);
+    EXPECT_TRUE(afterReference.child("Other").isSharedWith(beforeReference.child("Other")));
+    height = 1080.;
+    EXPECT_FALSE(root.snapshot().isSharedWith(afterReference));
+}
+
+TEST(JsonTreeItem, KeyInterning)
+{
+    JsonTreeItem root;
+    root.value("Before", "port") = 80;
+    root.setKeyInterningEnabled(true);
+    EXPECT_TRUE(root.isKeyInterningEnabled());
+    EXPECT_EQ(root.value("Before", "port").toInt(), 80);
+
+    root.loadFromJson("[{\"host\": \"a\", \"port\": 1}, {\"port\": 2, \"host\": \"b\", \"port\": 3}]");
+    ASSERT_EQ(root.array().size(), 2);
+    JsonTreeItem *first = root.array().at(0);
+    JsonTreeItem *second = root.array().at(1);
+    EXPECT_EQ(first->value("port").toInt(), 1);
+    EXPECT_EQ(second->value("port").toInt(), 3);
+    EXPECT_EQ(second->value("host").toString(), QString("b"));
+    EXPECT_FALSE(first->contains("weight"));
+
+    // Renamed keys are interned again
+    first->itemAt("host")->setKey("name");
+    EXPECT_FALSE(first->contains("host"));
+    EXPECT_EQ(first->value("name").toString(), QString("a"));
+    second->value("name") = "c";
+    EXPECT_EQ(second->object().size(), 3);
+
+    // Nodes, which have been added to the vector directly, are not interned, but still found
+    JsonTreeItem *direct = new JsonTreeItem;
+    direct->setKey("weight");
+    direct->value() = 0.5;
+    first->object().push_back(direct);
+    EXPECT_EQ(first->value("weight").toDouble(), 0.5);
+
+    JsonTreeItem *copy = root.clone();
+    EXPECT_TRUE(copy->isKeyInterningEnabled());
+    EXPECT_EQ(copy->saveToJson(), root.saveToJson());
+    delete copy;
+
+    root.setKeyInterningEnabled(false);
+    EXPECT_EQ(first->value("name").toString(), QString("a"));
+    EXPECT_EQ(second->value("port").toInt(), 3);
+}
+
+TEST(JsonTreeItem, ParallelLoad)
+{
+    // Large arrays at the top level and nested in an object, and a duplicate key in the split part
+    QByteArray json = "{\"config\": {\"name\": \"x\", \"name\": \"y\"}, \"records\": [";
+    for (int i = 0; i < 4000; ++i) {
+        if (i > 0)
+            json += ", ";
+        json += "{\"host\": \"server" + QByteArray::number(i) + "\", \"port\": " + QByteArray::number(i) +
+                ", \"tags\": [\"a\", {\"zone\": " + QByteArray::number(i % 7) + "}]}";
+    }
+    json += "], \"groups\": {\"main\": [";
+    for (int i = 0; i < 4000; ++i)
+        json += (i > 0 ? ", [" : "[") + QByteArray::number(i) + ", \"item\\u0041\", null, true]";
+    json += "]}, \"records\": []}";
+    ASSERT_GT(json.size(), JsonParallelLoader::MinParallelSize);
+
+    JsonTreeItem eager;
+    ASSERT_TRUE(eager.loadFromJson(json));
+
+    QThreadPool *pool = QThreadPool::globalInstance();
+    const int threads = pool->maxThreadCount();
+    pool->setMaxThreadCount(4);
+
+    for (int variant = 0; variant < 3; ++variant) {
+        JsonTreeItem root;
+        root.setArenaEnabled(variant == 1);
+        root.setKeyInterningEnabled(variant == 2);
+        ASSERT_TRUE(root.loadFromJson(json, nullptr, JsonTreeItem::Parallel));
+        EXPECT_EQ(root.saveToJson(), eager.saveToJson());
+        EXPECT_EQ(root.value("config", "name").toString(), QString("y"));
+
+        // The parsed subtrees are linked to their parents
+        const JsonTreeItem &constRoot = root;
+        ASSERT_EQ(constRoot.itemAt("groups", "main")->array().size(), 4000);
+        JsonTreeItem *element = root.itemAt("groups", "main")->array().at(1234)->array().at(0);
+        root.saveToJson();
+        EXPECT_FALSE(root.isDirty());
+        element->value() = -1;
+        EXPECT_TRUE(root.isDirty());
+    }
+
+    // Errors are reported like by the sequential parser and leave the tree empty
+    const QByteArray invalid = json.left(json.size() / 2) + "]";
+    JsonParseError parallelError;
+    JsonParseError eagerError;
+    JsonTreeItem root;
+    EXPECT_FALSE(root.loadFromJson(invalid, &parallelError, JsonTreeItem::Parallel));
+    EXPECT_FALSE(eager.loadFromJson(invalid, &eagerError));
+    EXPECT_EQ(parallelError.error, eagerError.error);
+    EXPECT_EQ(parallelError.offset, eagerError.offset);
+    EXPECT_TRUE(root.object().isEmpty());
+
+    pool->setMaxThreadCount(threads);
+}
+
+TEST(JsonTreeItem, SimdScanning)
+{
+    // Escapes and runs of backslashes at the boundaries of the 16, 32 and 64 byte blocks, brackets in
+    // strings, non-ASCII text and long runs of whitespace
+    QByteArray json = "{\"records\": [";
+    for (int i = 0; i < 300; ++i) {
+        if (i > 0)
+            json += ",";
+        json += QByteArray(i % 67, ' ') + "{\"name\": \"" + QByteArray(i % 61, 'x') + QByteArray(i % 5 * 2, '\\') +
+                "\\\"]}\", \"text\": \"Gr\xc3\xbc\xc3\x9f""e \xe2\x82\xac \xf0\x9f\x98\x80 [{\\u00e4}]\", \"list\": [[], {}, \"}\", " +
+                QByteArray::number(i) + "]}";
+    }
+    json += "]}";
+
+    const JsonSimd::Level level = JsonSimd::level();
+
+    JsonSimd::setLevel(JsonSimd::Scalar);
+    JsonTreeItem reference;
+    ASSERT_TRUE(reference.loadFromJson(json));
+    ASSERT_EQ(reference.itemAt("records")->array().size(), 300);
+    EXPECT_EQ(reference.itemAt("records")->array().at(1)->value("text").toString(),
+              QString::fromUtf8("Gr\xc3\xbc\xc3\x9f""e \xe2\x82\xac \xf0\x9f\x98\x80 [{\xc3\xa4}]"));
+    const QByteArray expected = reference.saveToJson();
+
+    // The strings of invalid UTF-8 are rejected at the same position by all modes
+    const QByteArray invalid = "{\"a\": [\"ok\", {\"b\": \"\xc3\xa4\xe2\x82\"}]}";
+
+    for (int l = JsonSimd::Scalar; l <= JsonSimd::supportedLevel(); ++l) {
+        JsonSimd::setLevel(static_cast<JsonSimd::Level>(l));
+        ASSERT_EQ(JsonSimd::level(), l);
+
+        JsonTreeItem eager;
+        ASSERT_TRUE(eager.loadFromJson(json));
+        EXPECT_EQ(eager.saveToJson(), expected);
+
+        JsonTreeItem lazy;
+        ASSERT_TRUE(lazy.loadFromJson(json, nullptr, JsonTreeItem::Lazy));
+        JsonTreeItem *copy = lazy.clone();
+        EXPECT_EQ(copy->saveToJson(), expected);
+        delete copy;
+
+        JsonTreeItem parallel;
+        ASSERT_TRUE(parallel.loadFromJson(json, nullptr, JsonTreeItem::Parallel));
+        EXPECT_EQ(parallel.saveToJson(), expected);
+
+        JsonParseError eagerError;
+        JsonParseError lazyError;
+        EXPECT_FALSE(eager.loadFromJson(invalid, &eagerError));
+        EXPECT_FALSE(lazy.loadFromJson(invalid, &lazyError, JsonTreeItem::Lazy));
+        EXPECT_EQ(eagerError.error, JsonParseError::InvalidUtf8);
+        EXPECT_EQ(eagerError.offset, invalid.indexOf('\xe2'));
+        EXPECT_EQ(lazyError.error, eagerError.error);
+        EXPECT_EQ(lazyError.offset, eagerError.offset);
+    }
+
+    JsonSimd::setLevel(level);
+}
+
+TEST(JsonTreeItem, Update)
+{
+    JsonTreeItem root;
+    ASSERT_TRUE(root.loadFromJson("{\"a\": {\"x\": 1, \"y\": \"text\"}, \"list\": [1, 2, 3], \"b\": true, \"gone\": 0}"));
+    root.saveToJson();
+
+    QVariant &x = root.value("a", "x");
+    QVariant &y = root.value("a", "y");
+    JsonTreeItem *list = root.itemAt("list");
+    root.saveToJson();
+
+    JsonTreeItem reloaded;
+    ASSERT_TRUE(reloaded.loadFromJson("{\"a\": {\"x\": 2, \"y\": \"text\"}, \"list\": [1, 2], \"b\": 1, \"new\": [null]}"));
+
+    QVector<JsonPath> changedPaths;
+    EXPECT_TRUE(root.update(reloaded, &changedPaths));
+    EXPECT_EQ(root.saveToJson(), reloaded.saveToJson());
+
+    // Values are changed in place and only the changed nodes are reported, true and 1 differ
+    EXPECT_EQ(&root.value("a", "x"), &x);
+    EXPECT_EQ(&root.value("a", "y"), &y);
+    EXPECT_EQ(x.toInt(), 2);
+    EXPECT_EQ(root.itemAt("list"), list);
+
+    QStringList paths;
+    for (const JsonPath &path : qAsConst(changedPaths))
+        paths.push_back(path.toString());
+    EXPECT_EQ(paths, QStringList({"a/x", "list/2", "b", "new", "gone"}));
+
+    // Applying the same document again does not change or dirty anything
+    root.saveToJson();
+    changedPaths.clear();
+    EXPECT_FALSE(root.update(reloaded, &changedPaths));
+    EXPECT_TRUE(changedPaths.isEmpty());
+    EXPECT_FALSE(root.isDirty());
+
+    // Between two lazily loaded versions only the subtrees with a different text are parsed
+    const QByteArray previousJson = reloaded.saveToJson();
+    JsonTreeItem previous;
+    JsonTreeItem next;
+    ASSERT_TRUE(previous.loadFromJson(previousJson, nullptr, JsonTreeItem::Lazy));
+    QByteArray nextJson = previousJson;
+    ASSERT_TRUE(next.loadFromJson(nextJson.replace("\"x\": 2", "\"x\": 3"), nullptr, JsonTreeItem::Lazy));
+
+    // Local changes in the subtrees, which are the same in both versions, are kept
+    root.value("new") = "local";
+    changedPaths.clear();
+    EXPECT_TRUE(root.update(previous, next, &changedPaths));
+    EXPECT_EQ(changedPaths, QVector<JsonPath>({JsonPath("a/x")}));
+    EXPECT_EQ(x.toInt(), 3);
+    EXPECT_EQ(root.value("new").toString(), QString("local"));
+    EXPECT_FALSE(next.itemAt("list")->isMaterialized());
+}
+
+TEST(JsonTreeItem, FileWatcher)
+{
+    const QString filename = "test_watch.json";
+    auto writeFile = [&filename](const QByteArray &json) {
+        QFile file(filename);
+        ASSERT_TRUE(file.open(QFile::WriteOnly));
+        file.write(json);
+    };
+    writeFile("{\"servers\": [{\"port\": 80}, {\"port\": 81}], \"log\": {\"level\": 1}}");
+
+    JsonTreeItem root;
+    JsonFileWatcher watcher(&root, filename);
+
+    QVector<JsonPath> serverChanges;
+    int logCalls = 0;
+    watcher.addCallback(JsonPath("servers"), [&serverChanges](const QVector<JsonPath> &paths) { serverChanges += paths; });
+    const int logId = watcher.addCallback(JsonPath("log/level"), [&logCalls](const QVector<JsonPath> &) { ++logCalls; });
+
+    ASSERT_TRUE(watcher.reload());
+    EXPECT_EQ(root.value("log", "level").toInt(), 1);
+    EXPECT_EQ(serverChanges.size(), 1);
+    EXPECT_EQ(logCalls, 1);
+
+    // A changed value is reported once to the callback of its region
+    QVariant &level = root.value("log", "level");
+    serverChanges.clear();
+    writeFile("{\"servers\": [{\"port\": 80}, {\"port\": 8081}], \"log\": {\"level\": 1}}");
+    ASSERT_TRUE(watcher.reload());
+    ASSERT_EQ(serverChanges.size(), 1);
+    EXPECT_EQ(serverChanges.first(), JsonPath(QStringList({"servers", "1", "port"})));
+    EXPECT_EQ(logCalls, 1);
+    EXPECT_EQ(&root.value("log", "level"), &level);
+
+    // An invalid document leaves the tree unchanged
+    writeFile("{\"log\": {\"level\": }");
+    JsonParseError error;
+    EXPECT_FALSE(watcher.reload(&error));
+    EXPECT_EQ(error.error, JsonParseError::UnexpectedCharacter);
+    EXPECT_EQ(watcher.lastError().error, JsonParseError::UnexpectedCharacter);
+    EXPECT_EQ(root.array("servers").at(1)->value("port").toInt(), 8081);
+
+    watcher.removeCallback(logId);
+    writeFile("{\"servers\": [], \"log\": {\"level\": 2}}");
+    ASSERT_TRUE(watcher.reload());
+    EXPECT_EQ(level.toInt(), 2);
+    EXPECT_EQ(logCalls, 1);
+    EXPECT_EQ(serverChanges.size(), 3);
+
+    QFile::remove(filename);
+}
+
+#ifdef JSONCONFIG_STATS
+TEST(JsonTreeItem, Stats)
+{
+    const QByteArray json = "{\"a\": 1, \"b\": {\"c\": [1, 2, 3]}, \"d\": \"text\"}";
+
+    JsonTreeItem root;
+    ASSERT_TRUE(root.loadFromJson(json));
+
+    JsonTreeStats stats = root.stats();
+    EXPECT_EQ(stats.objectNodes, 2);
+    EXPECT_EQ(stats.arrayNodes, 1);
+    EXPECT_EQ(stats.valueNodes, 5);
+    EXPECT_EQ(stats.nodes(), 8);
+    EXPECT_GE(stats.bytes, qint64(8 * sizeof(JsonTreeItem)));
+    EXPECT_EQ(stats.maxDepth, 3);
+    EXPECT_EQ(stats.maxFanOut, 3);
+    ASSERT_EQ(stats.largestSubtrees.size(), 3);
+    EXPECT_EQ(stats.largestSubtrees.first().key, "b");
+    EXPECT_EQ(stats.largestSubtrees.first().nodes, 5);
+    EXPECT_EQ(stats.phases[JsonTreeStats::Parse].count, 1);
+    EXPECT_EQ(stats.phases[JsonTreeStats::Parse].bytes, json.size());
+
+    // The lookup of a missing key scans all keys, the missing object and value are created
+    root.resetStats();
+    const JsonTreeItem &constRoot = root;
+    EXPECT_EQ(constRoot.value("d").toString(), "text");
+    root.value("x", "y") = 1;
+    stats = root.stats();
+    EXPECT_EQ(stats.lookups, 3);
+    EXPECT_EQ(stats.indexedLookups, 0);
+    EXPECT_EQ(stats.scannedNodes, 6);
+    EXPECT_DOUBLE_EQ(stats.averageScanLength(), 2.);
+    EXPECT_EQ(stats.createdNodes, 2);
+    EXPECT_EQ(stats.retypedNodes, 0);
+    EXPECT_EQ(stats.phases[JsonTreeStats::Parse].count, 0);
+
+    // A value on an object path is replaced by an object
+    root.value("a", "z") = 2;
+    EXPECT_EQ(root.stats().retypedNodes, 1);
+
+    const QByteArray saved = root.saveToJson();
+    stats = root.stats();
+    EXPECT_EQ(stats.phases[JsonTreeStats::Export].count, 1);
+    EXPECT_EQ(stats.phases[JsonTreeStats::Export].bytes, saved.size());
+
+    JsonTreeItem report;
+    ASSERT_TRUE(report.loadFromJson(stats.toJson()));
+    EXPECT_EQ(report.value("nodes", "total").toInt(), stats.nodes());
+    EXPECT_EQ(report.value("lookups", "createdNodes").toInt(), 3);
+    EXPECT_EQ(report.value("phases/export", "count").toInt(), 1);
+    EXPECT_EQ(report.itemAt("largestSubtrees")->array().size(), 4);
+
+    // Lazy nodes are counted with their source text, materializing them is part of parsing
+    JsonTreeItem lazy;
+    ASSERT_TRUE(lazy.loadFromJson(json, nullptr, JsonTreeItem::Lazy));
+    stats = lazy.stats();
+    EXPECT_GE(stats.lazyNodes, 1);
+    EXPECT_GT(stats.lazySourceBytes, 0);
+    EXPECT_EQ(lazy.itemAt("b", "c")->array().size(), 3);
+    stats = lazy.stats();
+    EXPECT_EQ(stats.lazyNodes, 0);
+    EXPECT_EQ(stats.nodes(), 8);
+    EXPECT_GT(stats.phases[JsonTreeStats::Parse].count, 1);
+
+    // Const lookups do not create the state of a tree, copies get one right away
+    std::unique_ptr<JsonTreeItem> detached = root.takeItem("b");
+    const JsonTreeItem &constDetached = *detached;
+    EXPECT_EQ(constDetached.itemAt("c")->array().size(), 3);
+    EXPECT_EQ(constDetached.stats().lookups, 0);
+
+    std::unique_ptr<JsonTreeItem> copy(constRoot.clone());
+    const JsonTreeItem &constCopy = *copy;
+    EXPECT_EQ(constCopy.value("d").toString(), "text");
+    EXPECT_EQ(constCopy.stats().lookups, 1);
+}
+#endif
+
+TEST(JsonTreeItem, TakeAndInsertItem)
+{
+    const QByteArray json = "{\"section\": {\"x\": 1, \"list\": [1, {\"y\": 2}]}, \"other\": 3}";
+
+    // The nodes are moved without copying, also between trees with key pools
+    JsonTreeItem source;
+    source.setKeyInterningEnabled(true);
+    ASSERT_TRUE(source.loadFromJson(json));
+    JsonTreeItem *section = source.itemAt("section");
+
+    JsonTreeItem target;
+    ASSERT_TRUE(target.loadFromJson("{\"a\": true}"));
+    target.saveToJson(JsonTreeItem::Compact);
+
+    std::unique_ptr<JsonTreeItem> item = source.takeItem("section");
+    ASSERT_EQ(item.get(), section);
+    EXPECT_FALSE(source.contains("section"));
+    EXPECT_EQ(source.takeItem("section"), nullptr);
+    EXPECT_EQ(source.saveToJson(JsonTreeItem::Compact), "{\"other\":3}");
+
+    EXPECT_EQ(target.insertItem(JsonPath("moved/section"), std::move(item)), section);
+    EXPECT_EQ(target.value("moved/section", "x").toInt(), 1);
+    EXPECT_EQ(target.saveToJson(JsonTreeItem::Compact), "{\"a\":true,\"moved\":{\"section\":{\"x\":1,\"list\":[1,{\"y\":2}]}}}");
+
+    // A node with the same key is replaced in its position
+    target.insertItem("a", target.takeItem("moved", "section"));
+    EXPECT_EQ(target.saveToJson(JsonTreeItem::Compact), "{\"a\":{\"x\":1,\"list\":[1,{\"y\":2}]},\"moved\":{}}");
+
+    // Lazy nodes take their source along, so they outlive the tree they have been loaded in
+    std::unique_ptr<JsonTreeItem> lazy(new JsonTreeItem);
+    ASSERT_TRUE(lazy->loadFromJson(json, nullptr, JsonTreeItem::Lazy));
+    item = lazy->takeItem("section");
+    lazy.reset();
+    EXPECT_FALSE(item->isMaterialized());
+
+    JsonTreeItem lazyTarget;
+    lazyTarget.insertItem("section", std::move(item));
+    EXPECT_EQ(lazyTarget.saveToJson(JsonTreeItem::Compact), "{\"section\":{\"x\":1,\"list\":[1,{\"y\":2}]}}");
+    EXPECT_EQ(static_cast<const JsonTreeItem &>(lazyTarget).itemAt("section", "list")->array().size(), 2);
+
+    // Nodes of an arena are copied, as the arena is released with its tree
+    JsonTreeItem arena;
+    arena.setArenaEnabled(true);
+    ASSERT_TRUE(arena.loadFromJson(json));
+    item = arena.takeItem("section");
+    arena.clear();
+    ASSERT_TRUE(item);
+    EXPECT_EQ(item->value("x").toInt(), 1);
+
+    JsonTreeItem arenaTarget;
+    arenaTarget.setArenaEnabled(true);
+    arenaTarget.insertItem("section", std::move(item));
+    EXPECT_EQ(arenaTarget.saveToJson(JsonTreeItem::Compact), "{\"section\":{\"x\":1,\"list\":[1,{\"y\":2}]}}");
+}
+
+TEST(JsonTreeItem, Query)
+{
+    JsonTreeItem root;
+    ASSERT_TRUE(root.loadFromJson("{\"servers\": [{\"host\": \"a\", \"port\": 80}, {\"host\": \"b\"}, {\"host\": \"c\", \"port\": 8080}], "
+                                  "\"Components\": {\"C\": \"Capacitor\", \"R\": \"Resistor\", \"a/b\": 1}}"));
+    const JsonTreeItem &constRoot = root;
+
+    JsonQuery query;
+    EXPECT_EQ(query.addPath("servers/*/port"), 0);
+    EXPECT_EQ(query.addPath(JsonPath("Components", "R")), 1);
+    EXPECT_EQ(query.addPointer("/Components/a~1b"), 2);
+    EXPECT_EQ(query.addPointer("/servers/1/host"), 3);
+    EXPECT_EQ(query.addPath("Components/missing"), 4);
+    EXPECT_EQ(query.addPath("Components/*"), 5);
+    EXPECT_EQ(query.size(), 6);
+
+    EXPECT_EQ(query.values(constRoot), QVector<QVariant>({80, "Resistor", 1, "b", QVariant(), "Capacitor"}));
+
+    // Wildcards match every child and report what they have matched
+    QStringList ports;
+    QStringList components;
+    for (const JsonQuery::Match &match : query.match(constRoot)) {
+        if (match.path == 0)
+            ports.push_back(match.captures.first() + ":" + match.item->value().toString());
+        else if (match.path == 5)
+            components.push_back(match.captures.first());
+    }
+    EXPECT_EQ(ports, QStringList({"0:80", "2:8080"}));
+    EXPECT_EQ(components, QStringList({"C", "R", "a/b"}));
+
+    // Nothing is created
+    EXPECT_FALSE(root.contains("Components", "missing"));
+    EXPECT_EQ(root.itemAt("servers")->array().at(1)->object().size(), 1);
+}
+
+TEST(JsonTreeItem, Patch)
+{
+    const QByteArray json = "{\"name\": \"app\", \"servers\": [{\"host\": \"a\"}, {\"host\": \"b\"}, {\"host\": \"c\"}], "
+                            "\"limits\": {\"cpu\": 2, \"mem\": 4}, \"a/b~c\": 1}";
+    JsonTreeItem root;
+    ASSERT_TRUE(root.loadFromJson(json));
+    JsonTreeItem other;
+    ASSERT_TRUE(other.loadFromJson("{\"name\": \"app\", \"servers\": [{\"host\": \"a\"}, {\"host\": \"x\"}, {\"host\": \"b\"}, {\"host\": \"c\"}], "
+                                   "\"limits\": {\"mem\": 4, \"cpu\": 3}, \"enabled\": true}"));
+
+    // Equal subtrees are skipped, an inserted array element is a single operation
+    const JsonTreeItem &constOther = other;
+    const QByteArray patch = root.diff(constOther);
+    EXPECT_EQ(patch, "[{\"op\":\"add\",\"path\":\"/servers/1\",\"value\":{\"host\":\"x\"}},"
+                     "{\"op\":\"replace\",\"path\":\"/limits/cpu\",\"value\":3},"
+                     "{\"op\":\"remove\",\"path\":\"/a~1b~0c\"},"
+                     "{\"op\":\"add\",\"path\":\"/enabled\",\"value\":true}]");
+    EXPECT_EQ(root.snapshot().child("name").hash(), other.snapshot().child("name").hash());
+
+    // A published tree is only read, so several threads can diff against it
+    JsonTreePublisher publisher;
+    publisher.publish(other);
+    const QSharedPointer<const JsonTreeItem> published = publisher.snapshot();
+    std::vector<std::thread> threads;
+    QByteArray patches[2];
+    for (int i = 0; i < 2; ++i) {
+        threads.emplace_back([&, i]() {
+            JsonTreeItem local;
+            local.loadFromJson(json);
+            patches[i] = local.diff(*published);
+        });
+    }
+    for (std::thread &thread : threads)
+        thread.join();
+    EXPECT_EQ(patches[0], patch);
+    EXPECT_EQ(patches[1], patch);
+
+    ASSERT_TRUE(root.applyPatch(patch));
+    EXPECT_EQ(root.diff(other), "[]");
+    EXPECT_TRUE(root.snapshot() == other.snapshot());
+    EXPECT_EQ(root.snapshot().child("servers").at(1).value("host"), "x");
+
+    // The snapshots of one tree share their unchanged nodes, the hashes of these are kept
+    const JsonSnapshot previous = root.snapshot();
+    root.value("limits", "mem") = 8;
+    EXPECT_EQ(JsonTreeItem::diff(previous, root.snapshot()), "[{\"op\":\"replace\",\"path\":\"/limits/mem\",\"value\":8}]");
+    EXPECT_TRUE(previous.child("servers").isSharedWith(root.snapshot().child("servers")));
+
+    // Keys are compared independent of their order, numbers by their value
+    EXPECT_EQ(previous.child("limits"), other.snapshot().child("limits"));
+    root.value("limits", "mem") = 4.0;
+    EXPECT_EQ(root.diff(other), "[]");
+
+    // All operations of RFC 6902
+    ASSERT_TRUE(root.applyPatch("[{\"op\": \"test\", \"path\": \"/limits\", \"value\": {\"cpu\": 3, \"mem\": 4}},"
+                                " {\"op\": \"move\", \"from\": \"/servers/0\", \"path\": \"/servers/-\"},"
+                                " {\"op\": \"copy\", \"from\": \"/limits\", \"path\": \"/defaults\"},"
+                                " {\"op\": \"replace\", \"path\": \"/defaults/cpu\", \"value\": [1, 2]},"
+                                " {\"op\": \"remove\", \"path\": \"/servers/1\"}]"));
+    EXPECT_EQ(root.saveToJson(JsonTreeItem::Compact),
+              "{\"name\":\"app\",\"servers\":[{\"host\":\"x\"},{\"host\":\"c\"},{\"host\":\"a\"}],"
+              "\"limits\":{\"cpu\":3,\"mem\":4},\"enabled\":true,\"defaults\":{\"cpu\":[1,2],\"mem\":4}}");
+
+    // A patch, which fails, leaves the tree unchanged
+    const QByteArray saved = root.saveToJson(JsonTreeItem::Compact);
+    EXPECT_FALSE(root.applyPatch("[{\"op\": \"remove\", \"path\": \"/defaults\"}, {\"op\": \"test\", \"path\": \"/name\", \"value\": \"other\"}]"));
+    EXPECT_FALSE(root.applyPatch("[{\"op\": \"add\", \"path\": \"/servers/5\", \"value\": 1}]"));
+    EXPECT_FALSE(root.applyPatch("[{\"op\": \"move\", \"from\": \"/limits\", \"path\": \"/limits/inner\"}]"));
+    EXPECT_FALSE(root.applyPatch("[{\"op\": \"remove\", \"path\": \"/name~2\"}]"));
+    EXPECT_FALSE(root.applyPatch("{\"op\": \"remove\", \"path\": \"/name\"}"));
+    EXPECT_EQ(root.saveToJson(JsonTreeItem::Compact), saved);
+
+    // A tree, which has been patched with the diff, equals the other tree
+    JsonTreeItem copy;
+    ASSERT_TRUE(copy.loadFromJson(json));
+    ASSERT_TRUE(copy.applyPatch(copy.diff(root)));
+    EXPECT_EQ(copy.saveToJson(JsonTreeItem::Compact), saved);
+}
+
+#endif // TEST_JSONTREEITEM_H